@@ -0,0 +1,173 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic.loadgen;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.incubator.codec.quic.QuicChannel;
+import io.netty.incubator.codec.quic.QuicStreamChannel;
+import io.netty.incubator.codec.quic.QuicStreamType;
+import io.netty.util.concurrent.Future;
+
+import java.util.concurrent.ThreadLocalRandom;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * One client connection of the {@link QuicLoadGenerator}. Requests are sent at the times of a poisson process,
+ * without waiting for the previous response (open-loop). The latency of a request is measured from the time it was
+ * meant to be sent, so a stalled event loop can't hide latency by delaying the requests (coordinated omission).
+ *
+ * All methods are called from the {@link io.netty.channel.EventLoop} of the {@link QuicChannel}.
+ */
+final class LoadConnection {
+    private final QuicChannel channel;
+    private final LoadStatistics statistics;
+    private final ByteBuf message;
+    private final int messageSize;
+    private final long meanIntervalNanos;
+    private final StreamHandler[] streams;
+    private volatile boolean running = true;
+    private long nextRequestNanos;
+    private int nextStream;
+
+    LoadConnection(QuicChannel channel, LoadStatistics statistics, ByteBuf message, int streams,
+                   double requestRate) {
+        this.channel = channel;
+        this.statistics = statistics;
+        this.message = message;
+        this.messageSize = message.readableBytes();
+        this.meanIntervalNanos = requestRate == 0 ? 0 : (long) (TimeUnit.SECONDS.toNanos(1) / requestRate);
+        this.streams = new StreamHandler[streams];
+    }
+
+    /**
+     * Open all streams and start sending requests.
+     */
+    void start() {
+        channel.eventLoop().execute(() -> {
+            for (int i = 0; i < streams.length; i++) {
+                StreamHandler handler = new StreamHandler();
+                streams[i] = handler;
+                Future<QuicStreamChannel> future = channel.createStream(QuicStreamType.BIDIRECTIONAL, handler);
+                future.addListener(f -> {
+                    if (f.isSuccess()) {
+                        handler.stream = future.getNow();
+                    } else {
+                        statistics.error();
+                    }
+                });
+            }
+            if (meanIntervalNanos > 0) {
+                nextRequestNanos = System.nanoTime();
+                scheduleNextRequest();
+            }
+        });
+    }
+
+    /**
+     * Stop sending requests and close the connection.
+     */
+    Future<Void> stop() {
+        running = false;
+        return channel.close();
+    }
+
+    boolean isActive() {
+        return channel.isActive();
+    }
+
+    private void scheduleNextRequest() {
+        // Exponentially distributed inter-arrival times.
+        double random = ThreadLocalRandom.current().nextDouble();
+        nextRequestNanos += (long) (-Math.log(1 - random) * meanIntervalNanos);
+        long delay = nextRequestNanos - System.nanoTime();
+        channel.eventLoop().schedule(this::sendRequest, Math.max(0, delay), TimeUnit.NANOSECONDS);
+    }
+
+    private void sendRequest() {
+        if (!running || !channel.isActive()) {
+            return;
+        }
+        StreamHandler handler = streams[nextStream];
+        nextStream = (nextStream + 1) % streams.length;
+        if (handler.stream == null || !handler.stream.isActive()) {
+            statistics.error();
+        } else {
+            handler.pending.add(nextRequestNanos);
+            handler.stream.writeAndFlush(message.duplicate());
+        }
+        scheduleNextRequest();
+    }
+
+    private final class StreamHandler extends ChannelInboundHandlerAdapter {
+        final LongQueue pending = new LongQueue();
+        QuicStreamChannel stream;
+        private long received;
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ByteBuf buffer = (ByteBuf) msg;
+            received += buffer.readableBytes();
+            buffer.release();
+            if (received >= messageSize) {
+                long now = System.nanoTime();
+                while (received >= messageSize && !pending.isEmpty()) {
+                    received -= messageSize;
+                    statistics.requestDone(now - pending.poll(), messageSize);
+                }
+            }
+        }
+
+        @Override
+        public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+            statistics.error();
+            ctx.close();
+        }
+    }
+
+    // FIFO of the intended send times of the requests of a stream, which does not box the values.
+    private static final class LongQueue {
+        private long[] values = new long[16];
+        private int head;
+        private int size;
+
+        void add(long value) {
+            if (size == values.length) {
+                long[] newValues = new long[values.length << 1];
+                for (int i = 0; i < size; i++) {
+                    newValues[i] = values[(head + i) % values.length];
+                }
+                values = newValues;
+                head = 0;
+            }
+            values[(head + size) % values.length] = value;
+            size++;
+        }
+
+        long poll() {
+            assert size > 0;
+            long value = values[head];
+            head = (head + 1) % values.length;
+            size--;
+            return value;
+        }
+
+        boolean isEmpty() {
+            return size == 0;
+        }
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic.loadgen;
+
+import io.netty.util.NettyRuntime;
+
+import java.util.Locale;
+
+/**
+ * The settings of a {@link QuicLoadGenerator} run, which are given as {@code -name=value} arguments.
+ */
+final class LoadGeneratorConfig {
+    // The number of connections that are opened in total.
+    int connections = 10000;
+    // The number of new connections per second during the ramp-up.
+    int connectRate = 1000;
+    // The number of bidirectional streams each connection opens, requests are spread over these round-robin.
+    int streams = 1;
+    // The size of each request and its echo in bytes.
+    int messageSize = 128;
+    // The mean number of requests per second and connection. Requests arrive in a poisson process, independent of
+    // the responses (open-loop), so a slow server shows up as latency and not as a lower request rate.
+    double requestRate = 1;
+    // The time in seconds for which requests are sent once all connections were opened.
+    int duration = 60;
+    // The time in seconds between two reports.
+    int reportInterval = 5;
+    int serverThreads = Math.max(1, NettyRuntime.availableProcessors() / 2);
+    int clientThreads = Math.max(1, NettyRuntime.availableProcessors() / 2);
+    int port = 9999;
+    long idleTimeout = 30000;
+    // If the server and client codecs pace their packets.
+    boolean pacing;
+    // If set the interval histograms of the request latency are written to this file in the HdrHistogram log
+    // format, which allows to analyze long soak runs afterwards.
+    String histogramLog;
+
+    static LoadGeneratorConfig parse(String[] args) {
+        LoadGeneratorConfig config = new LoadGeneratorConfig();
+        for (String arg: args) {
+            if (!arg.startsWith("-") || arg.indexOf('=') == -1) {
+                throw new IllegalArgumentException("Invalid argument: " + arg + " (expected: -name=value)");
+            }
+            int idx = arg.indexOf('=');
+            String name = arg.substring(arg.charAt(1) == '-' ? 2 : 1, idx);
+            String value = arg.substring(idx + 1);
+            switch (name.toLowerCase(Locale.ROOT)) {
+                case "connections":
+                    config.connections = positive(name, Integer.parseInt(value));
+                    break;
+                case "connectrate":
+                    config.connectRate = positive(name, Integer.parseInt(value));
+                    break;
+                case "streams":
+                    config.streams = positive(name, Integer.parseInt(value));
+                    break;
+                case "messagesize":
+                    config.messageSize = positive(name, Integer.parseInt(value));
+                    break;
+                case "requestrate":
+                    config.requestRate = Double.parseDouble(value);
+                    if (config.requestRate < 0) {
+                        throw new IllegalArgumentException(name + ": " + value + " (expected: >= 0)");
+                    }
+                    break;
+                case "duration":
+                    config.duration = positive(name, Integer.parseInt(value));
+                    break;
+                case "reportinterval":
+                    config.reportInterval = positive(name, Integer.parseInt(value));
+                    break;
+                case "serverthreads":
+                    config.serverThreads = positive(name, Integer.parseInt(value));
+                    break;
+                case "clientthreads":
+                    config.clientThreads = positive(name, Integer.parseInt(value));
+                    break;
+                case "port":
+                    config.port = Integer.parseInt(value);
+                    break;
+                case "idletimeout":
+                    config.idleTimeout = positive(name, Integer.parseInt(value));
+                    break;
+                case "pacing":
+                    config.pacing = Boolean.parseBoolean(value);
+                    break;
+                case "histogramlog":
+                    config.histogramLog = value;
+                    break;
+                default:
+                    throw new IllegalArgumentException("Unknown argument: " + name);
+            }
+        }
+        return config;
+    }
+
+    static String usage() {
+        return "Usage: java -jar loadgen.jar [-name=value...]\n" +
+                "  -connections=<n>      connections to open in total (default: 10000)\n" +
+                "  -connectRate=<n>      new connections per second (default: 1000)\n" +
+                "  -streams=<n>          streams per connection (default: 1)\n" +
+                "  -messageSize=<bytes>  size of each request / response (default: 128)\n" +
+                "  -requestRate=<n>      mean requests per second and connection, open-loop (default: 1)\n" +
+                "  -duration=<seconds>   time to send requests once all connections are open (default: 60)\n" +
+                "  -reportInterval=<s>   seconds between two reports (default: 5)\n" +
+                "  -serverThreads=<n>    server shards / event loops (default: cores / 2)\n" +
+                "  -clientThreads=<n>    client channels / event loops (default: cores / 2)\n" +
+                "  -port=<port>          UDP port of the server on loopback (default: 9999)\n" +
+                "  -idleTimeout=<ms>     QUIC max idle timeout (default: 30000)\n" +
+                "  -pacing=<true|false>  pace the packets of all connections (default: false)\n" +
+                "  -histogramLog=<file>  write the interval latency histograms to this file\n";
+    }
+
+    private static int positive(String name, int value) {
+        if (value <= 0) {
+            throw new IllegalArgumentException(name + ": " + value + " (expected: > 0)");
+        }
+        return value;
+    }
+
+    @Override
+    public String toString() {
+        return "connections=" + connections + ", connectRate=" + connectRate + "/s, streams=" + streams +
+                ", messageSize=" + messageSize + ", requestRate=" + requestRate + "/s, duration=" + duration +
+                "s, serverThreads=" + serverThreads + ", clientThreads=" + clientThreads +
+                ", pacing=" + pacing;
+    }
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic.loadgen;
+
+import io.netty.buffer.PooledByteBufAllocator;
+import io.netty.util.internal.PlatformDependent;
+import org.HdrHistogram.Histogram;
+import org.HdrHistogram.HistogramLogWriter;
+import org.HdrHistogram.Recorder;
+
+import java.io.FileNotFoundException;
+import java.io.PrintStream;
+import java.lang.management.BufferPoolMXBean;
+import java.lang.management.GarbageCollectorMXBean;
+import java.lang.management.ManagementFactory;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.LongAdder;
+
+/**
+ * Collects the statistics of a {@link QuicLoadGenerator} run. Latencies are recorded into HdrHistogram
+ * {@link Recorder}s from the event loops and reported per interval together with the GC activity and direct memory
+ * usage, and as a total at the end of the run.
+ */
+final class LoadStatistics {
+    // Track latencies of up to one minute with 3 significant digits.
+    private static final long MAX_LATENCY_NANOS = TimeUnit.MINUTES.toNanos(1);
+
+    private final Recorder handshakeRecorder = new Recorder(MAX_LATENCY_NANOS, 3);
+    private final Recorder requestRecorder = new Recorder(MAX_LATENCY_NANOS, 3);
+    private final Histogram totalHandshakes = new Histogram(MAX_LATENCY_NANOS, 3);
+    private final Histogram totalRequests = new Histogram(MAX_LATENCY_NANOS, 3);
+    private final LongAdder bytes = new LongAdder();
+    private final LongAdder errors = new LongAdder();
+    private final List<GarbageCollectorMXBean> gcs = ManagementFactory.getGarbageCollectorMXBeans();
+    private final BufferPoolMXBean directPool = directPool();
+    private final PrintStream out;
+    private final HistogramLogWriter logWriter;
+    private final long startNanos = System.nanoTime();
+
+    private Histogram handshakeInterval;
+    private Histogram requestInterval;
+    private long lastReportNanos = startNanos;
+    private long lastGcCount;
+    private long lastGcMillis;
+
+    LoadStatistics(PrintStream out, String histogramLog) throws FileNotFoundException {
+        this.out = out;
+        if (histogramLog == null) {
+            logWriter = null;
+        } else {
+            logWriter = new HistogramLogWriter(histogramLog);
+            logWriter.outputLogFormatVersion();
+            logWriter.outputStartTime(System.currentTimeMillis());
+            logWriter.setBaseTime(System.currentTimeMillis());
+            logWriter.outputLegend();
+        }
+    }
+
+    void handshakeDone(long latencyNanos) {
+        handshakeRecorder.recordValue(Math.min(latencyNanos, MAX_LATENCY_NANOS));
+    }
+
+    void requestDone(long latencyNanos, int messageSize) {
+        requestRecorder.recordValue(Math.min(latencyNanos, MAX_LATENCY_NANOS));
+        // The request and the echo.
+        bytes.add(2L * messageSize);
+    }
+
+    void error() {
+        errors.increment();
+    }
+
+    /**
+     * Print the statistics of the interval since the last report.
+     */
+    synchronized void report(int openConnections) {
+        long now = System.nanoTime();
+        double seconds = (now - lastReportNanos) / 1e9;
+        lastReportNanos = now;
+
+        handshakeInterval = handshakeRecorder.getIntervalHistogram(handshakeInterval);
+        requestInterval = requestRecorder.getIntervalHistogram(requestInterval);
+        totalHandshakes.add(handshakeInterval);
+        totalRequests.add(requestInterval);
+        if (logWriter != null) {
+            logWriter.outputIntervalHistogram(requestInterval);
+        }
+
+        long gcCount = 0;
+        long gcMillis = 0;
+        for (GarbageCollectorMXBean gc: gcs) {
+            gcCount += Math.max(0, gc.getCollectionCount());
+            gcMillis += Math.max(0, gc.getCollectionTime());
+        }
+
+        out.printf("[%6.0fs] conns=%d handshakes=%.0f/s (p99 %s) requests=%.0f/s throughput=%.2f MiB/s " +
+                        "latency p50=%s p99=%s p999=%s max=%s errors=%d gc=%d (%d ms) heap=%d MiB direct=%s%n",
+                (now - startNanos) / 1e9, openConnections,
+                handshakeInterval.getTotalCount() / seconds, micros(handshakeInterval.getValueAtPercentile(99)),
+                requestInterval.getTotalCount() / seconds, bytes.sumThenReset() / seconds / (1024 * 1024),
+                micros(requestInterval.getValueAtPercentile(50)), micros(requestInterval.getValueAtPercentile(99)),
+                micros(requestInterval.getValueAtPercentile(99.9)), micros(requestInterval.getMaxValue()),
+                errors.sum(), gcCount - lastGcCount, gcMillis - lastGcMillis, usedHeapMiB(), directMemory());
+        lastGcCount = gcCount;
+        lastGcMillis = gcMillis;
+    }
+
+    /**
+     * Print the latency distribution of the whole run.
+     */
+    synchronized void summary() {
+        out.println();
+        out.println("Handshake latency (us):");
+        totalHandshakes.outputPercentileDistribution(out, 5, 1000.0);
+        out.println();
+        out.println("Request latency (us):");
+        totalRequests.outputPercentileDistribution(out, 5, 1000.0);
+        if (logWriter != null) {
+            logWriter.close();
+        }
+    }
+
+    private static String micros(long nanos) {
+        return String.format("%.0fus", nanos / 1000.0);
+    }
+
+    private static long usedHeapMiB() {
+        Runtime runtime = Runtime.getRuntime();
+        return (runtime.totalMemory() - runtime.freeMemory()) / (1024 * 1024);
+    }
+
+    // Netty may use direct memory that it tracks itself (noCleaner), that is allocated via ByteBuffer
+    // (tracked by the "direct" BufferPoolMXBean) and pooled, so report all of them.
+    private String directMemory() {
+        long netty = PlatformDependent.usedDirectMemory();
+        long pooled = PooledByteBufAllocator.DEFAULT.metric().usedDirectMemory();
+        long nio = directPool == null ? -1 : directPool.getMemoryUsed();
+        return String.format("%d MiB (netty=%d MiB, pooled=%d MiB, nio=%d MiB)",
+                (Math.max(0, netty) + Math.max(0, nio)) / (1024 * 1024),
+                netty / (1024 * 1024), pooled / (1024 * 1024), nio / (1024 * 1024));
+    }
+
+    private static BufferPoolMXBean directPool() {
+        for (BufferPoolMXBean pool: ManagementFactory.getPlatformMXBeans(BufferPoolMXBean.class)) {
+            if ("direct".equals(pool.getName())) {
+                return pool;
+            }
+        }
+        return null;
+    }
+}
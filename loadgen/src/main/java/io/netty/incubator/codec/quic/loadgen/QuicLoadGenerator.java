@@ -0,0 +1,275 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic.loadgen;
+
+import io.netty.bootstrap.Bootstrap;
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.EventLoopGroup;
+import io.netty.channel.epoll.Epoll;
+import io.netty.channel.epoll.EpollChannelOption;
+import io.netty.channel.epoll.EpollDatagramChannel;
+import io.netty.channel.epoll.EpollEventLoopGroup;
+import io.netty.channel.nio.NioEventLoopGroup;
+import io.netty.channel.socket.DatagramChannel;
+import io.netty.channel.socket.nio.NioDatagramChannel;
+import io.netty.incubator.codec.quic.InsecureQuicTokenHandler;
+import io.netty.incubator.codec.quic.Quic;
+import io.netty.incubator.codec.quic.QuicChannel;
+import io.netty.incubator.codec.quic.QuicClientCodecBuilder;
+import io.netty.incubator.codec.quic.QuicCodecBuilder;
+import io.netty.incubator.codec.quic.QuicServerCodecBuilder;
+import io.netty.util.NetUtil;
+import io.netty.util.concurrent.Future;
+import io.netty.util.internal.PlatformDependent;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.net.InetSocketAddress;
+import java.nio.file.Files;
+import java.nio.file.StandardCopyOption;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.Queue;
+import java.util.concurrent.ConcurrentLinkedQueue;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Drives many QUIC connections against a server that runs in the same JVM over loopback and reports handshake rate,
+ * throughput, latency percentiles, GC activity and direct memory usage. The server is built with
+ * {@link QuicServerCodecBuilder} and echoes every stream, the clients use {@link QuicChannel#newBootstrap(Channel)}.
+ *
+ * On linux the server shards are bound to the same port via {@code SO_REUSEPORT}, so all server threads are used.
+ * Everything else works the same way with NIO.
+ */
+public final class QuicLoadGenerator {
+
+    private static final byte[] PROTOS = new byte[] {
+            0x08, 'l', 'o', 'a', 'd', 'g', 'e', 'n', '1'
+    };
+
+    private final LoadGeneratorConfig config;
+    private final LoadStatistics statistics;
+    private final boolean epoll = Epoll.isAvailable();
+    private final Queue<LoadConnection> connections = new ConcurrentLinkedQueue<>();
+    private final AtomicInteger openConnections = new AtomicInteger();
+    private final ByteBuf message;
+    private final String certPath;
+    private final String keyPath;
+
+    private QuicLoadGenerator(LoadGeneratorConfig config) throws IOException {
+        this.config = config;
+        this.statistics = new LoadStatistics(System.out, config.histogramLog);
+        // The message is shared by all connections, only duplicates are written.
+        this.message = Unpooled.unreleasableBuffer(
+                Unpooled.directBuffer(config.messageSize).writeZero(config.messageSize));
+        this.certPath = copyResource("cert.crt");
+        this.keyPath = copyResource("cert.key");
+    }
+
+    public static void main(String[] args) throws Exception {
+        final LoadGeneratorConfig config;
+        try {
+            config = LoadGeneratorConfig.parse(args);
+        } catch (IllegalArgumentException e) {
+            System.err.println(e.getMessage());
+            System.err.print(LoadGeneratorConfig.usage());
+            System.exit(1);
+            return;
+        }
+        Quic.ensureAvailability();
+        new QuicLoadGenerator(config).run();
+    }
+
+    private void run() throws Exception {
+        System.out.println("Running with " + config + ", transport=" + (epoll ? "epoll" : "nio"));
+        EventLoopGroup serverGroup = newGroup(config.serverThreads);
+        EventLoopGroup clientGroup = newGroup(config.clientThreads);
+        try {
+            List<Channel> servers = startServer(serverGroup);
+            InetSocketAddress serverAddress = (InetSocketAddress) servers.get(0).localAddress();
+            List<Channel> clients = startClients(clientGroup);
+
+            long startNanos = System.nanoTime();
+            long reportNanos = TimeUnit.SECONDS.toNanos(config.reportInterval);
+            long nextReport = startNanos + reportNanos;
+            long endNanos = -1;
+            int opened = 0;
+            while (endNanos == -1 || System.nanoTime() < endNanos) {
+                long now = System.nanoTime();
+                if (opened < config.connections) {
+                    // Open connections at the configured rate.
+                    long target = Math.min(config.connections,
+                            (now - startNanos) * config.connectRate / TimeUnit.SECONDS.toNanos(1) + 1);
+                    for (; opened < target; opened++) {
+                        connect(clients.get(opened % clients.size()), serverAddress);
+                    }
+                } else if (endNanos == -1) {
+                    endNanos = now + TimeUnit.SECONDS.toNanos(config.duration);
+                }
+                if (now >= nextReport) {
+                    statistics.report(openConnections.get());
+                    nextReport += reportNanos;
+                }
+                Thread.sleep(1);
+            }
+            statistics.report(openConnections.get());
+
+            List<Future<Void>> closeFutures = new ArrayList<>();
+            for (LoadConnection connection: connections) {
+                closeFutures.add(connection.stop());
+            }
+            for (Future<Void> future: closeFutures) {
+                future.awaitUninterruptibly();
+            }
+            statistics.summary();
+
+            for (Channel channel: clients) {
+                channel.close().sync();
+            }
+            for (Channel channel: servers) {
+                channel.close().sync();
+            }
+        } finally {
+            clientGroup.shutdownGracefully();
+            serverGroup.shutdownGracefully();
+        }
+    }
+
+    private void connect(Channel client, InetSocketAddress serverAddress) {
+        long startNanos = System.nanoTime();
+        QuicChannel.newBootstrap(client)
+                .handler(new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public void channelInactive(ChannelHandlerContext ctx) {
+                        openConnections.decrementAndGet();
+                        ctx.fireChannelInactive();
+                    }
+                })
+                .streamHandler(new ChannelInboundHandlerAdapter())
+                .remoteAddress(serverAddress)
+                .connect()
+                .addListener((Future<QuicChannel> future) -> {
+                    if (!future.isSuccess()) {
+                        statistics.error();
+                        return;
+                    }
+                    statistics.handshakeDone(System.nanoTime() - startNanos);
+                    openConnections.incrementAndGet();
+                    LoadConnection connection = new LoadConnection(future.getNow(), statistics, message,
+                            config.streams, config.requestRate);
+                    connections.add(connection);
+                    connection.start();
+                });
+    }
+
+    private List<Channel> startServer(EventLoopGroup group) throws Exception {
+        QuicServerCodecBuilder builder = configure(new QuicServerCodecBuilder())
+                .tokenHandler(InsecureQuicTokenHandler.INSTANCE)
+                .handler(new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                })
+                .streamHandler(new EchoHandler());
+        List<ChannelHandler> codecs = epoll ? builder.buildShards(config.serverThreads) :
+                Collections.singletonList(builder.build());
+        List<Channel> servers = new ArrayList<>(codecs.size());
+        for (ChannelHandler codec: codecs) {
+            Bootstrap bootstrap = new Bootstrap().group(group)
+                    .channel(datagramChannelClass())
+                    .handler(codec);
+            if (epoll) {
+                bootstrap.option(EpollChannelOption.SO_REUSEPORT, true);
+            }
+            servers.add(bootstrap.bind(new InetSocketAddress(NetUtil.LOCALHOST4, config.port)).sync().channel());
+        }
+        return servers;
+    }
+
+    private List<Channel> startClients(EventLoopGroup group) throws Exception {
+        List<Channel> clients = new ArrayList<>(config.clientThreads);
+        for (int i = 0; i < config.clientThreads; i++) {
+            clients.add(new Bootstrap().group(group)
+                    .channel(datagramChannelClass())
+                    .handler(configure(new QuicClientCodecBuilder()).build())
+                    .bind(new InetSocketAddress(NetUtil.LOCALHOST4, 0)).sync().channel());
+        }
+        return clients;
+    }
+
+    private <B extends QuicCodecBuilder<B>> B configure(B builder) {
+        return builder.certificateChain(certPath)
+                .privateKey(keyPath)
+                .applicationProtocols(PROTOS)
+                .maxIdleTimeout(config.idleTimeout)
+                .maxUdpPayloadSize(Quic.MAX_DATAGRAM_SIZE)
+                .initialMaxData(10000000)
+                .initialMaxStreamDataBidirectionalLocal(1000000)
+                .initialMaxStreamDataBidirectionalRemote(1000000)
+                .initialMaxStreamDataUnidirectional(1000000)
+                .initialMaxStreamsBidirectional(Math.max(100, config.streams))
+                .initialMaxStreamsUnidirectional(100)
+                .disableActiveMigration(true)
+                .enablePacing(config.pacing);
+    }
+
+    private EventLoopGroup newGroup(int threads) {
+        return epoll ? new EpollEventLoopGroup(threads) : new NioEventLoopGroup(threads);
+    }
+
+    private Class<? extends DatagramChannel> datagramChannelClass() {
+        return epoll ? EpollDatagramChannel.class : NioDatagramChannel.class;
+    }
+
+    private static String copyResource(String name) throws IOException {
+        // quiche can only load the certificate and key from a file, so copy them out of the jar.
+        try (InputStream in = QuicLoadGenerator.class.getResourceAsStream("/" + name)) {
+            if (in == null) {
+                throw new IllegalStateException("Resource not found: " + name);
+            }
+            File file = PlatformDependent.createTempFile("netty-quic-loadgen", name, null);
+            file.deleteOnExit();
+            Files.copy(in, file.toPath(), StandardCopyOption.REPLACE_EXISTING);
+            return file.getAbsolutePath();
+        }
+    }
+
+    private static final class EchoHandler extends ChannelInboundHandlerAdapter {
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ctx.write(msg);
+        }
+
+        @Override
+        public void channelReadComplete(ChannelHandlerContext ctx) {
+            ctx.flush();
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+}
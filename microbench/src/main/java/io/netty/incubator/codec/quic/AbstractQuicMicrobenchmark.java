@@ -0,0 +1,31 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * Base class for all QUIC microbenchmarks, which uses the same forking and iteration settings everywhere so results
+ * of different runs can be compared. Use {@code -prof gc} to also collect the allocation profile.
+ */
+@Fork(value = 2, jvmArgsAppend = { "-server", "-XX:+UseG1GC", "-Xms768m", "-Xmx768m",
+        "-Dio.netty.leakDetection.level=disabled" })
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 10, time = 1)
+public abstract class AbstractQuicMicrobenchmark {
+}
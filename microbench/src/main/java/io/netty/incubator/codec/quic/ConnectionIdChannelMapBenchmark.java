@@ -0,0 +1,125 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.embedded.EmbeddedChannel;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+import java.nio.ByteBuffer;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.Map;
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * Compares connection id lookups in {@link ConnectionIdChannelMap} with the {@code HashMap<ByteBuffer, ...>} that was
+ * used before. The lookups are done on direct {@link ByteBuf}s, like the parsed connection ids of received packets.
+ */
+@State(Scope.Thread)
+public class ConnectionIdChannelMapBenchmark extends AbstractQuicMicrobenchmark {
+    private static final int CONNECTION_ID_LENGTH = Quiche.QUICHE_MAX_CONN_ID_LEN;
+    // The number of different connection ids that are looked up, so not every lookup hits the same slot.
+    private static final int LOOKUPS = 4096;
+
+    @Param({ "10000", "100000", "1000000" })
+    public int connections;
+
+    private EmbeddedChannel parent;
+    private ConnectionIdChannelMap channelMap;
+    private Map<ByteBuffer, QuicheQuicChannel> hashMap;
+    private ByteBuf[] hits;
+    private ByteBuf[] misses;
+    private int index;
+
+    @Setup
+    public void setup() {
+        Quic.ensureAvailability();
+        parent = new EmbeddedChannel();
+        // All connection ids map to the same channel, which is all a lookup needs.
+        QuicheQuicChannel channel = QuicheQuicChannel.forClient(parent, null, new ChannelInboundHandlerAdapter(),
+                Quic.optionsArray(Collections.emptyMap()), Quic.attributesArray(Collections.emptyMap()));
+        channelMap = new ConnectionIdChannelMap();
+        hashMap = new HashMap<>();
+        hits = new ByteBuf[LOOKUPS];
+        misses = new ByteBuf[LOOKUPS];
+        int stride = connections / LOOKUPS;
+        for (int i = 0; i < connections; i++) {
+            ByteBuffer id = randomId();
+            channelMap.put(id, channel);
+            hashMap.put(id, channel);
+            if (i % stride == 0 && i / stride < LOOKUPS) {
+                hits[i / stride] = directId(id);
+            }
+        }
+        for (int i = 0; i < LOOKUPS; i++) {
+            misses[i] = directId(randomId());
+        }
+    }
+
+    @TearDown
+    public void tearDown() {
+        for (int i = 0; i < LOOKUPS; i++) {
+            hits[i].release();
+            misses[i].release();
+        }
+        parent.finishAndReleaseAll();
+    }
+
+    @Benchmark
+    public QuicheQuicChannel channelMapGet() {
+        return channelMap.get(next(hits));
+    }
+
+    @Benchmark
+    public QuicheQuicChannel hashMapGet() {
+        ByteBuf id = next(hits);
+        return hashMap.get(id.internalNioBuffer(id.readerIndex(), id.readableBytes()));
+    }
+
+    @Benchmark
+    public QuicheQuicChannel channelMapGetMiss() {
+        return channelMap.get(next(misses));
+    }
+
+    @Benchmark
+    public QuicheQuicChannel hashMapGetMiss() {
+        ByteBuf id = next(misses);
+        return hashMap.get(id.internalNioBuffer(id.readerIndex(), id.readableBytes()));
+    }
+
+    private ByteBuf next(ByteBuf[] ids) {
+        ByteBuf id = ids[index];
+        index = (index + 1) & (LOOKUPS - 1);
+        return id;
+    }
+
+    private static ByteBuffer randomId() {
+        byte[] bytes = new byte[CONNECTION_ID_LENGTH];
+        ThreadLocalRandom.current().nextBytes(bytes);
+        return ByteBuffer.wrap(bytes);
+    }
+
+    private static ByteBuf directId(ByteBuffer id) {
+        return QuicheQuicCodec.allocateNativeOrder(CONNECTION_ID_LENGTH).writeBytes(id.duplicate());
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.ReferenceCountUtil;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Measures the transfer over many streams that are all blocked by the stream level flow control at the same time.
+ * Each operation writes {@link #BYTES_PER_STREAM} bytes to each of the streams, while the server only opens a window
+ * of a quarter of it per stream, and delivers all datagrams until the server read all the data.
+ *
+ * The cost of this is dominated by how the codec finds the streams that can make progress again once the server
+ * opened the windows, so compare the score of the different numbers of streams.
+ */
+@State(Scope.Thread)
+public class QuicBlockedStreamsBenchmark extends AbstractQuicMicrobenchmark {
+    private static final int BYTES_PER_STREAM = 4096;
+
+    @Param({ "100", "1000", "10000" })
+    public int streams;
+
+    private QuicChannelPair pair;
+    private QuicChannel channel;
+    private List<QuicStreamChannel> streamChannels;
+    private ByteBuf data;
+    private final DiscardHandler discardHandler = new DiscardHandler();
+
+    @Setup
+    public void setup() throws Exception {
+        Quic.ensureAvailability();
+        pair = new QuicChannelPair(QuicMicrobenchUtils.newServerCodec(QuicMicrobenchUtils.newQuicServerBuilder()
+                        .initialMaxStreamsBidirectional(streams)
+                        .initialMaxStreamDataBidirectionalRemote(BYTES_PER_STREAM / 4), discardHandler),
+                QuicMicrobenchUtils.newClientCodec());
+        channel = pair.connect();
+        streamChannels = new ArrayList<>(streams);
+        for (int i = 0; i < streams; i++) {
+            streamChannels.add(channel.createStream(QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter())
+                    .sync().getNow());
+        }
+        data = channel.alloc().directBuffer(BYTES_PER_STREAM).writeZero(BYTES_PER_STREAM);
+    }
+
+    @TearDown
+    public void tearDown() {
+        if (data != null) {
+            data.release();
+        }
+        if (channel != null) {
+            channel.close();
+            pair.exchange();
+        }
+        pair.close();
+    }
+
+    @Benchmark
+    public long write() throws Exception {
+        long received = discardHandler.received;
+        for (QuicStreamChannel stream: streamChannels) {
+            stream.writeAndFlush(data.retainedDuplicate());
+        }
+        long expected = (long) streams * BYTES_PER_STREAM;
+        while (discardHandler.received - received < expected) {
+            if (!pair.exchange()) {
+                throw new IllegalStateException("Data was not received");
+            }
+        }
+        // Also deliver the ACKs so the congestion window stays open.
+        pair.exchange();
+        return discardHandler.received;
+    }
+
+    private static final class DiscardHandler extends ChannelInboundHandlerAdapter {
+        long received;
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            received += ((ByteBuf) msg).readableBytes();
+            ReferenceCountUtil.release(msg);
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.embedded.EmbeddedChannel;
+import io.netty.channel.socket.DatagramPacket;
+import io.netty.util.NetUtil;
+import io.netty.util.concurrent.Future;
+
+import java.net.InetSocketAddress;
+
+/**
+ * A QUIC server and client codec that are connected via an in-memory datagram pair. Nothing goes through the kernel,
+ * so the benchmarks only measure the codec and quiche.
+ *
+ * Everything runs on the calling thread. Datagrams that were written by one side are only delivered to the other side
+ * when {@link #exchange()} is called.
+ */
+final class QuicChannelPair {
+    static final InetSocketAddress SERVER_ADDRESS = new InetSocketAddress(NetUtil.LOCALHOST4, 4433);
+    static final InetSocketAddress CLIENT_ADDRESS = new InetSocketAddress(NetUtil.LOCALHOST4, 4434);
+
+    final EmbeddedChannel server;
+    final EmbeddedChannel client;
+
+    QuicChannelPair(ChannelHandler serverCodec, ChannelHandler clientCodec) {
+        server = new EmbeddedChannel(serverCodec);
+        client = new EmbeddedChannel(clientCodec);
+    }
+
+    /**
+     * Connect a new {@link QuicChannel} from the client to the server and exchange datagrams until the handshake is
+     * done.
+     */
+    QuicChannel connect() throws Exception {
+        Future<QuicChannel> future = QuicChannel.newBootstrap(client)
+                .handler(new ChannelInboundHandlerAdapter())
+                .streamHandler(new ChannelInboundHandlerAdapter())
+                .remoteAddress(SERVER_ADDRESS)
+                .connect();
+        exchangeUntil(future);
+        return future.getNow();
+    }
+
+    /**
+     * Exchange datagrams until the given {@link Future} is done.
+     */
+    void exchangeUntil(Future<?> future) throws Exception {
+        while (!future.isDone()) {
+            if (!exchange()) {
+                throw new IllegalStateException("No progress was made and the future is not done yet");
+            }
+        }
+        future.sync();
+    }
+
+    /**
+     * Deliver the datagrams that were written by each side to the other side until both sides are idle. Returns
+     * {@code true} if at least one datagram was delivered.
+     */
+    boolean exchange() {
+        boolean delivered = false;
+        for (;;) {
+            boolean moved = transfer(client, server, CLIENT_ADDRESS, SERVER_ADDRESS);
+            moved |= transfer(server, client, SERVER_ADDRESS, CLIENT_ADDRESS);
+            if (!moved) {
+                return delivered;
+            }
+            delivered = true;
+        }
+    }
+
+    private static boolean transfer(EmbeddedChannel from, EmbeddedChannel to,
+                                    InetSocketAddress sender, InetSocketAddress recipient) {
+        from.runPendingTasks();
+        from.runScheduledPendingTasks();
+        boolean moved = false;
+        for (;;) {
+            DatagramPacket packet = from.readOutbound();
+            if (packet == null) {
+                break;
+            }
+            to.writeOneInbound(new DatagramPacket(packet.content(), recipient, sender));
+            moved = true;
+        }
+        if (moved) {
+            // Triggers channelReadComplete(...) so the codec processes the burst.
+            to.flushInbound();
+        }
+        return moved;
+    }
+
+    void close() {
+        client.finishAndReleaseAll();
+        server.finishAndReleaseAll();
+    }
+}
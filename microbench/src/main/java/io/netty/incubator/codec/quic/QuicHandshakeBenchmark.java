@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.ReferenceCountUtil;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+/**
+ * Measures how many handshakes per second {@link QuicheQuicServerCodec} can do. Each operation connects a new
+ * {@link QuicChannel} via the in-memory {@link QuicChannelPair}, including the retry that is done by
+ * {@link InsecureQuicTokenHandler}, and closes it again.
+ */
+@State(Scope.Thread)
+public class QuicHandshakeBenchmark extends AbstractQuicMicrobenchmark {
+
+    private QuicChannelPair pair;
+
+    @Setup
+    public void setup() {
+        Quic.ensureAvailability();
+        pair = new QuicChannelPair(QuicMicrobenchUtils.newServerCodec(new DiscardHandler()),
+                QuicMicrobenchUtils.newClientCodec());
+    }
+
+    @TearDown
+    public void tearDown() {
+        pair.close();
+    }
+
+    @Benchmark
+    public QuicChannel handshake() throws Exception {
+        QuicChannel channel = pair.connect();
+        channel.close();
+        pair.exchange();
+        return channel;
+    }
+
+    private static final class DiscardHandler extends ChannelInboundHandlerAdapter {
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ReferenceCountUtil.release(msg);
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.internal.PlatformDependent;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.file.Files;
+import java.nio.file.StandardCopyOption;
+
+/**
+ * Helpers to create the codecs that are used by the microbenchmarks. These use the same settings as the tests.
+ */
+final class QuicMicrobenchUtils {
+
+    private static final byte[] PROTOS = new byte[] {
+            0x05, 'h', 'q', '-', '2', '9',
+            0x05, 'h', 'q', '-', '2', '8',
+            0x05, 'h', 'q', '-', '2', '7',
+            0x08, 'h', 't', 't', 'p', '/', '0', '.', '9'
+    };
+
+    // quiche can only load the certificate and key from a file, so copy them out of the jar once.
+    private static final String CERT_PATH = copyResource("cert.crt");
+    private static final String KEY_PATH = copyResource("cert.key");
+
+    private QuicMicrobenchUtils() { }
+
+    static QuicServerCodecBuilder newQuicServerBuilder() {
+        return new QuicServerCodecBuilder()
+                .certificateChain(CERT_PATH)
+                .privateKey(KEY_PATH)
+                .applicationProtocols(PROTOS)
+                .maxIdleTimeout(60000)
+                .maxUdpPayloadSize(Quic.MAX_DATAGRAM_SIZE)
+                .initialMaxData(100000000)
+                .initialMaxStreamDataBidirectionalLocal(10000000)
+                .initialMaxStreamDataBidirectionalRemote(10000000)
+                .initialMaxStreamDataUnidirectional(10000000)
+                .initialMaxStreamsBidirectional(100000)
+                .initialMaxStreamsUnidirectional(100000)
+                .disableActiveMigration(true);
+    }
+
+    static QuicClientCodecBuilder newQuicClientBuilder() {
+        return new QuicClientCodecBuilder()
+                .certificateChain(CERT_PATH)
+                .privateKey(KEY_PATH)
+                .applicationProtocols(PROTOS)
+                .maxIdleTimeout(60000)
+                .maxUdpPayloadSize(Quic.MAX_DATAGRAM_SIZE)
+                .initialMaxData(100000000)
+                .initialMaxStreamDataBidirectionalLocal(10000000)
+                .initialMaxStreamDataBidirectionalRemote(10000000)
+                .initialMaxStreamDataUnidirectional(10000000)
+                .initialMaxStreamsBidirectional(100000)
+                .initialMaxStreamsUnidirectional(100000)
+                .disableActiveMigration(true);
+    }
+
+    static ChannelHandler newServerCodec(ChannelHandler streamHandler) {
+        return newServerCodec(newQuicServerBuilder(), streamHandler);
+    }
+
+    static ChannelHandler newServerCodec(QuicServerCodecBuilder builder, ChannelHandler streamHandler) {
+        return builder
+                .tokenHandler(InsecureQuicTokenHandler.INSTANCE)
+                .handler(new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                })
+                .streamHandler(streamHandler)
+                .build();
+    }
+
+    static ChannelHandler newClientCodec() {
+        return newQuicClientBuilder().build();
+    }
+
+    private static String copyResource(String name) {
+        try (InputStream in = QuicMicrobenchUtils.class.getResourceAsStream("/" + name)) {
+            if (in == null) {
+                throw new IllegalStateException("Resource not found: " + name);
+            }
+            File file = PlatformDependent.createTempFile("netty-quic-microbench", name, null);
+            file.deleteOnExit();
+            Files.copy(in, file.toPath(), StandardCopyOption.REPLACE_EXISTING);
+            return file.getAbsolutePath();
+        } catch (IOException e) {
+            throw new IllegalStateException(e);
+        }
+    }
+}
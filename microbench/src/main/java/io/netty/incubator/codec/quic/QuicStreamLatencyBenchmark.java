@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.ReferenceCountUtil;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Measures the round-trip latency of a small message that is echoed by the server on the same stream.
+ */
+@State(Scope.Thread)
+@BenchmarkMode(Mode.SampleTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+public class QuicStreamLatencyBenchmark extends AbstractQuicMicrobenchmark {
+    private static final int MESSAGE_SIZE = 32;
+
+    private QuicChannelPair pair;
+    private QuicChannel channel;
+    private QuicStreamChannel stream;
+    private ByteBuf message;
+    private final CountingHandler countingHandler = new CountingHandler();
+
+    @Setup
+    public void setup() throws Exception {
+        Quic.ensureAvailability();
+        pair = new QuicChannelPair(QuicMicrobenchUtils.newServerCodec(new EchoHandler()),
+                QuicMicrobenchUtils.newClientCodec());
+        channel = pair.connect();
+        stream = channel.createStream(QuicStreamType.BIDIRECTIONAL, countingHandler).sync().getNow();
+        message = stream.alloc().directBuffer(MESSAGE_SIZE).writeZero(MESSAGE_SIZE);
+    }
+
+    @TearDown
+    public void tearDown() {
+        if (message != null) {
+            message.release();
+        }
+        if (channel != null) {
+            channel.close();
+            pair.exchange();
+        }
+        pair.close();
+    }
+
+    @Benchmark
+    public long roundTrip() {
+        long received = countingHandler.received;
+        stream.writeAndFlush(message.retainedDuplicate());
+        while (countingHandler.received - received < MESSAGE_SIZE) {
+            if (!pair.exchange()) {
+                throw new IllegalStateException("Echo was not received");
+            }
+        }
+        return countingHandler.received;
+    }
+
+    private static final class EchoHandler extends ChannelInboundHandlerAdapter {
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ctx.write(msg);
+        }
+
+        @Override
+        public void channelReadComplete(ChannelHandlerContext ctx) {
+            ctx.flush();
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+
+    private static final class CountingHandler extends ChannelInboundHandlerAdapter {
+        long received;
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            received += ((ByteBuf) msg).readableBytes();
+            ReferenceCountUtil.release(msg);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.ReferenceCountUtil;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+/**
+ * Measures how many short-lived streams can be opened and closed per second on one connection, which is what
+ * RPC-style traffic with one stream per request looks like. Each operation opens a stream, sends a small request
+ * with FIN and waits until the echo with FIN was received and the stream is closed on both sides.
+ */
+@State(Scope.Thread)
+public class QuicStreamOpenCloseBenchmark extends AbstractQuicMicrobenchmark {
+
+    private QuicChannelPair pair;
+    private QuicChannel channel;
+    private ByteBuf message;
+
+    @Setup
+    public void setup() throws Exception {
+        Quic.ensureAvailability();
+        pair = new QuicChannelPair(QuicMicrobenchUtils.newServerCodec(new EchoFinHandler()),
+                QuicMicrobenchUtils.newClientCodec());
+        channel = pair.connect();
+        message = channel.alloc().directBuffer(16).writeZero(16);
+    }
+
+    @TearDown
+    public void tearDown() {
+        if (message != null) {
+            message.release();
+        }
+        if (channel != null) {
+            channel.close();
+            pair.exchange();
+        }
+        pair.close();
+    }
+
+    @Benchmark
+    public QuicStreamChannel openClose() throws Exception {
+        QuicStreamChannel stream = channel.createStream(QuicStreamType.BIDIRECTIONAL, DiscardHandler.INSTANCE)
+                .sync().getNow();
+        stream.writeAndFlush(new DefaultQuicStreamFrame(message.retainedDuplicate(), true));
+        pair.exchangeUntil(stream.closeFuture());
+        return stream;
+    }
+
+    private static final class EchoFinHandler extends ChannelInboundHandlerAdapter {
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ctx.writeAndFlush(new DefaultQuicStreamFrame((ByteBuf) msg, true));
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+
+    private static final class DiscardHandler extends ChannelInboundHandlerAdapter {
+        static final DiscardHandler INSTANCE = new DiscardHandler();
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ReferenceCountUtil.release(msg);
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+}
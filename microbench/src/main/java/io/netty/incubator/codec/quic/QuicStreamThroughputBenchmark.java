@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.ReferenceCountUtil;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * Measures the stream throughput through the client and server codec. Each operation writes {@code writeSize} bytes
+ * to a stream and delivers all datagrams until the server read the data and the client received the ACKs, so the
+ * throughput in bytes is the score multiplied by {@code writeSize}.
+ *
+ * Compare with {@link QuicStreamThroughputPerPacketBenchmark} to see how batching the packets of a connection into
+ * one buffer affects the allocations per byte.
+ */
+@State(Scope.Thread)
+public class QuicStreamThroughputBenchmark extends AbstractQuicMicrobenchmark {
+
+    @Param({ "64", "1024", "16384", "65536" })
+    public int writeSize;
+
+    private QuicChannelPair pair;
+    private QuicChannel channel;
+    private QuicStreamChannel stream;
+    private ByteBuf data;
+    private final DiscardHandler discardHandler = new DiscardHandler();
+
+    @Setup
+    public void setup() throws Exception {
+        Quic.ensureAvailability();
+        pair = new QuicChannelPair(QuicMicrobenchUtils.newServerCodec(discardHandler),
+                QuicMicrobenchUtils.newClientCodec());
+        channel = pair.connect();
+        stream = channel.createStream(QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter())
+                .sync().getNow();
+        byte[] bytes = new byte[writeSize];
+        ThreadLocalRandom.current().nextBytes(bytes);
+        data = stream.alloc().directBuffer(writeSize).writeBytes(bytes);
+    }
+
+    @TearDown
+    public void tearDown() {
+        if (data != null) {
+            data.release();
+        }
+        if (channel != null) {
+            channel.close();
+            pair.exchange();
+        }
+        pair.close();
+    }
+
+    @Benchmark
+    public long write() throws Exception {
+        long received = discardHandler.received;
+        stream.writeAndFlush(data.retainedDuplicate());
+        while (discardHandler.received - received < writeSize) {
+            if (!pair.exchange()) {
+                throw new IllegalStateException("Data was not received");
+            }
+        }
+        // Also deliver the ACKs so the congestion window stays open.
+        pair.exchange();
+        return discardHandler.received;
+    }
+
+    private static final class DiscardHandler extends ChannelInboundHandlerAdapter {
+        long received;
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            received += ((ByteBuf) msg).readableBytes();
+            ReferenceCountUtil.release(msg);
+        }
+
+        @Override
+        public boolean isSharable() {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import org.openjdk.jmh.annotations.Fork;
+
+/**
+ * Runs {@link QuicStreamThroughputBenchmark} with {@code quiche_conn_send_batch(...)} limited to one packet per call,
+ * which allocates one buffer per datagram like the codec did before it batched the packets. Run both with
+ * {@code -prof gc} and divide {@code gc.alloc.rate.norm} by {@code writeSize} to compare the allocations per byte.
+ */
+@Fork(value = 2, jvmArgsAppend = { "-server", "-XX:+UseG1GC", "-Xms768m", "-Xmx768m",
+        "-Dio.netty.leakDetection.level=disabled", "-Dio.netty.incubator.codec.quic.maxSendBatch=1" })
+public class QuicStreamThroughputPerPacketBenchmark extends QuicStreamThroughputBenchmark {
+}
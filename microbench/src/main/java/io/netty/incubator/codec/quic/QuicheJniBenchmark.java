@@ -0,0 +1,390 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * Measures the cost of the JNI calls into quiche that are on the hot path of the codec. The connections are driven
+ * directly via {@link Quiche} without any netty channels involved.
+ */
+@State(Scope.Thread)
+public class QuicheJniBenchmark extends AbstractQuicMicrobenchmark {
+    private static final int MAX_PACKET_LEN = Quic.MAX_DATAGRAM_SIZE;
+    // The number of packets that are parsed via one quiche_header_info_batch(...) call, the same as the maximum
+    // burst of the codec.
+    private static final int BATCH_SIZE = 64;
+    // The number of packets that are produced via one quiche_conn_send_batch(...) call, the same as the codec uses if
+    // UDP_SEGMENT is not supported.
+    private static final int SEND_BATCH_SIZE = 16;
+    private static final long STREAM_ID = 0;
+    // A stream that has data which is never read by the server, so it is reported as readable after every receive.
+    private static final long UNREAD_STREAM_ID = 4;
+    // The number of readable stream ids that are collected per call, the same as the codec uses.
+    private static final int MAX_READABLE_STREAMS = 128;
+
+    // Layout of the buffer that is used to call quiche_header_info(...).
+    private static final int VERSION_OFFSET = 0;
+    private static final int TYPE_OFFSET = 4;
+    private static final int SCID_LEN_OFFSET = 8;
+    private static final int DCID_LEN_OFFSET = 16;
+    private static final int TOKEN_LEN_OFFSET = 24;
+    private static final int SCID_OFFSET = 32;
+    private static final int DCID_OFFSET = SCID_OFFSET + Quiche.QUICHE_MAX_CONN_ID_LEN;
+    private static final int TOKEN_OFFSET = DCID_OFFSET + Quiche.QUICHE_MAX_CONN_ID_LEN;
+
+    @Param({ "64", "1024", "16384" })
+    public int writeSize;
+
+    private QuicheConfig serverConfig;
+    private QuicheConfig clientConfig;
+    private long serverConn = -1;
+    private long clientConn = -1;
+
+    private ByteBuf out;
+    private ByteBuf in;
+    private ByteBuf sendBatch;
+    private ByteBuf sendLengths;
+    private ByteBuf streamIds;
+    private ByteBuf headerInfo;
+    private ByteBuf headerInfoBatch;
+    private int headerInfoEntryLength;
+    private ByteBuf data;
+    private ByteBuf fin;
+    // The first packet of the client, which is a long header packet.
+    private ByteBuf initialPacket;
+    // A packet of the client that was received by the server already.
+    private ByteBuf duplicatePacket;
+
+    @Setup
+    public void setup() throws Exception {
+        Quic.ensureAvailability();
+        serverConfig = QuicMicrobenchUtils.newQuicServerBuilder().createConfig();
+        serverConfig.attach();
+        clientConfig = QuicMicrobenchUtils.newQuicClientBuilder().createConfig();
+        clientConfig.attach();
+
+        out = QuicheQuicCodec.allocateNativeOrder(MAX_PACKET_LEN);
+        in = QuicheQuicCodec.allocateNativeOrder(MAX_PACKET_LEN);
+        sendBatch = QuicheQuicCodec.allocateNativeOrder(MAX_PACKET_LEN * SEND_BATCH_SIZE);
+        sendLengths = QuicheQuicCodec.allocateNativeOrder(Integer.BYTES * SEND_BATCH_SIZE);
+        streamIds = QuicheQuicCodec.allocateNativeOrder(Long.BYTES * MAX_READABLE_STREAMS);
+        headerInfo = QuicheQuicCodec.allocateNativeOrder(TOKEN_OFFSET + MAX_PACKET_LEN);
+        fin = QuicheQuicCodec.allocateNativeOrder(1);
+        data = QuicheQuicCodec.allocateNativeOrder(writeSize);
+        byte[] bytes = new byte[writeSize];
+        ThreadLocalRandom.current().nextBytes(bytes);
+        data.writeBytes(bytes);
+
+        clientConn = newConnection(false);
+        int len = send(clientConn);
+        initialPacket = QuicheQuicCodec.allocateNativeOrder(len).writeBytes(out, 0, len);
+
+        headerInfoEntryLength = Quiche.headerInfoEntryLength(MAX_PACKET_LEN);
+        headerInfoBatch = QuicheQuicCodec.allocateNativeOrder(headerInfoEntryLength * BATCH_SIZE);
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            int offset = i * headerInfoEntryLength;
+            headerInfoBatch.setLong(offset + Quiche.HEADER_INFO_BUF_OFFSET, Quiche.readerMemoryAddress(initialPacket));
+            headerInfoBatch.setInt(offset + Quiche.HEADER_INFO_BUF_LEN_OFFSET, initialPacket.readableBytes());
+        }
+
+        serverConn = newConnection(true);
+        recvCopy(serverConn, initialPacket);
+        exchange();
+        if (!Quiche.quiche_conn_is_established(clientConn) || !Quiche.quiche_conn_is_established(serverConn)) {
+            throw new IllegalStateException("Handshake did not complete");
+        }
+
+        // Open the stream and capture one packet that we can feed to the server again and again.
+        Quiche.throwIfError(Quiche.quiche_conn_stream_send(clientConn, STREAM_ID,
+                Quiche.readerMemoryAddress(data), 1, false));
+        len = send(clientConn);
+        duplicatePacket = QuicheQuicCodec.allocateNativeOrder(len).writeBytes(out, 0, len);
+        recvCopy(serverConn, duplicatePacket);
+        exchange();
+
+        Quiche.throwIfError(Quiche.quiche_conn_stream_send(clientConn, UNREAD_STREAM_ID,
+                Quiche.readerMemoryAddress(data), 1, false));
+        exchange();
+    }
+
+    @TearDown
+    public void tearDown() {
+        if (clientConn != -1) {
+            Quiche.quiche_conn_free(clientConn);
+        }
+        if (serverConn != -1) {
+            Quiche.quiche_conn_free(serverConn);
+        }
+        serverConfig.detach();
+        clientConfig.detach();
+        release(out, in, sendBatch, sendLengths, streamIds, headerInfo, headerInfoBatch, data, fin, initialPacket, duplicatePacket);
+    }
+
+    @Benchmark
+    public int headerInfo() {
+        long addr = Quiche.memoryAddress(headerInfo);
+        // The lengths are in / out parameters and so need to be reset before each call.
+        headerInfo.setLong(SCID_LEN_OFFSET, Quiche.QUICHE_MAX_CONN_ID_LEN);
+        headerInfo.setLong(DCID_LEN_OFFSET, Quiche.QUICHE_MAX_CONN_ID_LEN);
+        headerInfo.setLong(TOKEN_LEN_OFFSET, MAX_PACKET_LEN);
+        return Quiche.quiche_header_info(Quiche.readerMemoryAddress(initialPacket), initialPacket.readableBytes(),
+                Quiche.QUICHE_MAX_CONN_ID_LEN, addr + VERSION_OFFSET, addr + TYPE_OFFSET,
+                addr + SCID_OFFSET, addr + SCID_LEN_OFFSET, addr + DCID_OFFSET, addr + DCID_LEN_OFFSET,
+                addr + TOKEN_OFFSET, addr + TOKEN_LEN_OFFSET);
+    }
+
+    /**
+     * Parses {@link #BATCH_SIZE} headers with one JNI call, compare with {@link #headerInfo()} times
+     * {@link #BATCH_SIZE}.
+     */
+    @Benchmark
+    public int headerInfoBatch() {
+        Quiche.quiche_header_info_batch(Quiche.memoryAddress(headerInfoBatch), BATCH_SIZE, headerInfoEntryLength,
+                Quiche.QUICHE_MAX_CONN_ID_LEN);
+        return headerInfoBatch.getInt(Quiche.HEADER_INFO_RES_OFFSET);
+    }
+
+    /**
+     * Receive a packet that was received before, which includes decrypting it before quiche detects the duplicate.
+     */
+    @Benchmark
+    public int connRecvDuplicate() {
+        // quiche decrypts in place, so we need to copy the packet each time.
+        in.setBytes(0, duplicatePacket, 0, duplicatePacket.readableBytes());
+        return Quiche.quiche_conn_recv(serverConn, Quiche.memoryAddress(in), duplicatePacket.readableBytes());
+    }
+
+    /**
+     * Receive a packet and then check the state of the connection and collect the readable streams with separate
+     * JNI calls. Compare with {@link #connRecvAndPoll()}.
+     */
+    @Benchmark
+    public int connRecvThenPoll() {
+        in.setBytes(0, duplicatePacket, 0, duplicatePacket.readableBytes());
+        int res = Quiche.quiche_conn_recv(serverConn, Quiche.memoryAddress(in), duplicatePacket.readableBytes());
+        if (Quiche.quiche_conn_is_closed(serverConn) || !Quiche.quiche_conn_is_established(serverConn) &&
+                !Quiche.quiche_conn_is_in_early_data(serverConn)) {
+            return res;
+        }
+        long iter = Quiche.quiche_conn_readable(serverConn);
+        if (iter == -1) {
+            return res;
+        }
+        try {
+            int readable = 0;
+            int num;
+            do {
+                num = Quiche.quiche_stream_iter_next(iter, Quiche.memoryAddress(streamIds), MAX_READABLE_STREAMS);
+                readable += num;
+            } while (num == MAX_READABLE_STREAMS);
+            return readable;
+        } finally {
+            Quiche.quiche_stream_iter_free(iter);
+        }
+    }
+
+    /**
+     * Receive a packet, check the state of the connection and collect the readable streams with one
+     * quiche_conn_recv_and_poll(...) call, as the codec does.
+     */
+    @Benchmark
+    public int connRecvAndPoll() {
+        in.setBytes(0, duplicatePacket, 0, duplicatePacket.readableBytes());
+        long status = Quiche.quiche_conn_recv_and_poll(serverConn, Quiche.memoryAddress(in),
+                duplicatePacket.readableBytes(), Quiche.memoryAddress(streamIds), MAX_READABLE_STREAMS);
+        return Quiche.recvAndPollStreams(status);
+    }
+
+    /**
+     * Call send on a connection that has nothing to send.
+     */
+    @Benchmark
+    public int connSendIdle() {
+        return Quiche.quiche_conn_send(clientConn, Quiche.memoryAddress(out), MAX_PACKET_LEN);
+    }
+
+    /**
+     * Write {@link #writeSize} bytes to a stream, send the packets to the server which reads the data, and feed the
+     * ACKs back to the client so the congestion and flow control windows stay open.
+     */
+    @Benchmark
+    public int connStreamSend() throws Exception {
+        int written = Quiche.quiche_conn_stream_send(clientConn, STREAM_ID, Quiche.readerMemoryAddress(data),
+                writeSize, false);
+        Quiche.throwIfError(written);
+        exchange();
+        return written;
+    }
+
+    /**
+     * Write {@link #writeSize} bytes to a stream and produce the packets with one quiche_conn_send(...) call per
+     * packet. Compare with {@link #connStreamSendBatch()}.
+     */
+    @Benchmark
+    public int connStreamSendPerPacket() throws Exception {
+        Quiche.throwIfError(Quiche.quiche_conn_stream_send(clientConn, STREAM_ID, Quiche.readerMemoryAddress(data),
+                writeSize, false));
+        long outAddr = Quiche.memoryAddress(sendBatch);
+        int total = 0;
+        int packets;
+        do {
+            int offset = 0;
+            packets = 0;
+            while (packets < SEND_BATCH_SIZE) {
+                int len = Quiche.quiche_conn_send(clientConn, outAddr + offset, MAX_PACKET_LEN);
+                if (Quiche.throwIfError(len)) {
+                    break;
+                }
+                sendLengths.setInt(packets * Integer.BYTES, len);
+                offset += len;
+                packets++;
+            }
+            deliverBatch(packets);
+            total += packets;
+        } while (packets == SEND_BATCH_SIZE);
+        exchange();
+        return total;
+    }
+
+    /**
+     * Write {@link #writeSize} bytes to a stream and produce the packets with one quiche_conn_send_batch(...) call
+     * per {@link #SEND_BATCH_SIZE} packets, as the codec does.
+     */
+    @Benchmark
+    public int connStreamSendBatch() throws Exception {
+        Quiche.throwIfError(Quiche.quiche_conn_stream_send(clientConn, STREAM_ID, Quiche.readerMemoryAddress(data),
+                writeSize, false));
+        int total = 0;
+        int packets;
+        do {
+            packets = Quiche.quiche_conn_send_batch(clientConn, Quiche.memoryAddress(sendBatch), sendBatch.capacity(),
+                    MAX_PACKET_LEN, Quiche.memoryAddress(sendLengths), SEND_BATCH_SIZE);
+            if (Quiche.throwIfError(packets)) {
+                packets = 0;
+            }
+            deliverBatch(packets);
+            total += packets;
+        } while (packets == SEND_BATCH_SIZE);
+        exchange();
+        return total;
+    }
+
+    private long newConnection(boolean server) {
+        ByteBuf id = QuicheQuicCodec.allocateNativeOrder(Quiche.QUICHE_MAX_CONN_ID_LEN);
+        try {
+            byte[] bytes = new byte[Quiche.QUICHE_MAX_CONN_ID_LEN];
+            ThreadLocalRandom.current().nextBytes(bytes);
+            id.writeBytes(bytes);
+            QuicheConfig config = server ? serverConfig : clientConfig;
+            QuicheNativeConfig nativeConfig = config.acquireNativeConfig();
+            try {
+                long conn = server ?
+                        Quiche.quiche_accept_no_token(Quiche.readerMemoryAddress(id), id.readableBytes(),
+                                nativeConfig.address()) :
+                        Quiche.quiche_connect(null, Quiche.readerMemoryAddress(id), id.readableBytes(),
+                                nativeConfig.address());
+                if (conn == -1) {
+                    throw new IllegalStateException("Unable to create connection");
+                }
+                return conn;
+            } finally {
+                nativeConfig.release();
+            }
+        } finally {
+            id.release();
+        }
+    }
+
+    // Send packets in both directions until neither side has anything to send anymore, and read all stream data
+    // on the server.
+    private void exchange() throws Exception {
+        for (;;) {
+            boolean sent = false;
+            int len;
+            while ((len = send(clientConn)) > 0) {
+                recv(serverConn, out, len);
+                sent = true;
+            }
+            drainStream();
+            while ((len = send(serverConn)) > 0) {
+                recv(clientConn, out, len);
+                sent = true;
+            }
+            if (!sent) {
+                return;
+            }
+        }
+    }
+
+    // Deliver the packets that were written back-to-back into sendBatch to the server and read the stream data.
+    private void deliverBatch(int packets) throws Exception {
+        long addr = Quiche.memoryAddress(sendBatch);
+        for (int i = 0; i < packets; i++) {
+            int len = sendLengths.getInt(i * Integer.BYTES);
+            Quiche.throwIfError(Quiche.quiche_conn_recv(serverConn, addr, len));
+            addr += len;
+        }
+        drainStream();
+    }
+
+    private void drainStream() throws Exception {
+        long inAddr = Quiche.memoryAddress(in);
+        for (;;) {
+            int res = Quiche.quiche_conn_stream_recv(serverConn, STREAM_ID, inAddr, in.capacity(),
+                    Quiche.memoryAddress(fin));
+            if (res == Quiche.QUICHE_ERR_INVALID_STREAM_STATE || Quiche.throwIfError(res)) {
+                // The stream is not open on the server yet or there is nothing to read.
+                return;
+            }
+        }
+    }
+
+    private int send(long conn) throws Exception {
+        int len = Quiche.quiche_conn_send(conn, Quiche.memoryAddress(out), MAX_PACKET_LEN);
+        if (Quiche.throwIfError(len)) {
+            return 0;
+        }
+        return len;
+    }
+
+    // quiche decrypts in place, so pass a copy of packets that are used again later.
+    private void recvCopy(long conn, ByteBuf packet) throws Exception {
+        int len = packet.readableBytes();
+        in.setBytes(0, packet, packet.readerIndex(), len);
+        recv(conn, in, len);
+    }
+
+    private static void recv(long conn, ByteBuf packet, int len) throws Exception {
+        Quiche.throwIfError(Quiche.quiche_conn_recv(conn, Quiche.memoryAddress(packet), len));
+    }
+
+    private static void release(ByteBuf... buffers) {
+        for (ByteBuf buffer: buffers) {
+            if (buffer != null) {
+                buffer.release();
+            }
+        }
+    }
+}
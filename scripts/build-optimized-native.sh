@@ -0,0 +1,71 @@
+#!/bin/bash
+# ----------------------------------------------------------------------------
+# Copyright 2020 The Netty Project
+#
+# The Netty Project licenses this file to you under the Apache License,
+# version 2.0 (the "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at:
+#
+#   https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations
+# under the License.
+# ----------------------------------------------------------------------------
+
+# Builds the "optimized" native jar (release quiche + LTO) using profile-guided optimization:
+#
+#  1. build an instrumented quiche / JNI library and run the QuicLoopbackWorkload against it
+#  2. merge the collected profiles with llvm-profdata
+#  3. rebuild everything with the merged profile
+#
+# Any extra arguments are passed to the final maven invocation, for example:
+#
+#   ./scripts/build-optimized-native.sh -DskipTests install
+#
+# clang, lld and llvm-profdata must use the same LLVM version as rustc. Use LTO_CC, LTO_CXX and LLVM_PROFDATA to
+# select specific versions.
+set -e
+
+cd "$(dirname "$0")/.."
+
+LTO_CC=${LTO_CC:-clang}
+LTO_CXX=${LTO_CXX:-clang++}
+LLVM_PROFDATA=${LLVM_PROFDATA:-llvm-profdata}
+PGO_DIR=$(pwd)/target/pgo
+QUICHE_DIR=$(pwd)/target/quiche
+MVN_ARGS=(-B -Poptimized -DltoCc="$LTO_CC" -DltoCxx="$LTO_CXX")
+
+if [ $# -eq 0 ]; then
+  set -- package
+fi
+
+# Remove the native library so hawtjni rebuilds it with the new flags.
+clean_native() {
+  rm -rf target/native-build target/classes/META-INF/native
+}
+
+echo "Building instrumented native library"
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+clean_native
+# The profile runtime writes its data on exit, %p / %m make sure forked JVMs do not overwrite each other.
+LLVM_PROFILE_FILE="$PGO_DIR/%p-%m.profraw" ./mvnw "${MVN_ARGS[@]}" \
+  -DquicheTargetDir="$QUICHE_DIR/target-pgo-generate" \
+  -DpgoRustFlags="-Cprofile-generate=$PGO_DIR" \
+  -DpgoCflags="-fprofile-generate=$PGO_DIR" \
+  -Dtest=QuicLoopbackWorkload -DfailIfNoTests=false \
+  test
+
+echo "Merging profiles"
+"$LLVM_PROFDATA" merge -o "$PGO_DIR/merged.profdata" "$PGO_DIR"/*.profraw
+
+echo "Building optimized native library"
+clean_native
+./mvnw "${MVN_ARGS[@]}" \
+  -DquicheTargetDir="$QUICHE_DIR/target-pgo-use" \
+  -DpgoRustFlags="-Cprofile-use=$PGO_DIR/merged.profdata" \
+  -DpgoCflags="-fprofile-use=$PGO_DIR/merged.profdata -Wno-profile-instr-out-of-date -Wno-profile-instr-unprofiled" \
+  "$@"
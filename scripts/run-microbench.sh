@@ -0,0 +1,88 @@
+#!/bin/bash
+# ----------------------------------------------------------------------------
+# Copyright 2020 The Netty Project
+#
+# The Netty Project licenses this file to you under the Apache License,
+# version 2.0 (the "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at:
+#
+#   https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations
+# under the License.
+# ----------------------------------------------------------------------------
+
+# Runs the JMH microbenchmarks with the GC profiler (allocation rate and bytes allocated per operation) and stores
+# the results as JSON, so they can be kept as a baseline and compared against later runs:
+#
+#   ./scripts/run-microbench.sh record baseline            # writes microbench/results/baseline.json
+#   ./scripts/run-microbench.sh compare baseline [regex]   # runs again and prints the change against the baseline
+#
+# Any benchmark regex and JMH options can be given after the name, for example:
+#
+#   ./scripts/run-microbench.sh record jni QuicheJniBenchmark -p writeSize=1024
+#
+# The codec has to be installed into the local maven repository first (./mvnw -DskipTests install). Results are
+# only comparable when they were recorded on the same machine.
+set -e
+
+cd "$(dirname "$0")/.."
+
+if [ $# -lt 2 ] || { [ "$1" != "record" ] && [ "$1" != "compare" ]; }; then
+  echo "Usage: $0 record|compare <name> [jmh args...]"
+  exit 1
+fi
+
+MODE=$1
+NAME=$2
+shift 2
+
+RESULTS_DIR=$(pwd)/microbench/results
+BASELINE="$RESULTS_DIR/$NAME.json"
+mkdir -p "$RESULTS_DIR"
+
+if [ "$MODE" = "compare" ]; then
+  if [ ! -f "$BASELINE" ]; then
+    echo "No baseline found at $BASELINE"
+    exit 1
+  fi
+  OUTPUT="$RESULTS_DIR/$NAME-current.json"
+else
+  OUTPUT="$BASELINE"
+fi
+
+(cd microbench && ../mvnw -B -q package)
+java -jar microbench/target/microbenchmarks.jar -prof gc -rf json -rff "$OUTPUT" "$@"
+
+if [ "$MODE" = "compare" ]; then
+  python3 - "$BASELINE" "$OUTPUT" <<'PYTHON'
+import json
+import sys
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for run in json.load(f):
+            params = ",".join("%s=%s" % kv for kv in sorted(run.get("params", {}).items()))
+            name = run["benchmark"] + ("[" + params + "]" if params else "")
+            results[name] = run["primaryMetric"]
+            alloc = run.get("secondaryMetrics", {}).get("·gc.alloc.rate.norm")
+            if alloc is not None:
+                results[name + " alloc"] = alloc
+    return results
+
+baseline = load(sys.argv[1])
+current = load(sys.argv[2])
+print("%-90s %15s %15s %8s" % ("Benchmark", "Baseline", "Current", "Change"))
+for name in sorted(current):
+    if name not in baseline:
+        continue
+    old = baseline[name]["score"]
+    new = current[name]["score"]
+    change = (new - old) / old * 100 if old else 0.0
+    print("%-90s %15.3f %15.3f %7.1f%% %s" % (name, old, new, change, current[name]["scoreUnit"]))
+PYTHON
+fi
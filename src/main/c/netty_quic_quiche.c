@@ -18,7 +18,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdio.h>
 #include <quiche.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 #include "netty_jni_util.h"
 
 // Add define if NETTY_BUILD_STATIC is defined so it is picked up in netty_jni_util.c
@@ -30,10 +35,25 @@
 #define QUICHE_CLASSNAME "io/netty/incubator/codec/quic/Quiche"
 #define LIBRARYNAME "netty_quiche"
 
-static jclass    quiche_logger_class;
-static jmethodID quiche_logger_class_log;
-static jobject   quiche_logger;
-static JavaVM     *global_vm = NULL;
+// The number of records in the log ring, must be a power of two.
+#define LOG_RING_SIZE 4096
+// The maximal length of a log record, longer lines are truncated.
+#define LOG_RECORD_LEN 256
+
+typedef struct {
+    // Sequence number of the record, used to hand it over between the producers and the consumer.
+    uint64_t sequence;
+    uint32_t len;
+    char data[LOG_RECORD_LEN];
+} log_record;
+
+static log_record* log_ring = NULL;
+// The next position that is claimed by a producer.
+static uint64_t log_ring_head = 0;
+// The next position that is drained by the consumer, only accessed by the thread that drains the ring.
+static uint64_t log_ring_tail = 0;
+// The number of records that were dropped because the ring was full.
+static uint64_t log_ring_dropped = 0;
 
 static jint netty_quiche_max_conn_id_len(JNIEnv* env, jclass clazz) {
     return QUICHE_MAX_CONN_ID_LEN;
@@ -132,6 +152,45 @@ static jint netty_quiche_header_info(JNIEnv* env, jclass clazz, jlong buf, jint
                                          (uint8_t *) token, (size_t *) token_len);
 }
 
+// Layout of one entry used by netty_quiche_header_info_batch(...).
+// This needs to be kept in sync with the offsets defined in Quiche.java.
+#define HEADER_INFO_BUF_OFFSET       0
+#define HEADER_INFO_BUF_LEN_OFFSET   8
+#define HEADER_INFO_RES_OFFSET       12
+#define HEADER_INFO_VERSION_OFFSET   16
+#define HEADER_INFO_TYPE_OFFSET      20
+#define HEADER_INFO_SCID_LEN_OFFSET  24
+#define HEADER_INFO_DCID_LEN_OFFSET  28
+#define HEADER_INFO_TOKEN_LEN_OFFSET 32
+#define HEADER_INFO_SCID_OFFSET      36
+#define HEADER_INFO_DCID_OFFSET      (HEADER_INFO_SCID_OFFSET + QUICHE_MAX_CONN_ID_LEN)
+#define HEADER_INFO_TOKEN_OFFSET     (HEADER_INFO_DCID_OFFSET + QUICHE_MAX_CONN_ID_LEN)
+
+static void netty_quiche_header_info_batch(JNIEnv* env, jclass clazz, jlong entries, jint num_entries,
+                                           jint entry_len, jint dcil) {
+    uint8_t* entry = (uint8_t *) entries;
+    size_t token_capacity = (size_t) entry_len - HEADER_INFO_TOKEN_OFFSET;
+
+    for (int i = 0; i < num_entries; i++, entry += entry_len) {
+        const uint8_t* buf = (const uint8_t *) *((int64_t *) (entry + HEADER_INFO_BUF_OFFSET));
+        size_t buf_len = (size_t) *((int32_t *) (entry + HEADER_INFO_BUF_LEN_OFFSET));
+        size_t scid_len = QUICHE_MAX_CONN_ID_LEN;
+        size_t dcid_len = QUICHE_MAX_CONN_ID_LEN;
+        size_t token_len = token_capacity;
+
+        int res = quiche_header_info(buf, buf_len, (size_t) dcil,
+                                     (uint32_t *) (entry + HEADER_INFO_VERSION_OFFSET),
+                                     entry + HEADER_INFO_TYPE_OFFSET,
+                                     entry + HEADER_INFO_SCID_OFFSET, &scid_len,
+                                     entry + HEADER_INFO_DCID_OFFSET, &dcid_len,
+                                     entry + HEADER_INFO_TOKEN_OFFSET, &token_len);
+        *((int32_t *) (entry + HEADER_INFO_RES_OFFSET)) = (int32_t) res;
+        *((int32_t *) (entry + HEADER_INFO_SCID_LEN_OFFSET)) = (int32_t) scid_len;
+        *((int32_t *) (entry + HEADER_INFO_DCID_LEN_OFFSET)) = (int32_t) dcid_len;
+        *((int32_t *) (entry + HEADER_INFO_TOKEN_LEN_OFFSET)) = (int32_t) token_len;
+    }
+}
+
 static jint netty_quiche_negotiate_version(JNIEnv* env, jclass clazz, jlong scid, jint scid_len, jlong dcid, jint dcid_len, jlong out, jint out_len) {
     return (jint) quiche_negotiate_version((const uint8_t *) scid, (size_t) scid_len,
                                                    (const uint8_t *) dcid, (size_t) dcid_len,
@@ -164,10 +223,89 @@ static jint netty_quiche_conn_recv(JNIEnv* env, jclass clazz, jlong conn, jlong
     return (jint) quiche_conn_recv((quiche_conn *) conn, (uint8_t *) buf, (size_t) buf_len);
 }
 
+// Flags that are part of the status returned by netty_quiche_conn_recv_and_poll(...).
+// This needs to be kept in sync with what is defined in Quiche.java.
+#define RECV_AND_POLL_ESTABLISHED   (((jlong) 1) << 32)
+#define RECV_AND_POLL_EARLY_DATA    (((jlong) 1) << 33)
+#define RECV_AND_POLL_CLOSED        (((jlong) 1) << 34)
+#define RECV_AND_POLL_TRUNCATED     (((jlong) 1) << 35)
+#define RECV_AND_POLL_STREAMS_SHIFT 40
+
+static jlong netty_quiche_conn_recv_and_poll(JNIEnv* env, jclass clazz, jlong conn, jlong buf, jint buf_len,
+                                             jlong stream_ids, jint max_stream_ids) {
+    quiche_conn* c = (quiche_conn *) conn;
+    int res = (int) quiche_conn_recv(c, (uint8_t *) buf, (size_t) buf_len);
+
+    // The lower 32 bits contain the result of quiche_conn_recv(...).
+    jlong status = (jlong) (uint32_t) res;
+    if (quiche_conn_is_closed(c)) {
+        return status | RECV_AND_POLL_CLOSED;
+    }
+    if (quiche_conn_is_established(c)) {
+        status |= RECV_AND_POLL_ESTABLISHED;
+    } else if (quiche_conn_is_in_early_data(c)) {
+        status |= RECV_AND_POLL_EARLY_DATA;
+    } else {
+        return status;
+    }
+    if (max_stream_ids <= 0) {
+        return status;
+    }
+
+    quiche_stream_iter* it = quiche_conn_readable(c);
+    if (it == NULL) {
+        return status;
+    }
+    uint64_t* ids = (uint64_t *) stream_ids;
+    jlong num = 0;
+    while (num < max_stream_ids && quiche_stream_iter_next(it, ids + num)) {
+        num++;
+    }
+    uint64_t ignore;
+    if (num == max_stream_ids && quiche_stream_iter_next(it, &ignore)) {
+        // There are more readable streams than we can store, the caller needs to fall back to use the iterator.
+        status |= RECV_AND_POLL_TRUNCATED;
+    }
+    quiche_stream_iter_free(it);
+    return status | (num << RECV_AND_POLL_STREAMS_SHIFT);
+}
+
 static jint netty_quiche_conn_send(JNIEnv* env, jclass clazz, jlong conn, jlong out, jint out_len) {
     return (jint) quiche_conn_send((quiche_conn *) conn, (uint8_t *) out, (size_t) out_len);
 }
 
+// Calls quiche_conn_send(...) until there is nothing left to send, max_packets packets were produced or the buffer
+// is full. The packets are written back-to-back in the out buffer, each one taking at most max_packet_len bytes and
+// their lengths are stored as int32_t in packet_lens.
+//
+// Returns the number of packets written or the error of the first quiche_conn_send(...) call if nothing was written.
+// If an error happens after some packets were written already these packets are returned and the error is reported
+// by the next call.
+static jint netty_quiche_conn_send_batch(JNIEnv* env, jclass clazz, jlong conn, jlong out, jint out_len,
+                                         jint max_packet_len, jlong packet_lens, jint max_packets) {
+    quiche_conn* c = (quiche_conn *) conn;
+    uint8_t* buf = (uint8_t *) out;
+    int32_t* lens = (int32_t *) packet_lens;
+    size_t remaining = (size_t) out_len;
+    size_t max_len = (size_t) max_packet_len;
+    int packets = 0;
+
+    while (packets < max_packets && remaining >= max_len) {
+        ssize_t written = quiche_conn_send(c, buf, max_len);
+        if (written < 0) {
+            return packets == 0 ? (jint) written : packets;
+        }
+        if (written == 0) {
+            // Nothing was produced, stop so we never spin without making progress.
+            return packets == 0 ? QUICHE_ERR_DONE : packets;
+        }
+        lens[packets++] = (int32_t) written;
+        buf += written;
+        remaining -= (size_t) written;
+    }
+    return packets;
+}
+
 static void netty_quiche_conn_free(JNIEnv* env, jclass clazz, jlong conn) {
     quiche_conn_free((quiche_conn *) conn);
 }
@@ -199,6 +337,51 @@ static jint netty_quiche_conn_stream_send(JNIEnv* env, jclass clazz, jlong conn,
     return (jint) quiche_conn_stream_send((quiche_conn *) conn, (uint64_t) stream_id,  (uint8_t *) buf, (size_t) buf_len, fin == JNI_TRUE ? true : false);
 }
 
+// Each entry of the iov array consists of the address and the length of the memory region, both stored as int64.
+static jint netty_quiche_conn_stream_send_iov(JNIEnv* env, jclass clazz, jlong conn, jlong stream_id, jlong iov,
+                                              jint iov_count, jboolean fin) {
+    const int64_t* entries = (const int64_t *) iov;
+    jint written = 0;
+    for (int i = 0; i < iov_count; i++) {
+        const uint8_t* buf = (const uint8_t *) entries[i * 2];
+        size_t buf_len = (size_t) entries[i * 2 + 1];
+        bool last_fin = fin == JNI_TRUE && i == iov_count - 1;
+        ssize_t res = quiche_conn_stream_send((quiche_conn *) conn, (uint64_t) stream_id, buf, buf_len, last_fin);
+        if (res < 0) {
+            // Only return the error if nothing was written yet, the caller will see it again on the next call.
+            return written > 0 ? written : (jint) res;
+        }
+        written += (jint) res;
+        if ((size_t) res < buf_len) {
+            // No capacity left for this stream.
+            break;
+        }
+    }
+    return written;
+}
+
+// Returned by netty_quiche_conn_stream_send_array(...) if the array could not be accessed. This is distinct from all
+// the QUICHE_ERR_* codes and needs to be kept in sync with what is defined in Quiche.java.
+#define NETTY_QUIC_ERR_OUT_OF_MEMORY INT32_MIN
+
+static jint netty_quiche_conn_stream_send_array(JNIEnv* env, jclass clazz, jlong conn, jlong stream_id,
+                                                jbyteArray array, jint offset, jint len, jboolean fin) {
+    // Access the array directly if the JVM allows it, which saves us a copy to direct memory.
+    uint8_t* buf = (uint8_t *) (*env)->GetPrimitiveArrayCritical(env, array, NULL);
+    if (buf == NULL) {
+        return NETTY_QUIC_ERR_OUT_OF_MEMORY;
+    }
+    ssize_t res = quiche_conn_stream_send((quiche_conn *) conn, (uint64_t) stream_id, buf + offset, (size_t) len,
+                                          fin == JNI_TRUE ? true : false);
+    // We did not modify the array so there is no need to copy back anything.
+    (*env)->ReleasePrimitiveArrayCritical(env, array, buf, JNI_ABORT);
+    return (jint) res;
+}
+
+static jint netty_quiche_conn_stream_priority(JNIEnv* env, jclass clazz, jlong conn, jlong stream_id, jbyte urgency, jboolean incremental) {
+    return (jint) quiche_conn_stream_priority((quiche_conn *) conn, (uint64_t) stream_id, (uint8_t) urgency, incremental == JNI_TRUE ? true : false);
+}
+
 static jint netty_quiche_conn_stream_shutdown(JNIEnv* env, jclass clazz, jlong conn, jlong stream_id, jint direction, jlong err) {
     return (jint) quiche_conn_stream_shutdown((quiche_conn *) conn, (uint64_t) stream_id,  (enum quiche_shutdown) direction, (uint64_t) err);
 }
@@ -244,25 +427,84 @@ static jboolean netty_quiche_conn_is_closed(JNIEnv* env, jclass clazz, jlong con
     return quiche_conn_is_closed((quiche_conn *) conn) == true ? JNI_TRUE : JNI_FALSE;
 }
 
-static jlongArray netty_quiche_conn_stats(JNIEnv* env, jclass clazz, jlong conn) {
+static void netty_quiche_conn_stats(JNIEnv* env, jclass clazz, jlong conn, jlong stats_addr) {
     quiche_stats stats = {0,0,0,0,0,0};
     quiche_conn_stats((quiche_conn *) conn, &stats);
 
-    jlongArray statsArray = (*env)->NewLongArray(env, 6);
-    if (statsArray == NULL) {
-        // This will put an OOME on the stack
-        return NULL;
+    // Write directly into the memory that was provided by the caller so we not need to create a new array.
+    int64_t* out = (int64_t*) stats_addr;
+    out[0] = (int64_t) stats.recv;
+    out[1] = (int64_t) stats.sent;
+    out[2] = (int64_t) stats.lost;
+    out[3] = (int64_t) stats.rtt;
+    out[4] = (int64_t) stats.cwnd;
+    out[5] = (int64_t) stats.delivery_rate;
+}
+
+// quiche 0.6.0 has no API to get / set the TLS session of a connection, so session resumption is only supported if
+// we are compiled against a quiche version that has it and NETTY_QUIC_SESSION_RESUMPTION is defined.
+static jboolean netty_quiche_session_resumption_supported(JNIEnv* env, jclass clazz) {
+#ifdef NETTY_QUIC_SESSION_RESUMPTION
+    return JNI_TRUE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+static jint netty_quiche_conn_session(JNIEnv* env, jclass clazz, jlong conn, jlong buf, jint buf_len) {
+#ifdef NETTY_QUIC_SESSION_RESUMPTION
+    const uint8_t* out = NULL;
+    size_t out_len = 0;
+    quiche_conn_session((quiche_conn *) conn, &out, &out_len);
+    if (out == NULL || out_len == 0) {
+        return QUICHE_ERR_DONE;
+    }
+    if (out_len > (size_t) buf_len) {
+        return QUICHE_ERR_BUFFER_TOO_SHORT;
+    }
+    memcpy((uint8_t *) buf, out, out_len);
+    return (jint) out_len;
+#else
+    return QUICHE_ERR_DONE;
+#endif
+}
+
+static jint netty_quiche_conn_set_session(JNIEnv* env, jclass clazz, jlong conn, jlong buf, jint buf_len) {
+#ifdef NETTY_QUIC_SESSION_RESUMPTION
+    return (jint) quiche_conn_set_session((quiche_conn *) conn, (const uint8_t *) buf, (size_t) buf_len);
+#else
+    return QUICHE_ERR_DONE;
+#endif
+}
+
+// quiche only exposes qlog via the C API when it was built with the qlog feature, so it is only supported if
+// NETTY_QUIC_QLOG is defined.
+static jboolean netty_quiche_conn_set_qlog_path(JNIEnv* env, jclass clazz, jlong conn, jstring path,
+                                                jstring log_title, jstring log_desc) {
+#ifdef NETTY_QUIC_QLOG
+    const char* path_str = (*env)->GetStringUTFChars(env, path, 0);
+    if (path_str == NULL) {
+        return JNI_FALSE;
     }
-    jlong statsArrayElements[] = {
-        (jlong)stats.recv,
-        (jlong)stats.sent,
-        (jlong)stats.lost,
-        (jlong)stats.rtt,
-        (jlong)stats.cwnd,
-        (jlong)stats.delivery_rate,
-    };
-    (*env)->SetLongArrayRegion(env, statsArray, 0, 6, statsArrayElements);
-    return statsArray;
+    const char* title_str = (*env)->GetStringUTFChars(env, log_title, 0);
+    if (title_str == NULL) {
+        (*env)->ReleaseStringUTFChars(env, path, path_str);
+        return JNI_FALSE;
+    }
+    const char* desc_str = (*env)->GetStringUTFChars(env, log_desc, 0);
+    if (desc_str == NULL) {
+        (*env)->ReleaseStringUTFChars(env, path, path_str);
+        (*env)->ReleaseStringUTFChars(env, log_title, title_str);
+        return JNI_FALSE;
+    }
+    bool ret = quiche_conn_set_qlog_path((quiche_conn *) conn, path_str, title_str, desc_str);
+    (*env)->ReleaseStringUTFChars(env, path, path_str);
+    (*env)->ReleaseStringUTFChars(env, log_title, title_str);
+    (*env)->ReleaseStringUTFChars(env, log_desc, desc_str);
+    return ret ? JNI_TRUE : JNI_FALSE;
+#else
+    return JNI_FALSE;
+#endif
 }
 
 static jlong netty_quiche_conn_timeout_as_nanos(JNIEnv* env, jclass clazz, jlong conn) {
@@ -281,33 +523,43 @@ static jlong netty_quiche_conn_readable(JNIEnv* env, jclass clazz, jlong conn) {
     return (jlong) iter;
 }
 
+static jlong netty_quiche_conn_writable(JNIEnv* env, jclass clazz, jlong conn) {
+    quiche_stream_iter* iter = quiche_conn_writable((quiche_conn *) conn);
+    if (iter == NULL) {
+        return -1;
+    }
+    return (jlong) iter;
+}
+
 static void netty_quiche_stream_iter_free(JNIEnv* env, jclass clazz, jlong iter) {
     quiche_stream_iter_free((quiche_stream_iter*) iter);
 }
 
-static jint netty_quiche_stream_iter_next(JNIEnv* env, jclass clazz, jlong iter, jlongArray streams) {
+static jint netty_quiche_stream_iter_next(JNIEnv* env, jclass clazz, jlong iter, jlong streams, jint len) {
     quiche_stream_iter* it = (quiche_stream_iter*) iter;
     if (it == NULL) {
         return 0;
     }
-    int len = (*env)->GetArrayLength(env, streams);
-    if (len == 0) {
-        return 0;
-    }
-    jlong* elements = (*env)->GetLongArrayElements(env, streams, NULL);
+    uint64_t* elements = (uint64_t *) streams;
     int i = 0;
-    while (i < len && quiche_stream_iter_next(it, (uint64_t*) elements + i)) {
+    while (i < len && quiche_stream_iter_next(it, elements + i)) {
         i++;
     }
-    (*env)->ReleaseLongArrayElements(env, streams, elements, 0);
     return i;
 }
 
-
 static jint netty_quiche_conn_dgram_max_writable_len(JNIEnv* env, jclass clazz, jlong conn) {
     return (jint) quiche_conn_dgram_max_writable_len((quiche_conn *) conn);
 }
 
+static jint netty_quiche_conn_dgram_recv(JNIEnv* env, jclass clazz, jlong conn, jlong buf, jint buf_len) {
+    return (jint) quiche_conn_dgram_recv((quiche_conn *) conn, (uint8_t *) buf, (size_t) buf_len);
+}
+
+static jint netty_quiche_conn_dgram_send(JNIEnv* env, jclass clazz, jlong conn, jlong buf, jint buf_len) {
+    return (jint) quiche_conn_dgram_send((quiche_conn *) conn, (const uint8_t *) buf, (size_t) buf_len);
+}
+
 static jlong netty_quiche_config_new(JNIEnv* env, jclass clazz, jint version) {
     quiche_config* config = quiche_config_new((uint32_t) version);
     return config == NULL ? -1 : (jlong) config;
@@ -333,6 +585,70 @@ static jint netty_quiche_config_load_priv_key_from_pem_file(JNIEnv* env, jclass
     return res;
 }
 
+// Returned by the *_from_pem(...) functions if the PEM can not be loaded from memory on this platform.
+// This needs to be kept in sync with what is defined in Quiche.java.
+#define NETTY_QUIC_PEM_FROM_MEMORY_UNSUPPORTED 1
+
+// Copies the given PEM into an anonymous memory file and returns its descriptor, or -1 if this is not supported.
+// quiche 0.6.0 can only load certificates and keys from a path, so this way the PEM never touches the file system.
+static int netty_quiche_pem_memfd(JNIEnv* env, jbyteArray pem) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    // MFD_CLOEXEC, which is not defined by older headers.
+    int fd = (int) syscall(SYS_memfd_create, "netty-quic-pem", 1U);
+    if (fd < 0) {
+        return -1;
+    }
+    jsize len = (*env)->GetArrayLength(env, pem);
+    jbyte* bytes = (*env)->GetByteArrayElements(env, pem, NULL);
+    if (bytes == NULL) {
+        close(fd);
+        return -1;
+    }
+    jsize offset = 0;
+    while (offset < len) {
+        ssize_t res = write(fd, bytes + offset, (size_t) (len - offset));
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        offset += (jsize) res;
+    }
+    (*env)->ReleaseByteArrayElements(env, pem, bytes, JNI_ABORT);
+    if (offset < len) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+static jint netty_quiche_config_load_from_pem(JNIEnv* env, jlong config, jbyteArray pem, int key) {
+    int fd = netty_quiche_pem_memfd(env, pem);
+    if (fd < 0) {
+        return NETTY_QUIC_PEM_FROM_MEMORY_UNSUPPORTED;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    int res = key ? quiche_config_load_priv_key_from_pem_file((quiche_config*) config, path) :
+            quiche_config_load_cert_chain_from_pem_file((quiche_config*) config, path);
+#ifdef __linux__
+    close(fd);
+#endif
+    return res;
+}
+
+static jint netty_quiche_config_load_cert_chain_from_pem(JNIEnv* env, jclass clazz, jlong config, jbyteArray pem) {
+    return netty_quiche_config_load_from_pem(env, config, pem, 0);
+}
+
+static jint netty_quiche_config_load_priv_key_from_pem(JNIEnv* env, jclass clazz, jlong config, jbyteArray pem) {
+    return netty_quiche_config_load_from_pem(env, config, pem, 1);
+}
+
 static void netty_quiche_config_verify_peer(JNIEnv* env, jclass clazz, jlong config, jboolean value) {
     quiche_config_verify_peer((quiche_config*) config, value == JNI_TRUE ? true : false);
 }
@@ -406,36 +722,97 @@ static void netty_quiche_config_enable_hystart(JNIEnv* env, jclass clazz, jlong
     quiche_config_enable_hystart((quiche_config*) config, value == JNI_TRUE ? true : false);
 }
 
+static void netty_quiche_config_enable_dgram(JNIEnv* env, jclass clazz, jlong config, jboolean enabled,
+                                             jint recv_queue_len, jint send_queue_len) {
+    quiche_config_enable_dgram((quiche_config*) config, enabled == JNI_TRUE ? true : false,
+                               (size_t) recv_queue_len, (size_t) send_queue_len);
+}
+
 static void netty_quiche_config_free(JNIEnv* env, jclass clazz, jlong config) {
     quiche_config_free((quiche_config*) config);
 }
 
-static void log_to_java(const char *line, void *argp) {
-    JNIEnv* env = NULL;
-    if (global_vm == NULL || line == NULL) {
+// Called by quiche for every log line, possibly from multiple threads at the same time. This must be cheap as it is
+// on the packet path, so we only copy the line into the ring (a bounded MPSC queue) and let Java drain it later. If
+// the ring is full the line is dropped.
+static void log_to_ring(const char *line, void *argp) {
+    if (line == NULL) {
         return;
     }
-    if ((*global_vm)->GetEnv(global_vm, (void **) &env, NETTY_JNI_UTIL_JNI_VERSION) != JNI_OK) {
-        return;
+    log_record* record;
+    uint64_t pos = __atomic_load_n(&log_ring_head, __ATOMIC_RELAXED);
+    for (;;) {
+        record = &log_ring[pos & (LOG_RING_SIZE - 1)];
+        uint64_t seq = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t) seq - (int64_t) pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&log_ring_head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The consumer did not drain the record yet, the ring is full.
+            __atomic_fetch_add(&log_ring_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&log_ring_head, __ATOMIC_RELAXED);
+        }
+    }
+    size_t len = strlen(line);
+    if (len > LOG_RECORD_LEN) {
+        len = LOG_RECORD_LEN;
     }
+    memcpy(record->data, line, len);
+    record->len = (uint32_t) len;
+    // Publish the record to the consumer.
+    __atomic_store_n(&record->sequence, pos + 1, __ATOMIC_RELEASE);
+}
 
-    jstring message =  (*env)->NewStringUTF(env, line);
-    if (message == NULL) {
-        // out of memory.
-        return;
+static jboolean netty_quiche_enable_debug_logging(JNIEnv* env, jclass clazz) {
+    if (log_ring != NULL) {
+        return JNI_FALSE;
+    }
+    // The ring is never freed as quiche has no way to disable logging again.
+    log_ring = malloc(sizeof(log_record) * LOG_RING_SIZE);
+    if (log_ring == NULL) {
+        return JNI_FALSE;
     }
-    (*env)->CallVoidMethod(env, quiche_logger, quiche_logger_class_log, message);
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++) {
+        log_ring[i].sequence = i;
+    }
+    quiche_enable_debug_logging(log_to_ring, NULL);
+    return JNI_TRUE;
 }
 
-static void netty_quiche_enable_debug_logging(JNIEnv* env, jclass clazz, jobject logger) {
-    if (quiche_logger != NULL) {
-        return;
+// Copies as many records as fit into buf, each one prefixed by its length as an int. Returns the number of bytes
+// written. Must only be called from one thread at a time.
+static jint netty_quiche_log_drain(JNIEnv* env, jclass clazz, jlong buf, jint buf_len) {
+    if (log_ring == NULL) {
+        return 0;
     }
-    if ((quiche_logger = (*env)->NewGlobalRef(env, logger)) == NULL) {
-        return;
+    uint8_t* out = (uint8_t *) buf;
+    jint written = 0;
+    for (;;) {
+        log_record* record = &log_ring[log_ring_tail & (LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != log_ring_tail + 1) {
+            // Nothing was published yet.
+            break;
+        }
+        int32_t len = (int32_t) record->len;
+        if (buf_len - written < (jint) sizeof(int32_t) + len) {
+            break;
+        }
+        memcpy(out + written, &len, sizeof(int32_t));
+        memcpy(out + written + sizeof(int32_t), record->data, len);
+        written += sizeof(int32_t) + len;
+        // Hand the record back to the producers.
+        __atomic_store_n(&record->sequence, log_ring_tail + LOG_RING_SIZE, __ATOMIC_RELEASE);
+        log_ring_tail++;
     }
+    return written;
+}
 
-    quiche_enable_debug_logging(log_to_java, NULL);
+static jlong netty_quiche_log_dropped(JNIEnv* env, jclass clazz) {
+    return (jlong) __atomic_load_n(&log_ring_dropped, __ATOMIC_RELAXED);
 }
 
 static jlong netty_buffer_memory_address(JNIEnv* env, jclass clazz, jobject buffer) {
@@ -473,17 +850,23 @@ static const JNINativeMethod fixed_method_table[] = {
   { "quiche_version", "()Ljava/lang/String;", (void *) netty_quiche_version },
   { "quiche_version_is_supported", "(I)Z", (void *) netty_quiche_version_is_supported },
   { "quiche_header_info", "(JIIJJJJJJJJ)I", (void *) netty_quiche_header_info },
+  { "quiche_header_info_batch", "(JIII)V", (void *) netty_quiche_header_info_batch },
   { "quiche_negotiate_version", "(JIJIJI)I", (void *) netty_quiche_negotiate_version },
   { "quiche_retry", "(JIJIJIJIIJI)I", (void *) netty_quiche_retry },
   { "quiche_accept", "(JIJIJ)J", (void *) netty_quiche_accept },
   { "quiche_accept_no_token", "(JIJ)J", (void *) netty_quiche_accept_no_token },
   { "quiche_conn_recv", "(JJI)I", (void *) netty_quiche_conn_recv },
+  { "quiche_conn_recv_and_poll", "(JJIJI)J", (void *) netty_quiche_conn_recv_and_poll },
   { "quiche_conn_send", "(JJI)I", (void *) netty_quiche_conn_send },
+  { "quiche_conn_send_batch", "(JJIIJI)I", (void *) netty_quiche_conn_send_batch },
   { "quiche_conn_free", "(J)V", (void *) netty_quiche_conn_free },
   { "quiche_connect", "(Ljava/lang/String;JIJ)J", (void *) netty_quiche_connect },
   { "quiche_conn_stream_recv", "(JJJIJ)I", (void *) netty_quiche_conn_stream_recv },
   { "quiche_conn_stream_send", "(JJJIZ)I", (void *) netty_quiche_conn_stream_send },
+  { "quiche_conn_stream_send_iov", "(JJJIZ)I", (void *) netty_quiche_conn_stream_send_iov },
+  { "quiche_conn_stream_send_array", "(JJ[BIIZ)I", (void *) netty_quiche_conn_stream_send_array },
   { "quiche_conn_stream_shutdown", "(JJIJ)I", (void *) netty_quiche_conn_stream_shutdown },
+  { "quiche_conn_stream_priority", "(JJBZ)I", (void *) netty_quiche_conn_stream_priority },
   { "quiche_conn_stream_capacity", "(JJ)I", (void *) netty_quiche_conn_stream_capacity },
   { "quiche_conn_stream_finished", "(JJ)Z", (void *) netty_quiche_conn_stream_finished },
   { "quiche_conn_application_proto", "(J)[B", (void *) netty_quiche_conn_application_proto },
@@ -491,16 +874,25 @@ static const JNINativeMethod fixed_method_table[] = {
   { "quiche_conn_is_established", "(J)Z", (void *) netty_quiche_conn_is_established },
   { "quiche_conn_is_in_early_data", "(J)Z", (void *) netty_quiche_conn_is_in_early_data },
   { "quiche_conn_is_closed", "(J)Z", (void *) netty_quiche_conn_is_closed },
-  { "quiche_conn_stats", "(J)[J", (void *) netty_quiche_conn_stats },
+  { "quiche_conn_stats", "(JJ)V", (void *) netty_quiche_conn_stats },
+  { "quiche_session_resumption_supported", "()Z", (void *) netty_quiche_session_resumption_supported },
+  { "quiche_conn_session", "(JJI)I", (void *) netty_quiche_conn_session },
+  { "quiche_conn_set_session", "(JJI)I", (void *) netty_quiche_conn_set_session },
+  { "quiche_conn_set_qlog_path", "(JLjava/lang/String;Ljava/lang/String;Ljava/lang/String;)Z", (void *) netty_quiche_conn_set_qlog_path },
   { "quiche_conn_timeout_as_nanos", "(J)J", (void *) netty_quiche_conn_timeout_as_nanos },
   { "quiche_conn_on_timeout", "(J)V", (void *) netty_quiche_conn_on_timeout },
   { "quiche_conn_readable", "(J)J", (void *) netty_quiche_conn_readable },
+  { "quiche_conn_writable", "(J)J", (void *) netty_quiche_conn_writable },
   { "quiche_stream_iter_free", "(J)V", (void *) netty_quiche_stream_iter_free },
-  { "quiche_stream_iter_next", "(J[J)I", (void *) netty_quiche_stream_iter_next },
+  { "quiche_stream_iter_next", "(JJI)I", (void *) netty_quiche_stream_iter_next },
   { "quiche_conn_dgram_max_writable_len", "(J)I", (void* ) netty_quiche_conn_dgram_max_writable_len },
+  { "quiche_conn_dgram_recv", "(JJI)I", (void* ) netty_quiche_conn_dgram_recv },
+  { "quiche_conn_dgram_send", "(JJI)I", (void* ) netty_quiche_conn_dgram_send },
   { "quiche_config_new", "(I)J", (void *) netty_quiche_config_new },
   { "quiche_config_load_cert_chain_from_pem_file", "(JLjava/lang/String;)I", (void *) netty_quiche_config_load_cert_chain_from_pem_file },
   { "quiche_config_load_priv_key_from_pem_file", "(JLjava/lang/String;)I", (void *) netty_quiche_config_load_priv_key_from_pem_file },
+  { "quiche_config_load_cert_chain_from_pem", "(J[B)I", (void *) netty_quiche_config_load_cert_chain_from_pem },
+  { "quiche_config_load_priv_key_from_pem", "(J[B)I", (void *) netty_quiche_config_load_priv_key_from_pem },
   { "quiche_config_verify_peer", "(JZ)V", (void *) netty_quiche_config_verify_peer },
   { "quiche_config_grease", "(JZ)V", (void *) netty_quiche_config_grease },
   { "quiche_config_enable_early_data", "(J)V", (void *) netty_quiche_config_enable_early_data },
@@ -518,18 +910,21 @@ static const JNINativeMethod fixed_method_table[] = {
   { "quiche_config_set_disable_active_migration", "(JZ)V", (void *) netty_quiche_config_set_disable_active_migration },
   { "quiche_config_set_cc_algorithm", "(JI)V", (void *) netty_quiche_config_set_cc_algorithm },
   { "quiche_config_enable_hystart", "(JZ)V", (void *) netty_quiche_config_enable_hystart },
+  { "quiche_config_enable_dgram", "(JZII)V", (void *) netty_quiche_config_enable_dgram },
   { "quiche_config_free", "(J)V", (void *) netty_quiche_config_free },
+  { "quiche_enable_debug_logging", "()Z", (void *) netty_quiche_enable_debug_logging },
+  { "quiche_log_drain", "(JI)I", (void *) netty_quiche_log_drain },
+  { "quiche_log_dropped", "()J", (void *) netty_quiche_log_dropped },
   { "buffer_memory_address", "(Ljava/nio/ByteBuffer;)J", (void *) netty_buffer_memory_address}
 };
 
 static const jint fixed_method_table_size = sizeof(fixed_method_table) / sizeof(fixed_method_table[0]);
 
 static jint dynamicMethodsTableSize() {
-    return fixed_method_table_size + 1;
+    return fixed_method_table_size;
 }
 
 static JNINativeMethod* createDynamicMethodsTable(const char* packagePrefix) {
-    char* dynamicTypeName = NULL;
     int len = sizeof(JNINativeMethod) * dynamicMethodsTableSize();
     JNINativeMethod* dynamicMethods = malloc(len);
     if (dynamicMethods == NULL) {
@@ -537,17 +932,8 @@ static JNINativeMethod* createDynamicMethodsTable(const char* packagePrefix) {
     }
     memset(dynamicMethods, 0, len);
     memcpy(dynamicMethods, fixed_method_table, sizeof(fixed_method_table));
-
-    JNINativeMethod* dynamicMethod = &dynamicMethods[fixed_method_table_size];
-    NETTY_JNI_UTIL_PREPEND(packagePrefix, "io/netty/incubator/codec/quic/QuicheLogger;)V", dynamicTypeName, error);
-    NETTY_JNI_UTIL_PREPEND("(L", dynamicTypeName,  dynamicMethod->signature, error);
-    netty_jni_util_free_dynamic_name(&dynamicTypeName);
-    dynamicMethod->name = "quiche_enable_debug_logging";
-    dynamicMethod->fnPtr = (void *) netty_quiche_enable_debug_logging;
     return dynamicMethods;
 error:
-    netty_jni_util_free_dynamic_methods_table(dynamicMethods, fixed_method_table_size, dynamicMethodsTableSize());
-    free(dynamicTypeName);
     return NULL;
 }
 
@@ -557,7 +943,6 @@ static jint netty_quiche_JNI_OnLoad(JNIEnv* env, const char* packagePrefix) {
     int ret = JNI_ERR;
     int staticallyRegistered = 0;
     int nativeRegistered = 0;
-    char* name = NULL;
 
     // We must register the statically referenced methods first!
     if (netty_jni_util_register_natives(env,
@@ -581,10 +966,6 @@ static jint netty_quiche_JNI_OnLoad(JNIEnv* env, const char* packagePrefix) {
         goto done;
     }
     nativeRegistered = 1;
-
-    NETTY_JNI_UTIL_PREPEND(packagePrefix, "io/netty/incubator/codec/quic/QuicheLogger", name, done);
-    NETTY_JNI_UTIL_LOAD_CLASS(env, quiche_logger_class, name, done);
-    NETTY_JNI_UTIL_GET_METHOD(env, quiche_logger_class, quiche_logger_class_log, "log", "(Ljava/lang/String;)V", done);
     // Initialize this module
 
     ret = NETTY_JNI_UTIL_JNI_VERSION;
@@ -596,23 +977,14 @@ done:
         if (nativeRegistered == 1) {
             netty_jni_util_unregister_natives(env, packagePrefix, QUICHE_CLASSNAME);
         }
-
-        NETTY_JNI_UTIL_UNLOAD_CLASS(env, quiche_logger_class);
         netty_jni_util_free_dynamic_methods_table(dynamicMethods, fixed_method_table_size, dynamicMethodsTableSize());
     }
     return ret;
 }
 
 static void netty_quiche_JNI_OnUnload(JNIEnv* env, const char* packagePrefix) {
-    NETTY_JNI_UTIL_UNLOAD_CLASS(env, quiche_logger_class);
-
     netty_jni_util_unregister_natives(env, packagePrefix, STATICALLY_CLASSNAME);
     netty_jni_util_unregister_natives(env, packagePrefix, QUICHE_CLASSNAME);
-
-    if (quiche_logger != NULL) {
-        (*env)->DeleteGlobalRef(env, quiche_logger);
-        quiche_logger = NULL;
-    }
 }
 
 // Invoked by the JVM when statically linked
@@ -622,24 +994,20 @@ static void netty_quiche_JNI_OnUnload(JNIEnv* env, const char* packagePrefix) {
 
 // Invoked by the JVM when statically linked
 JNIEXPORT jint JNI_OnLoad_netty_quiche(JavaVM* vm, void* reserved) {
-    global_vm = vm;
     return netty_jni_util_JNI_OnLoad(vm, reserved, LIBRARYNAME, netty_quiche_JNI_OnLoad);
 }
 
 // Invoked by the JVM when statically linked
 JNIEXPORT void JNI_OnUnload_netty_quiche(JavaVM* vm, void* reserved) {
     netty_jni_util_JNI_OnUnload(vm, reserved, netty_quiche_JNI_OnUnload);
-    global_vm = NULL;
 }
 
 #ifndef NETTY_BUILD_STATIC
 JNIEXPORT jint JNI_OnLoad(JavaVM* vm, void* reserved) {
-    global_vm = vm;
     return netty_jni_util_JNI_OnLoad(vm, reserved, LIBRARYNAME, netty_quiche_JNI_OnLoad);
 }
 
 JNIEXPORT void JNI_OnUnload(JavaVM* vm, void* reserved) {
     netty_jni_util_JNI_OnUnload(vm, reserved, netty_quiche_JNI_OnUnload);
-    global_vm = NULL;
 }
 #endif /* NETTY_BUILD_STATIC */
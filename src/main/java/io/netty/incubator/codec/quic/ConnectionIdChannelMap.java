@@ -0,0 +1,301 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.util.internal.MathUtil;
+
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+
+/**
+ * Open-addressing hash table that maps connection ids to {@link QuicheQuicChannel}s. Connection ids of up to
+ * {@link #MAX_CONNECTION_ID_LENGTH} bytes are stored inline in a {@code long[]}, so neither lookups nor inserts
+ * allocate and lookups can be done directly on the {@link ByteBuf} that holds the parsed connection id.
+ *
+ * Collisions are resolved via linear probing and entries are removed via backward-shift deletion, so no tombstones
+ * are needed. The same {@link QuicheQuicChannel} may be stored for multiple connection ids.
+ *
+ * This class is not thread-safe and so should only be used from the {@link io.netty.channel.EventLoop}.
+ */
+final class ConnectionIdChannelMap {
+    // This needs to be at least Quiche.QUICHE_MAX_CONN_ID_LEN and is enough for all QUIC versions.
+    static final int MAX_CONNECTION_ID_LENGTH = 20;
+
+    // Each key uses 3 longs. The first 20 bytes hold the connection id (little endian) and the last byte the length.
+    private static final int KEY_WORDS = 3;
+    private static final int LENGTH_SHIFT = 56;
+    private static final int DEFAULT_CAPACITY = 64;
+
+    private long[] keys;
+    private QuicheQuicChannel[] values;
+    private int mask;
+    private int size;
+
+    // Scratch space that is used to encode the key that should be looked up.
+    private long key0;
+    private long key1;
+    private long key2;
+
+    ConnectionIdChannelMap() {
+        this(DEFAULT_CAPACITY);
+    }
+
+    ConnectionIdChannelMap(int initialCapacity) {
+        allocate(MathUtil.safeFindNextPositivePowerOfTwo(Math.max(initialCapacity, 2) * 2));
+    }
+
+    private void allocate(int capacity) {
+        keys = new long[capacity * KEY_WORDS];
+        values = new QuicheQuicChannel[capacity];
+        mask = capacity - 1;
+    }
+
+    /**
+     * Returns the number of connection ids that are stored.
+     */
+    int size() {
+        return size;
+    }
+
+    boolean isEmpty() {
+        return size == 0;
+    }
+
+    /**
+     * Returns the {@link QuicheQuicChannel} for the readable bytes of the given connection id or {@code null} if
+     * there is none.
+     */
+    QuicheQuicChannel get(ByteBuf connectionId) {
+        if (!encode(connectionId)) {
+            return null;
+        }
+        int idx = find();
+        return idx == -1 ? null : values[idx];
+    }
+
+    /**
+     * Returns the {@link QuicheQuicChannel} for the remaining bytes of the given connection id or {@code null} if
+     * there is none.
+     */
+    QuicheQuicChannel get(ByteBuffer connectionId) {
+        if (!encode(connectionId)) {
+            return null;
+        }
+        int idx = find();
+        return idx == -1 ? null : values[idx];
+    }
+
+    /**
+     * Stores the {@link QuicheQuicChannel} for the readable bytes of the given connection id and returns the previous
+     * stored {@link QuicheQuicChannel} (if any).
+     */
+    QuicheQuicChannel put(ByteBuf connectionId, QuicheQuicChannel channel) {
+        checkEncoded(encode(connectionId), connectionId.readableBytes());
+        return put(channel);
+    }
+
+    /**
+     * Stores the {@link QuicheQuicChannel} for the remaining bytes of the given connection id and returns the
+     * previous stored {@link QuicheQuicChannel} (if any).
+     */
+    QuicheQuicChannel put(ByteBuffer connectionId, QuicheQuicChannel channel) {
+        checkEncoded(encode(connectionId), connectionId.remaining());
+        return put(channel);
+    }
+
+    /**
+     * Removes the mapping for the remaining bytes of the given connection id and returns the
+     * {@link QuicheQuicChannel} that was stored for it (if any).
+     */
+    QuicheQuicChannel remove(ByteBuffer connectionId) {
+        if (!encode(connectionId)) {
+            return null;
+        }
+        int idx = find();
+        if (idx == -1) {
+            return null;
+        }
+        QuicheQuicChannel old = values[idx];
+        removeAt(idx);
+        return old;
+    }
+
+    /**
+     * Returns the capacity of the table. Together with {@link #valueAt(int)} this allows to iterate over all
+     * stored {@link QuicheQuicChannel}s without creating garbage.
+     */
+    int capacity() {
+        return values.length;
+    }
+
+    /**
+     * Returns the {@link QuicheQuicChannel} that is stored in the given slot or {@code null} if the slot is empty.
+     */
+    QuicheQuicChannel valueAt(int slot) {
+        return values[slot];
+    }
+
+    void clear() {
+        Arrays.fill(keys, 0);
+        Arrays.fill(values, null);
+        size = 0;
+    }
+
+    private static void checkEncoded(boolean encoded, int length) {
+        if (!encoded) {
+            throw new IllegalArgumentException("connection id length: " + length +
+                    " (expected: <= " + MAX_CONNECTION_ID_LENGTH + ')');
+        }
+    }
+
+    private QuicheQuicChannel put(QuicheQuicChannel channel) {
+        int idx = find();
+        if (idx != -1) {
+            QuicheQuicChannel old = values[idx];
+            values[idx] = channel;
+            return old;
+        }
+        if ((size + 1) * 2 > values.length) {
+            resize();
+        }
+        insert(key0, key1, key2, channel);
+        size++;
+        return null;
+    }
+
+    private void insert(long k0, long k1, long k2, QuicheQuicChannel channel) {
+        int idx = hash(k0, k1, k2) & mask;
+        while (values[idx] != null) {
+            idx = (idx + 1) & mask;
+        }
+        int offset = idx * KEY_WORDS;
+        keys[offset] = k0;
+        keys[offset + 1] = k1;
+        keys[offset + 2] = k2;
+        values[idx] = channel;
+    }
+
+    private void resize() {
+        long[] oldKeys = keys;
+        QuicheQuicChannel[] oldValues = values;
+        allocate(oldValues.length * 2);
+        for (int i = 0; i < oldValues.length; i++) {
+            QuicheQuicChannel channel = oldValues[i];
+            if (channel != null) {
+                int offset = i * KEY_WORDS;
+                insert(oldKeys[offset], oldKeys[offset + 1], oldKeys[offset + 2], channel);
+            }
+        }
+    }
+
+    // Returns the slot of the encoded key or -1 if it is not stored.
+    private int find() {
+        long k0 = key0;
+        long k1 = key1;
+        long k2 = key2;
+        int idx = hash(k0, k1, k2) & mask;
+        for (;;) {
+            if (values[idx] == null) {
+                return -1;
+            }
+            int offset = idx * KEY_WORDS;
+            if (keys[offset] == k0 && keys[offset + 1] == k1 && keys[offset + 2] == k2) {
+                return idx;
+            }
+            idx = (idx + 1) & mask;
+        }
+    }
+
+    private void removeAt(int idx) {
+        values[idx] = null;
+        size--;
+
+        // Shift back all following entries of the same cluster that are not in their ideal slot anymore.
+        int free = idx;
+        int next = (idx + 1) & mask;
+        while (values[next] != null) {
+            int offset = next * KEY_WORDS;
+            int ideal = hash(keys[offset], keys[offset + 1], keys[offset + 2]) & mask;
+            // Move the entry if its ideal slot is not cyclically in (free, next].
+            if (((next - ideal) & mask) >= ((next - free) & mask)) {
+                int freeOffset = free * KEY_WORDS;
+                keys[freeOffset] = keys[offset];
+                keys[freeOffset + 1] = keys[offset + 1];
+                keys[freeOffset + 2] = keys[offset + 2];
+                values[free] = values[next];
+                values[next] = null;
+                free = next;
+            }
+            next = (next + 1) & mask;
+        }
+        int freeOffset = free * KEY_WORDS;
+        keys[freeOffset] = 0;
+        keys[freeOffset + 1] = 0;
+        keys[freeOffset + 2] = 0;
+    }
+
+    private static int hash(long k0, long k1, long k2) {
+        // Connection ids are usually random so mixing the words once is enough to spread them.
+        long h = (k0 ^ Long.rotateLeft(k1, 21) ^ Long.rotateLeft(k2, 42)) * 0x9E3779B97F4A7C15L;
+        return (int) (h ^ (h >>> 32));
+    }
+
+    private boolean encode(ByteBuf connectionId) {
+        int length = connectionId.readableBytes();
+        if (length > MAX_CONNECTION_ID_LENGTH) {
+            return false;
+        }
+        int index = connectionId.readerIndex();
+        key0 = word(connectionId, index, length);
+        key1 = word(connectionId, index + Long.BYTES, length - Long.BYTES);
+        key2 = word(connectionId, index + 2 * Long.BYTES, length - 2 * Long.BYTES) |
+                ((long) length << LENGTH_SHIFT);
+        return true;
+    }
+
+    private static long word(ByteBuf buffer, int index, int length) {
+        if (length >= Long.BYTES) {
+            return buffer.getLongLE(index);
+        }
+        long word = 0;
+        for (int i = 0; i < length; i++) {
+            word |= (buffer.getByte(index + i) & 0xFFL) << (i * Byte.SIZE);
+        }
+        return word;
+    }
+
+    private boolean encode(ByteBuffer connectionId) {
+        int length = connectionId.remaining();
+        if (length > MAX_CONNECTION_ID_LENGTH) {
+            return false;
+        }
+        int index = connectionId.position();
+        key0 = word(connectionId, index, length);
+        key1 = word(connectionId, index + Long.BYTES, length - Long.BYTES);
+        key2 = word(connectionId, index + 2 * Long.BYTES, length - 2 * Long.BYTES) |
+                ((long) length << LENGTH_SHIFT);
+        return true;
+    }
+
+    private static long word(ByteBuffer buffer, int index, int length) {
+        long word = 0;
+        for (int i = 0; i < Math.min(length, Long.BYTES); i++) {
+            word |= (buffer.get(index + i) & 0xFFL) << (i * Byte.SIZE);
+        }
+        return word;
+    }
+}
@@ -35,6 +35,7 @@ final class DefaultQuicChannelConfig extends DefaultChannelConfig implements Qui
      * See <a href="https://docs.rs/quiche/0.6.0/quiche/fn.connect.html">server_name</a>.
      */
     private volatile String peerCertServerName;
+    private volatile QLogConfiguration qlog;
 
     DefaultQuicChannelConfig(Channel channel) {
         super(channel);
@@ -42,7 +43,7 @@ final class DefaultQuicChannelConfig extends DefaultChannelConfig implements Qui
 
     @Override
     public Map<ChannelOption<?>, Object> getOptions() {
-        return getOptions(super.getOptions(), QuicChannelOption.PEER_CERT_SERVER_NAME);
+        return getOptions(super.getOptions(), QuicChannelOption.PEER_CERT_SERVER_NAME, QuicChannelOption.QLOG);
     }
 
     @SuppressWarnings("unchecked")
@@ -51,6 +52,9 @@ final class DefaultQuicChannelConfig extends DefaultChannelConfig implements Qui
         if (option == QuicChannelOption.PEER_CERT_SERVER_NAME) {
             return (T) String.valueOf(getPeerCertServerName());
         }
+        if (option == QuicChannelOption.QLOG) {
+            return (T) qlog;
+        }
 
         return super.getOption(option);
     }
@@ -61,6 +65,9 @@ final class DefaultQuicChannelConfig extends DefaultChannelConfig implements Qui
 
         if (option == QuicChannelOption.PEER_CERT_SERVER_NAME) {
             setPeerCertServerName((String) value);
+        } else if (option == QuicChannelOption.QLOG) {
+            qlog = (QLogConfiguration) value;
+            ((QuicheQuicChannel) channel).enableQLog(qlog);
         } else {
             return super.setOption(option, value);
         }
@@ -145,4 +152,8 @@ final class DefaultQuicChannelConfig extends DefaultChannelConfig implements Qui
         this.peerCertServerName = peerCertServerName;
         return this;
     }
+
+    QLogConfiguration qlog() {
+        return qlog;
+    }
 }
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.epoll.SegmentedDatagramPacket;
+import io.netty.channel.socket.DatagramPacket;
+
+import java.net.InetSocketAddress;
+
+/**
+ * Utilities that are useful when the QUIC codec is used together with the native epoll transport.
+ */
+public final class EpollQuicUtils {
+
+    // See UDP_MAX_SEGMENTS in the linux kernel.
+    private static final int MAX_SEGMENTS = 64;
+
+    private EpollQuicUtils() { }
+
+    /**
+     * Return a new {@link SegmentedDatagramPacketAllocator} that can be used while using
+     * {@link io.netty.channel.epoll.EpollDatagramChannel}. If the kernel or the transport does not support
+     * UDP_SEGMENT {@link SegmentedDatagramPacketAllocator#NONE} is returned, which means we fall back to send one
+     * {@link DatagramPacket} per QUIC packet.
+     *
+     * @param maxNumSegments the maximum number of segments that should be used per packet.
+     * @return the allocator.
+     */
+    public static SegmentedDatagramPacketAllocator newSegmentedAllocator(int maxNumSegments) {
+        if (maxNumSegments < 1 || maxNumSegments > MAX_SEGMENTS) {
+            throw new IllegalArgumentException(
+                    "maxNumSegments: " + maxNumSegments + " (expected: 1-" + MAX_SEGMENTS + ')');
+        }
+        if (maxNumSegments > 1 && SegmentedDatagramPacket.isSupported()) {
+            return new EpollSegmentedDatagramPacketAllocator(maxNumSegments);
+        }
+        return SegmentedDatagramPacketAllocator.NONE;
+    }
+
+    private static final class EpollSegmentedDatagramPacketAllocator implements SegmentedDatagramPacketAllocator {
+
+        private final int maxNumSegments;
+
+        EpollSegmentedDatagramPacketAllocator(int maxNumSegments) {
+            this.maxNumSegments = maxNumSegments;
+        }
+
+        @Override
+        public int maxNumSegments() {
+            return maxNumSegments;
+        }
+
+        @Override
+        public DatagramPacket newPacket(ByteBuf buffer, int segmentSize, InetSocketAddress remoteAddress) {
+            return new SegmentedDatagramPacket(buffer, segmentSize, remoteAddress);
+        }
+    }
+}
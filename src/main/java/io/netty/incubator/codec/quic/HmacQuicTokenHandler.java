@@ -0,0 +1,242 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.util.concurrent.FastThreadLocal;
+import io.netty.util.internal.ObjectUtil;
+
+import javax.crypto.Mac;
+import javax.crypto.ShortBufferException;
+import javax.crypto.spec.SecretKeySpec;
+import java.net.Inet4Address;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.security.GeneralSecurityException;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * {@link QuicTokenHandler} that authenticates the tokens with HMAC-SHA256, so tokens are stateless and can not be
+ * forged by a remote peer.
+ *
+ * The token is bound to the address of the remote peer, the original destination connection id and an expiry time.
+ * The HMAC keys are derived from the given secret and rotate every key rotation interval, tokens that were created
+ * with the previous key are still accepted. All the servers that share the same secret accept each other's tokens.
+ *
+ * The keyed {@link Mac}s are cached per thread so a key is only derived again when it rotates. Note that
+ * {@link Mac#doFinal(byte[], int)} still allocates the digest internally on every call.
+ */
+public final class HmacQuicTokenHandler implements QuicTokenHandler {
+    private static final String HMAC_ALGORITHM = "HmacSHA256";
+    private static final int KEY_ID_LEN = 1;
+    private static final int EXPIRY_LEN = Long.BYTES;
+    private static final int MAC_LEN = 16;
+    private static final int HEADER_LEN = KEY_ID_LEN + EXPIRY_LEN + MAC_LEN;
+    // The longest input we feed to the Mac in one go is the original destination connection id.
+    private static final int SCRATCH_LEN = Math.max(Quiche.QUICHE_MAX_CONN_ID_LEN, 32);
+
+    private final byte[] secret;
+    private final long tokenLifetimeMillis;
+    private final long keyRotationIntervalMillis;
+    private final FastThreadLocal<KeyState> keyState = new FastThreadLocal<KeyState>() {
+        @Override
+        protected KeyState initialValue() {
+            return new KeyState();
+        }
+    };
+
+    /**
+     * Create a new instance that uses tokens which are valid for 10 seconds and rotates the keys every minute.
+     *
+     * @param secret the secret from which the keys are derived. This should be at least 32 random bytes.
+     */
+    public HmacQuicTokenHandler(byte[] secret) {
+        this(secret, 10, 60, TimeUnit.SECONDS);
+    }
+
+    /**
+     * Create a new instance.
+     *
+     * @param secret                the secret from which the keys are derived. This should be at least 32 random
+     *                              bytes.
+     * @param tokenLifetime         how long a token is valid.
+     * @param keyRotationInterval   how often the key is rotated, must not be smaller than {@code tokenLifetime}.
+     * @param unit                  the {@link TimeUnit} of {@code tokenLifetime} and {@code keyRotationInterval}.
+     */
+    public HmacQuicTokenHandler(byte[] secret, long tokenLifetime, long keyRotationInterval, TimeUnit unit) {
+        Quic.ensureAvailability();
+        ObjectUtil.checkNotNull(secret, "secret");
+        if (secret.length == 0) {
+            throw new IllegalArgumentException("secret must not be empty");
+        }
+        ObjectUtil.checkNotNull(unit, "unit");
+        this.tokenLifetimeMillis = unit.toMillis(ObjectUtil.checkPositive(tokenLifetime, "tokenLifetime"));
+        this.keyRotationIntervalMillis = unit.toMillis(
+                ObjectUtil.checkPositive(keyRotationInterval, "keyRotationInterval"));
+        if (keyRotationIntervalMillis < tokenLifetimeMillis) {
+            throw new IllegalArgumentException("keyRotationInterval: " + keyRotationInterval +
+                    " (expected: >= tokenLifetime " + tokenLifetime + ')');
+        }
+        this.secret = secret.clone();
+        // Fail fast if HmacSHA256 is not supported.
+        newMac(0);
+    }
+
+    @Override
+    public boolean writeToken(ByteBuf out, ByteBuf dcid, InetSocketAddress address) {
+        long now = System.currentTimeMillis();
+        long epoch = now / keyRotationIntervalMillis;
+        long expiry = now + tokenLifetimeMillis;
+        KeyState state = keyState.get();
+        Mac mac = state.mac(this, epoch);
+        int dcidLen = dcid.readableBytes();
+        update(state, mac, expiry, address, dcid, dcid.readerIndex(), dcidLen);
+
+        out.writeByte((byte) epoch);
+        out.writeLong(expiry);
+        out.writeBytes(state.macOut, 0, MAC_LEN);
+        out.writeBytes(dcid, dcid.readerIndex(), dcidLen);
+        return true;
+    }
+
+    @Override
+    public int validateToken(ByteBuf token, InetSocketAddress address) {
+        int readerIndex = token.readerIndex();
+        int dcidLen = token.readableBytes() - HEADER_LEN;
+        if (dcidLen <= 0 || dcidLen > Quiche.QUICHE_MAX_CONN_ID_LEN) {
+            return -1;
+        }
+        long now = System.currentTimeMillis();
+        long expiry = token.getLong(readerIndex + KEY_ID_LEN);
+        if (expiry < now || expiry > now + tokenLifetimeMillis) {
+            return -1;
+        }
+
+        // Only the current and the previous key are valid.
+        long epoch = now / keyRotationIntervalMillis;
+        byte keyId = token.getByte(readerIndex);
+        if (keyId != (byte) epoch) {
+            epoch--;
+            if (keyId != (byte) epoch) {
+                return -1;
+            }
+        }
+
+        KeyState state = keyState.get();
+        Mac mac = state.mac(this, epoch);
+        update(state, mac, expiry, address, token, readerIndex + HEADER_LEN, dcidLen);
+
+        // Compare in constant time so the result does not leak how many bytes matched.
+        int diff = 0;
+        int macIndex = readerIndex + KEY_ID_LEN + EXPIRY_LEN;
+        for (int i = 0; i < MAC_LEN; i++) {
+            diff |= state.macOut[i] ^ token.getByte(macIndex + i);
+        }
+        return diff == 0 ? HEADER_LEN : -1;
+    }
+
+    @Override
+    public int maxTokenLength() {
+        return HEADER_LEN + Quiche.QUICHE_MAX_CONN_ID_LEN;
+    }
+
+    // Compute the HMAC over the expiry, the address of the peer and the connection id and store it in macOut.
+    private static void update(KeyState state, Mac mac, long expiry, InetSocketAddress address,
+                               ByteBuf dcid, int dcidIndex, int dcidLen) {
+        byte[] scratch = state.scratch;
+        putLong(scratch, 0, expiry);
+        InetAddress inetAddress = address.getAddress();
+        int len;
+        if (inetAddress instanceof Inet4Address) {
+            // The hash code of an Inet4Address is the address itself, which saves the allocation of a byte[].
+            putInt(scratch, Long.BYTES, inetAddress.hashCode());
+            len = Long.BYTES + Integer.BYTES;
+        } else {
+            byte[] addr = inetAddress.getAddress();
+            System.arraycopy(addr, 0, scratch, Long.BYTES, addr.length);
+            len = Long.BYTES + addr.length;
+        }
+        scratch[len++] = (byte) (address.getPort() >>> 8);
+        scratch[len++] = (byte) address.getPort();
+        mac.update(scratch, 0, len);
+
+        dcid.getBytes(dcidIndex, scratch, 0, dcidLen);
+        mac.update(scratch, 0, dcidLen);
+        try {
+            mac.doFinal(state.macOut, 0);
+        } catch (ShortBufferException e) {
+            throw new IllegalStateException(e);
+        }
+    }
+
+    private static void putLong(byte[] array, int index, long value) {
+        putInt(array, index, (int) (value >>> 32));
+        putInt(array, index + Integer.BYTES, (int) value);
+    }
+
+    private static void putInt(byte[] array, int index, int value) {
+        array[index] = (byte) (value >>> 24);
+        array[index + 1] = (byte) (value >>> 16);
+        array[index + 2] = (byte) (value >>> 8);
+        array[index + 3] = (byte) value;
+    }
+
+    // Derive the key of the given epoch from the secret and return a Mac that is initialized with it.
+    private Mac newMac(long epoch) {
+        try {
+            Mac mac = Mac.getInstance(HMAC_ALGORITHM);
+            mac.init(new SecretKeySpec(secret, HMAC_ALGORITHM));
+            byte[] epochBytes = new byte[Long.BYTES];
+            putLong(epochBytes, 0, epoch);
+            byte[] key = mac.doFinal(epochBytes);
+            mac.init(new SecretKeySpec(key, HMAC_ALGORITHM));
+            return mac;
+        } catch (GeneralSecurityException e) {
+            throw new IllegalStateException("Unable to create " + HMAC_ALGORITHM, e);
+        }
+    }
+
+    /**
+     * The keyed {@link Mac}s of the current and previous epoch plus scratch space. A {@link Mac} keeps the
+     * precomputed key state across calls so only a rotation needs to derive a new key.
+     */
+    private static final class KeyState {
+        final byte[] scratch = new byte[SCRATCH_LEN];
+        final byte[] macOut = new byte[32];
+        private long epoch0 = -1;
+        private Mac mac0;
+        private long epoch1 = -1;
+        private Mac mac1;
+
+        Mac mac(HmacQuicTokenHandler handler, long epoch) {
+            if (epoch == epoch0) {
+                return mac0;
+            }
+            if (epoch == epoch1) {
+                return mac1;
+            }
+            // Replace the older of the two.
+            if (epoch0 < epoch1) {
+                epoch0 = epoch;
+                mac0 = handler.newMac(epoch);
+                return mac0;
+            }
+            epoch1 = epoch;
+            mac1 = handler.newMac(epoch);
+            return mac1;
+        }
+    }
+}
@@ -16,7 +16,6 @@
 package io.netty.incubator.codec.quic;
 
 import io.netty.buffer.ByteBuf;
-import io.netty.buffer.Unpooled;
 import io.netty.util.CharsetUtil;
 import io.netty.util.NetUtil;
 
@@ -32,7 +31,6 @@ public final class InsecureQuicTokenHandler implements QuicTokenHandler {
 
     private static final String SERVER_NAME = "netty";
     private static final byte[] SERVER_NAME_BYTES = SERVER_NAME.getBytes(CharsetUtil.US_ASCII);
-    private static final ByteBuf SERVER_NAME_BUFFER = Unpooled.wrappedBuffer(SERVER_NAME_BYTES);
 
     // Just package-private for unit tests
     static final int MAX_TOKEN_LEN = Quiche.QUICHE_MAX_CONN_ID_LEN +
@@ -57,23 +55,27 @@ public final class InsecureQuicTokenHandler implements QuicTokenHandler {
     public int validateToken(ByteBuf token, InetSocketAddress address) {
         final byte[] addr = address.getAddress().getAddress();
 
-        int minLength = SERVER_NAME_BYTES.length + address.getAddress().getAddress().length;
-        if (token.readableBytes() <= SERVER_NAME_BYTES.length + addr.length) {
+        int minLength = SERVER_NAME_BYTES.length + addr.length;
+        if (token.readableBytes() <= minLength) {
             return -1;
         }
 
-        if (!SERVER_NAME_BUFFER.equals(token.slice(0, SERVER_NAME_BYTES.length))) {
+        // Compare in place, which saves the allocations of wrapping / slicing the buffers.
+        int readerIndex = token.readerIndex();
+        if (!regionEquals(token, readerIndex, SERVER_NAME_BYTES) ||
+                !regionEquals(token, readerIndex + SERVER_NAME_BYTES.length, addr)) {
             return -1;
         }
-        ByteBuf addressBuffer = Unpooled.wrappedBuffer(addr);
-        try {
-            if (!addressBuffer.equals(token.slice(SERVER_NAME_BYTES.length, addr.length))) {
-                return -1;
+        return minLength;
+    }
+
+    private static boolean regionEquals(ByteBuf buffer, int index, byte[] bytes) {
+        for (int i = 0; i < bytes.length; i++) {
+            if (buffer.getByte(index + i) != bytes[i]) {
+                return false;
             }
-        } finally {
-            addressBuffer.release();
         }
-        return minLength;
+        return true;
     }
 
     @Override
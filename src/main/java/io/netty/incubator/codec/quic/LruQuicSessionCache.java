@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.internal.ObjectUtil;
+
+import java.net.InetSocketAddress;
+import java.util.LinkedHashMap;
+import java.util.Map;
+import java.util.Objects;
+
+/**
+ * Bounded {@link QuicSessionCache} that evicts the least recently used session. Sessions are only looked up and
+ * stored once per connection, so a lock is cheap enough here.
+ */
+final class LruQuicSessionCache implements QuicSessionCache {
+    private final Map<SessionKey, byte[]> sessions;
+
+    LruQuicSessionCache(int maxEntries) {
+        ObjectUtil.checkPositive(maxEntries, "maxEntries");
+        sessions = new LinkedHashMap<SessionKey, byte[]>(16, 0.75f, true) {
+            @Override
+            protected boolean removeEldestEntry(Map.Entry<SessionKey, byte[]> eldest) {
+                return size() > maxEntries;
+            }
+        };
+    }
+
+    @Override
+    public byte[] getSession(String serverName, InetSocketAddress address) {
+        SessionKey key = new SessionKey(serverName, address);
+        synchronized (sessions) {
+            return sessions.get(key);
+        }
+    }
+
+    @Override
+    public void saveSession(String serverName, InetSocketAddress address, byte[] session) {
+        ObjectUtil.checkNotNull(session, "session");
+        SessionKey key = new SessionKey(serverName, address);
+        synchronized (sessions) {
+            sessions.put(key, session);
+        }
+    }
+
+    private static final class SessionKey {
+        private final String serverName;
+        private final InetSocketAddress address;
+
+        SessionKey(String serverName, InetSocketAddress address) {
+            this.serverName = serverName;
+            this.address = ObjectUtil.checkNotNull(address, "address");
+        }
+
+        @Override
+        public boolean equals(Object o) {
+            if (this == o) {
+                return true;
+            }
+            if (!(o instanceof SessionKey)) {
+                return false;
+            }
+            SessionKey that = (SessionKey) o;
+            return Objects.equals(serverName, that.serverName) && address.equals(that.address);
+        }
+
+        @Override
+        public int hashCode() {
+            return 31 * Objects.hashCode(serverName) + address.hashCode();
+        }
+    }
+}
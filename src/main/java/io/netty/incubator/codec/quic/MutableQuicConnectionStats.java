@@ -0,0 +1,138 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.internal.StringUtil;
+
+/**
+ * {@link QuicConnectionStats} implementation that can be filled via
+ * {@link QuicChannel#collectStats(MutableQuicConnectionStats, io.netty.util.concurrent.Promise)} multiple times. This
+ * allows to collect the statistics of a connection periodically without creating new objects each time.
+ */
+public final class MutableQuicConnectionStats implements QuicConnectionStats {
+
+    private long recv;
+    private long sent;
+    private long lost;
+    private long rttNanos;
+    private long congestionWindow;
+    private long deliveryRate;
+    private long handshakeDurationNanos = -1;
+    private int activeStreams;
+    private long totalStreams;
+    private long memoryUsed;
+
+    void setNativeStats(long recv, long sent, long lost, long rttNanos, long cwnd, long deliveryRate) {
+        this.recv = recv;
+        this.sent = sent;
+        this.lost = lost;
+        this.rttNanos = rttNanos;
+        this.congestionWindow = cwnd;
+        this.deliveryRate = deliveryRate;
+    }
+
+    void setStreamStats(int activeStreams, long totalStreams) {
+        this.activeStreams = activeStreams;
+        this.totalStreams = totalStreams;
+    }
+
+    void setMemoryUsed(long memoryUsed) {
+        this.memoryUsed = memoryUsed;
+    }
+
+    void setHandshakeDurationNanos(long handshakeDurationNanos) {
+        this.handshakeDurationNanos = handshakeDurationNanos;
+    }
+
+    void copyFrom(MutableQuicConnectionStats stats) {
+        setNativeStats(stats.recv, stats.sent, stats.lost, stats.rttNanos, stats.congestionWindow,
+                stats.deliveryRate);
+        setStreamStats(stats.activeStreams, stats.totalStreams);
+        setMemoryUsed(stats.memoryUsed);
+        setHandshakeDurationNanos(stats.handshakeDurationNanos);
+    }
+
+    @Override
+    public long recv() {
+        return recv;
+    }
+
+    @Override
+    public long sent() {
+        return sent;
+    }
+
+    @Override
+    public long lost() {
+        return lost;
+    }
+
+    @Override
+    public long rttNanos() {
+        return rttNanos;
+    }
+
+    @Override
+    public long congestionWindow() {
+        return congestionWindow;
+    }
+
+    @Override
+    public long deliveryRate() {
+        return deliveryRate;
+    }
+
+    @Override
+    public long handshakeDurationNanos() {
+        return handshakeDurationNanos;
+    }
+
+    @Override
+    public int activeStreams() {
+        return activeStreams;
+    }
+
+    @Override
+    public long totalStreams() {
+        return totalStreams;
+    }
+
+    @Override
+    public long memoryUsed() {
+        return memoryUsed;
+    }
+
+    /**
+     * Returns the {@link String} representation of stats.
+     */
+    @Override
+    public String toString() {
+        return new StringBuilder(StringUtil.simpleClassName(this))
+            .append("[")
+            .append("recv=").append(this.recv)
+            .append(", sent=").append(this.sent)
+            .append(", lost=").append(this.lost)
+            .append(", rttNanos=").append(this.rttNanos)
+            .append(", congestionWindow=").append(this.congestionWindow)
+            .append(", deliveryRate=").append(this.deliveryRate)
+            .append(", handshakeDurationNanos=").append(this.handshakeDurationNanos)
+            .append(", activeStreams=").append(this.activeStreams)
+            .append(", totalStreams=").append(this.totalStreams)
+            .append(", memoryUsed=").append(this.memoryUsed)
+            .append("]")
+            .toString();
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.internal.ObjectUtil;
+
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * Configures <a href="https://github.com/quiclog/internet-drafts">qlog</a> output for {@link QuicChannel}s, see
+ * {@link QuicChannelOption#QLOG}. Each sampled connection writes its events to its own file in {@link #path()}.
+ *
+ * The sample rate can be changed at runtime, which affects all connections that are created from then on. qlog is
+ * only available if the native library was compiled with support for it.
+ */
+public final class QLogConfiguration {
+    private final String path;
+    private final String logTitle;
+    private final String logDescription;
+    private volatile double sampleRate;
+
+    /**
+     * Create a new configuration that writes the qlog of every connection to the directory {@code path}.
+     */
+    public QLogConfiguration(String path, String logTitle, String logDescription) {
+        this(path, logTitle, logDescription, 1.0);
+    }
+
+    /**
+     * Create a new configuration that writes the qlog of the given fraction of connections to the directory
+     * {@code path}.
+     */
+    public QLogConfiguration(String path, String logTitle, String logDescription, double sampleRate) {
+        this.path = ObjectUtil.checkNonEmpty(path, "path");
+        this.logTitle = ObjectUtil.checkNotNull(logTitle, "logTitle");
+        this.logDescription = ObjectUtil.checkNotNull(logDescription, "logDescription");
+        sampleRate(sampleRate);
+    }
+
+    /**
+     * The directory to which the qlog files are written.
+     */
+    public String path() {
+        return path;
+    }
+
+    /**
+     * The title that is written to the qlog files.
+     */
+    public String logTitle() {
+        return logTitle;
+    }
+
+    /**
+     * The description that is written to the qlog files.
+     */
+    public String logDescription() {
+        return logDescription;
+    }
+
+    /**
+     * The fraction of connections for which qlog is enabled.
+     */
+    public double sampleRate() {
+        return sampleRate;
+    }
+
+    /**
+     * Set the fraction of connections for which qlog is enabled, {@code 0} disables it for new connections.
+     */
+    public QLogConfiguration sampleRate(double sampleRate) {
+        if (sampleRate < 0 || sampleRate > 1) {
+            throw new IllegalArgumentException("sampleRate: " + sampleRate + " (expected: 0-1)");
+        }
+        this.sampleRate = sampleRate;
+        return this;
+    }
+
+    /**
+     * Returns {@code true} if qlog should be enabled for a new connection.
+     */
+    boolean sample() {
+        double sampleRate = this.sampleRate;
+        return sampleRate >= 1 || sampleRate > 0 && ThreadLocalRandom.current().nextDouble() < sampleRate;
+    }
+}
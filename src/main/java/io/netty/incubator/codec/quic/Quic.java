@@ -66,6 +66,14 @@ public final class Quic {
         }
     }
 
+    /**
+     * Returns {@code true} if the native library supports to resume the TLS session of an earlier connection, which
+     * is required to use a {@link QuicSessionCache}. This is not the case for quiche 0.6.0.
+     */
+    public static boolean isSessionResumptionSupported() {
+        return isAvailable() && Quiche.quiche_session_resumption_supported();
+    }
+
     /**
      * Returns the cause of unavailability.
      *
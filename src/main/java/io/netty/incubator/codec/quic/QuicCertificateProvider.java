@@ -0,0 +1,224 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.internal.ObjectUtil;
+
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.attribute.FileAttribute;
+import java.nio.file.attribute.PosixFilePermission;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.util.Base64;
+import java.util.LinkedHashSet;
+import java.util.Set;
+
+/**
+ * Provides the certificate chain and private key of a QUIC codec and allows to replace them while the codec is in
+ * use. New connections use the new certificate once {@link #update(byte[], byte[])} returns, while existing
+ * connections keep the one they were created with.
+ *
+ * The native configs of all codecs that use this provider are rebuilt by the thread that calls
+ * {@link #update(byte[], byte[])}, so the event loops never need to load the certificate themselves.
+ *
+ * See {@link QuicCodecBuilder#certificateProvider(QuicCertificateProvider)}.
+ */
+public final class QuicCertificateProvider {
+    private static final byte[] EMPTY_BYTES = new byte[0];
+    private static final FileAttribute<Set<PosixFilePermission>> OWNER_ONLY_DIRECTORY =
+            PosixFilePermissions.asFileAttribute(PosixFilePermissions.fromString("rwx------"));
+    private static final FileAttribute<Set<PosixFilePermission>> OWNER_ONLY_FILE =
+            PosixFilePermissions.asFileAttribute(PosixFilePermissions.fromString("rw-------"));
+
+    // The configs of the attached codecs, guarded by this.
+    private final Set<QuicheConfig> configs = new LinkedHashSet<>();
+    private volatile Material material;
+
+    private QuicCertificateProvider(Material material) {
+        this.material = material;
+    }
+
+    /**
+     * Create a new instance from the PEM encoded certificate chain and private key.
+     */
+    public static QuicCertificateProvider fromPem(byte[] certificateChainPem, byte[] privateKeyPem) {
+        return new QuicCertificateProvider(new Material(certificateChainPem, privateKeyPem, 0));
+    }
+
+    /**
+     * Create a new instance from the DER encoded PKCS#8 private key and certificate chain.
+     */
+    public static QuicCertificateProvider fromDer(byte[] privateKeyDer, byte[]... certificateChainDer) {
+        return fromPem(certificatesToPem(certificateChainDer), toPem("PRIVATE KEY", privateKeyDer));
+    }
+
+    /**
+     * Replace the PEM encoded certificate chain and private key that are used for new connections. This loads the
+     * new certificate into the native configs of all codecs that use this provider before it returns.
+     *
+     * @throws IllegalArgumentException if the certificate chain or private key can not be loaded, in which case the
+     *                                  previous ones are kept.
+     */
+    public void update(byte[] certificateChainPem, byte[] privateKeyPem) {
+        synchronized (this) {
+            Material material = new Material(certificateChainPem, privateKeyPem, this.material.generation + 1);
+            // Make sure the new certificate can be loaded at all before we replace anything.
+            long config = Quiche.quiche_config_new(Quiche.QUICHE_PROTOCOL_VERSION);
+            try {
+                load(config, material);
+            } finally {
+                Quiche.quiche_config_free(config);
+            }
+            this.material = material;
+            for (QuicheConfig quicheConfig: configs) {
+                quicheConfig.reloadNativeConfigs();
+            }
+        }
+    }
+
+    /**
+     * Replace the DER encoded PKCS#8 private key and certificate chain that are used for new connections, see
+     * {@link #update(byte[], byte[])}.
+     */
+    public void updateDer(byte[] privateKeyDer, byte[]... certificateChainDer) {
+        update(certificatesToPem(certificateChainDer), toPem("PRIVATE KEY", privateKeyDer));
+    }
+
+    int generation() {
+        return material.generation;
+    }
+
+    /**
+     * Register a {@link QuicheConfig} whose native configs need to be rebuilt once the certificate is updated.
+     */
+    synchronized void register(QuicheConfig config) {
+        configs.add(config);
+    }
+
+    synchronized void unregister(QuicheConfig config) {
+        configs.remove(config);
+    }
+
+    /**
+     * Load the current certificate chain and private key into the given {@code quiche_config}.
+     */
+    void load(long config) {
+        load(config, material);
+    }
+
+    private static void load(long config, Material material) {
+        int res = Quiche.quiche_config_load_cert_chain_from_pem(config, material.certificateChainPem);
+        if (res == Quiche.PEM_FROM_MEMORY_UNSUPPORTED) {
+            loadFromFiles(config, material);
+            return;
+        }
+        if (res != 0) {
+            throw new IllegalArgumentException("Unable to load certificate chain");
+        }
+        if (Quiche.quiche_config_load_priv_key_from_pem(config, material.privateKeyPem) != 0) {
+            throw new IllegalArgumentException("Unable to load private key");
+        }
+    }
+
+    // quiche 0.6.0 can only load PEM files, so if we can't pass these via memory we need to go through temporary
+    // files in a directory that only we can access.
+    private static void loadFromFiles(long config, Material material) {
+        Path dir = null;
+        Path certFile = null;
+        Path keyFile = null;
+        try {
+            dir = createPrivateDirectory();
+            certFile = writePrivateFile(dir, "cert", material.certificateChainPem);
+            keyFile = writePrivateFile(dir, "key", material.privateKeyPem);
+            if (Quiche.quiche_config_load_cert_chain_from_pem_file(config, certFile.toString()) != 0) {
+                throw new IllegalArgumentException("Unable to load certificate chain");
+            }
+            if (Quiche.quiche_config_load_priv_key_from_pem_file(config, keyFile.toString()) != 0) {
+                throw new IllegalArgumentException("Unable to load private key");
+            }
+        } catch (IOException e) {
+            throw new IllegalStateException("Unable to write temporary file", e);
+        } finally {
+            delete(keyFile);
+            delete(certFile);
+            delete(dir);
+        }
+    }
+
+    private static Path createPrivateDirectory() throws IOException {
+        try {
+            return Files.createTempDirectory("netty-quic-", OWNER_ONLY_DIRECTORY);
+        } catch (UnsupportedOperationException e) {
+            // Not a POSIX file system, the temporary directory is private to the user there anyway.
+            return Files.createTempDirectory("netty-quic-");
+        }
+    }
+
+    private static Path writePrivateFile(Path dir, String name, byte[] bytes) throws IOException {
+        Path file = dir.resolve(name + ".pem");
+        try {
+            Files.createFile(file, OWNER_ONLY_FILE);
+        } catch (UnsupportedOperationException e) {
+            Files.createFile(file);
+        }
+        Files.write(file, bytes);
+        return file;
+    }
+
+    private static void delete(Path path) {
+        if (path != null) {
+            try {
+                Files.deleteIfExists(path);
+            } catch (IOException ignore) {
+                // Nothing we can do about it.
+            }
+        }
+    }
+
+    private static byte[] certificatesToPem(byte[]... certificateChainDer) {
+        ObjectUtil.checkNonEmpty(certificateChainDer, "certificateChainDer");
+        byte[] pem = EMPTY_BYTES;
+        for (byte[] certificate: certificateChainDer) {
+            byte[] certificatePem = toPem("CERTIFICATE", certificate);
+            byte[] chain = new byte[pem.length + certificatePem.length];
+            System.arraycopy(pem, 0, chain, 0, pem.length);
+            System.arraycopy(certificatePem, 0, chain, pem.length, certificatePem.length);
+            pem = chain;
+        }
+        return pem;
+    }
+
+    private static byte[] toPem(String type, byte[] der) {
+        ObjectUtil.checkNotNull(der, "der");
+        String base64 = Base64.getMimeEncoder(64, new byte[] { '\n' }).encodeToString(der);
+        return ("-----BEGIN " + type + "-----\n" + base64 + "\n-----END " + type + "-----\n")
+                .getBytes(StandardCharsets.US_ASCII);
+    }
+
+    private static final class Material {
+        final byte[] certificateChainPem;
+        final byte[] privateKeyPem;
+        final int generation;
+
+        Material(byte[] certificateChainPem, byte[] privateKeyPem, int generation) {
+            this.certificateChainPem = ObjectUtil.checkNotNull(certificateChainPem, "certificateChainPem").clone();
+            this.privateKeyPem = ObjectUtil.checkNotNull(privateKeyPem, "privateKeyPem").clone();
+            this.generation = generation;
+        }
+    }
+}
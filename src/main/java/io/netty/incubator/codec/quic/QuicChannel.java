@@ -25,6 +25,11 @@ import io.netty.util.concurrent.Promise;
 
 /**
  * A QUIC {@link Channel}.
+ *
+ * If QUIC DATAGRAM frames were enabled via {@link QuicCodecBuilder#datagram(int, int)} the {@link QuicChannel}
+ * accepts {@link ByteBuf}s as outbound messages and sends each of them as one unreliable DATAGRAM frame. Received
+ * DATAGRAM payloads are fired through the {@link io.netty.channel.ChannelPipeline} as {@link ByteBuf}s, next to the
+ * {@link QuicStreamChannel}s that were created by the remote peer.
  */
 public interface QuicChannel extends Channel {
 
@@ -101,7 +106,16 @@ public interface QuicChannel extends Channel {
     /**
      * Collects statistics about the connection and notifies the {@link Promise} once done.
      */
-    Future<QuicConnectionStats> collectStats(Promise<QuicConnectionStats> promise);
+    default Future<QuicConnectionStats> collectStats(Promise<QuicConnectionStats> promise) {
+        return collectStats(new MutableQuicConnectionStats(), promise);
+    }
+
+    /**
+     * Collects statistics about the connection into the given {@link MutableQuicConnectionStats} and notifies the
+     * {@link Promise} with it once done. The same {@link MutableQuicConnectionStats} can be used again once the
+     * {@link Promise} was notified, which allows to collect statistics periodically without creating garbage.
+     */
+    Future<QuicConnectionStats> collectStats(MutableQuicConnectionStats stats, Promise<QuicConnectionStats> promise);
 
     /**
      * Creates a new {@link QuicChannelBootstrap} that can be used to create and connect new {@link QuicChannel}s to
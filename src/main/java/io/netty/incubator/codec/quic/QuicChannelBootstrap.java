@@ -50,6 +50,7 @@ public final class QuicChannelBootstrap {
     private QuicConnectionAddress connectionAddress;
     private ChannelHandler handler;
     private ChannelHandler streamHandler;
+    private QuicSessionCache sessionCache;
 
     /**
      * Creates a new instance which uses the given {@link Channel} to bootstrap the {@link QuicChannel}.
@@ -132,6 +133,25 @@ public final class QuicChannelBootstrap {
         return this;
     }
 
+    /**
+     * Set the {@link QuicSessionCache} that is used to resume the TLS session of an earlier connection to the same
+     * server. If the session can be resumed the {@link QuicChannel} becomes active right away and stream data is
+     * sent as 0-RTT early data, which requires {@link QuicCodecBuilder#enableEarlyData()} on both sides.
+     *
+     * Sessions can only be resumed if the native library supports it, which is not the case for quiche 0.6.0. Check
+     * {@link Quic#isSessionResumptionSupported()} before using this method.
+     *
+     * @throws UnsupportedOperationException if {@link Quic#isSessionResumptionSupported()} returns {@code false}.
+     */
+    public QuicChannelBootstrap sessionCache(QuicSessionCache sessionCache) {
+        ObjectUtil.checkNotNull(sessionCache, "sessionCache");
+        if (!Quic.isSessionResumptionSupported()) {
+            throw new UnsupportedOperationException("Session resumption is not supported by the native library");
+        }
+        this.sessionCache = sessionCache;
+        return this;
+    }
+
     /**
      * Connects a {@link QuicChannel} to the remote peer and notifies the future once done.
      */
@@ -156,8 +176,11 @@ public final class QuicChannelBootstrap {
         final QuicConnectionAddress address = connectionAddress == null ?
                 QuicConnectionAddress.random() : connectionAddress;
 
-        QuicChannel channel = QuicheQuicChannel.forClient(parent, (InetSocketAddress) remote,
+        QuicheQuicChannel channel = QuicheQuicChannel.forClient(parent, (InetSocketAddress) remote,
                 streamHandler, Quic.optionsArray(streamOptions), Quic.attributesArray(streamAttrs));
+        if (sessionCache != null) {
+            channel.sessionCache(sessionCache);
+        }
 
         Quic.setupChannel(channel, Quic.optionsArray(options), Quic.attributesArray(attrs), handler, logger);
         EventLoop eventLoop = parent.eventLoop();
@@ -37,6 +37,13 @@ public final class QuicChannelOption<T> extends ChannelOption<T> {
     public static final ChannelOption<Boolean> READ_FRAMES =
             valueOf(QuicChannelOption.class, "READ_FRAMES");
 
+    /**
+     * Enables qlog for a sampled subset of the {@link QuicChannel}s, see {@link QLogConfiguration}. This can also be
+     * set on an already established {@link QuicChannel}, in which case only the following events are logged.
+     */
+    public static final ChannelOption<QLogConfiguration> QLOG =
+            valueOf(QuicChannelOption.class, "QLOG");
+
     @SuppressWarnings({ "deprecation" })
     private QuicChannelOption() {
         super(null);
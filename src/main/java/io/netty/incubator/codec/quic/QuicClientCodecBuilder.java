@@ -24,7 +24,8 @@ import io.netty.channel.ChannelHandler;
 public final class QuicClientCodecBuilder extends QuicCodecBuilder<QuicClientCodecBuilder> {
 
     @Override
-    protected ChannelHandler build(QuicheConfig config) {
-        return new QuicheQuicClientCodec(config);
+    protected ChannelHandler build(QuicheConfig config,
+                                   SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator) {
+        return new QuicheQuicClientCodec(config, segmentedDatagramPacketAllocator, metricsCollector());
     }
 }
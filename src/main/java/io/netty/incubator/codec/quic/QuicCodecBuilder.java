@@ -16,6 +16,7 @@
 package io.netty.incubator.codec.quic;
 
 import io.netty.channel.ChannelHandler;
+import io.netty.util.internal.ObjectUtil;
 
 /**
  * Abstract base class for {@code QUIC} codec builders.
@@ -24,6 +25,7 @@ public abstract class QuicCodecBuilder<B extends QuicCodecBuilder<B>> {
 
     private String certPath;
     private String keyPath;
+    private QuicCertificateProvider certificateProvider;
     private Boolean verifyPeer;
     private Boolean grease;
     private boolean earlyData;
@@ -41,6 +43,16 @@ public abstract class QuicCodecBuilder<B extends QuicCodecBuilder<B>> {
     private Boolean disableActiveMigration;
     private Boolean enableHystart;
     private QuicCongestionControlAlgorithm congestionControlAlgorithm;
+    private int recvQueueLen = -1;
+    private int sendQueueLen = -1;
+    private SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator =
+            SegmentedDatagramPacketAllocator.NONE;
+    private QuicMetricsCollector metricsCollector;
+    private long maxConnectionMemory;
+    private long maxTotalMemory;
+    private boolean pacing;
+    private long maxDataLimit;
+    private long maxStreamDataLimit;
 
     QuicCodecBuilder() {
         Quic.ensureAvailability();
@@ -75,6 +87,16 @@ public abstract class QuicCodecBuilder<B extends QuicCodecBuilder<B>> {
         return self();
     }
 
+    /**
+     * Set the {@link QuicCertificateProvider} that provides the certificate chain and private key from memory. This
+     * takes precedence over {@link #certificateChain(String)} and {@link #privateKey(String)} and allows to replace
+     * the certificate without rebuilding the codecs.
+     */
+    public final B certificateProvider(QuicCertificateProvider certificateProvider) {
+        this.certificateProvider = certificateProvider;
+        return self();
+    }
+
     /**
      * Set if the remote peer should be verified or not.
      */
@@ -227,13 +249,111 @@ public abstract class QuicCodecBuilder<B extends QuicCodecBuilder<B>> {
         return self();
     }
 
-    private QuicheConfig createConfig() {
-        return new QuicheConfig(certPath, keyPath, verifyPeer, grease, earlyData,
+    /**
+     * Enable the support of
+     * <a href="https://tools.ietf.org/html/draft-ietf-quic-datagram-01">QUIC DATAGRAM frames</a>. Once enabled
+     * the {@link QuicChannel} accepts {@link io.netty.buffer.ByteBuf}s as outbound messages, which are sent as
+     * unreliable DATAGRAM frames, and fires received DATAGRAM payloads as {@link io.netty.buffer.ByteBuf}s through
+     * its {@link io.netty.channel.ChannelPipeline}.
+     *
+     * The queue lengths bound the memory that is used for DATAGRAMs. Once the receive queue is full quiche drops
+     * newly received DATAGRAMs. Once the send queue is full the DATAGRAM is dropped and the write is failed with a
+     * {@link QuicException}.
+     *
+     * See <a href="https://docs.rs/quiche/0.6.0/quiche/struct.Config.html#method.enable_dgram">
+     *     enable_dgram</a>.
+     *
+     * @param recvQueueLength   the maximum number of received DATAGRAMs that are queued before these are dropped.
+     * @param sendQueueLength   the maximum number of DATAGRAMs that are queued for sending before writes are failed.
+     */
+    public final B datagram(int recvQueueLength, int sendQueueLength) {
+        ObjectUtil.checkPositive(recvQueueLength, "recvQueueLength");
+        ObjectUtil.checkPositive(sendQueueLength, "sendQueueLength");
+        this.recvQueueLen = recvQueueLength;
+        this.sendQueueLen = sendQueueLength;
+        return self();
+    }
+
+    /**
+     * Set the {@link SegmentedDatagramPacketAllocator} to use. This allows to coalesce multiple QUIC packets of the
+     * same size into one datagram which is then sent via UDP_SEGMENT (GSO) by the transport. By default
+     * {@link SegmentedDatagramPacketAllocator#NONE} is used and so each QUIC packet is sent on its own.
+     *
+     * See {@link EpollQuicUtils#newSegmentedAllocator(int)}.
+     */
+    public final B segmentedDatagramPacketAllocator(
+            SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator) {
+        this.segmentedDatagramPacketAllocator = ObjectUtil.checkNotNull(
+                segmentedDatagramPacketAllocator, "segmentedDatagramPacketAllocator");
+        return self();
+    }
+
+    /**
+     * Set the {@link QuicMetricsCollector} to which the {@link QuicCodecMetrics} of the built codec(s) are
+     * registered, or {@code null} if the metrics should not be exported.
+     */
+    public final B metricsCollector(QuicMetricsCollector metricsCollector) {
+        this.metricsCollector = metricsCollector;
+        return self();
+    }
+
+    /**
+     * Limit the memory that is used by the connections of the built codec(s). Once a connection uses more than
+     * {@code maxConnectionMemory} bytes no new streams are accepted or can be created on it. Once all connections
+     * together use more than {@code maxTotalMemory} bytes no new connections or streams are accepted.
+     *
+     * The memory of a connection is the direct memory of writes that are queued on its streams plus an estimate of
+     * what quiche uses for the connection and each of its streams. {@code 0} means unlimited, which is the default.
+     */
+    public final B memoryBudget(long maxConnectionMemory, long maxTotalMemory) {
+        this.maxConnectionMemory = ObjectUtil.checkPositiveOrZero(maxConnectionMemory, "maxConnectionMemory");
+        this.maxTotalMemory = ObjectUtil.checkPositiveOrZero(maxTotalMemory, "maxTotalMemory");
+        return self();
+    }
+
+    /**
+     * Enable the pacing of outgoing packets. Instead of writing a whole congestion window in one burst the packets
+     * are spread over the round-trip time, which reduces the losses caused by overflowing shallow buffers on the
+     * path. The rate is derived from the congestion window and the rtt, and bursts are released by the timers of the
+     * {@link io.netty.channel.EventLoop} with a granularity of one millisecond. The default is {@code false}.
+     */
+    public final B enablePacing(boolean value) {
+        this.pacing = value;
+        return self();
+    }
+
+    /**
+     * Let the flow control windows of connections grow up to {@code maxData} and the windows of their streams up to
+     * {@code maxStreamData} if the bandwidth-delay product of the peer needs it. The configured initial windows stay
+     * the default, so idle connections keep a small footprint.
+     *
+     * quiche takes the windows from the config when a connection is created, so the windows are chosen per
+     * connection from the receive rate and rtt that were measured on previous connections to the same peer address,
+     * growing by a factor of four for each connection that was limited by its windows. This requires
+     * {@link #initialMaxData(long)} to be set. {@code 0} disables the autotuning, which is the default.
+     */
+    public final B flowControlAutotuning(long maxData, long maxStreamData) {
+        this.maxDataLimit = ObjectUtil.checkPositiveOrZero(maxData, "maxData");
+        this.maxStreamDataLimit = ObjectUtil.checkPositiveOrZero(maxStreamData, "maxStreamData");
+        return self();
+    }
+
+    QuicheConfig createConfig() {
+        return new QuicheConfig(certPath, keyPath, certificateProvider, verifyPeer, grease, earlyData,
                 protos, maxIdleTimeout, maxUdpPayloadSize, initialMaxData,
                 initialMaxStreamDataBidiLocal, initialMaxStreamDataBidiRemote,
                 initialMaxStreamDataUni, initialMaxStreamsBidi, initialMaxStreamsUni,
                 ackDelayExponent, maxAckDelay, disableActiveMigration, enableHystart,
-                congestionControlAlgorithm);
+                congestionControlAlgorithm, recvQueueLen, sendQueueLen, maxConnectionMemory, maxTotalMemory,
+                pacing, maxDataLimit, maxStreamDataLimit);
+    }
+
+    SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator() {
+        return segmentedDatagramPacketAllocator;
+    }
+
+    QuicMetricsCollector metricsCollector() {
+        return metricsCollector;
     }
 
     /**
@@ -247,8 +367,9 @@ public abstract class QuicCodecBuilder<B extends QuicCodecBuilder<B>> {
      */
     public final ChannelHandler build() {
         validate();
-        return build(createConfig());
+        return build(createConfig(), segmentedDatagramPacketAllocator);
     }
 
-    protected abstract ChannelHandler build(QuicheConfig config);
+    protected abstract ChannelHandler build(QuicheConfig config,
+                                            SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator);
 }
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+/**
+ * Counters of a {@code QUIC} codec. Each codec is bound to one {@link io.netty.channel.EventLoop} and updates its
+ * counters without any synchronization, while these can be read from any thread.
+ *
+ * See {@link QuicMetricsCollector}.
+ */
+public interface QuicCodecMetrics {
+
+    /**
+     * @return The number of QUIC packets that were received.
+     */
+    long packetsRead();
+
+    /**
+     * @return The number of bytes of the QUIC packets that were received.
+     */
+    long bytesRead();
+
+    /**
+     * @return The number of QUIC packets that were sent.
+     */
+    long packetsWritten();
+
+    /**
+     * @return The number of bytes of the QUIC packets that were sent.
+     */
+    long bytesWritten();
+
+    /**
+     * @return The number of connections that were accepted.
+     */
+    long acceptedConnections();
+
+    /**
+     * @return The number of accepted connections for which the handshake is still in progress.
+     */
+    long pendingHandshakes();
+
+    /**
+     * @return The number of retry packets that were sent to validate the address of the remote peer.
+     */
+    long retries();
+
+    /**
+     * @return The number of version negotiation packets that were sent.
+     */
+    long versionNegotiations();
+
+    /**
+     * @return The number of QUIC packets that were dropped, for example as these could not be parsed, belong to an
+     *         unknown connection or contained an invalid token.
+     */
+    long droppedPackets();
+
+    /**
+     * @return The number of new connections that were rejected as the memory budget was exhausted.
+     */
+    long shedConnections();
+
+    /**
+     * @return The number of new streams that were rejected as the memory budget was exhausted.
+     */
+    long shedStreams();
+}
@@ -48,4 +48,34 @@ public interface QuicConnectionStats {
      * @return The estimated data delivery rate in bytes/s.
      */
     long deliveryRate();
+
+    /**
+     * @return The time it took to complete the handshake in nanoseconds or {@code -1} if the handshake was not
+     *         completed yet.
+     */
+    default long handshakeDurationNanos() {
+        return -1;
+    }
+
+    /**
+     * @return The number of streams of the connection that are currently open.
+     */
+    default int activeStreams() {
+        return -1;
+    }
+
+    /**
+     * @return The number of streams that were opened on the connection in total, by both peers.
+     */
+    default long totalStreams() {
+        return -1;
+    }
+
+    /**
+     * @return The estimated number of bytes that are accounted to the connection in the memory budget of the codec,
+     *         or {@code 0} if no budget is configured.
+     */
+    default long memoryUsed() {
+        return -1;
+    }
 }
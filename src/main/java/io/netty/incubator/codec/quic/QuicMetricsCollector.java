@@ -0,0 +1,35 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+/**
+ * Allows to export the {@link QuicCodecMetrics} of {@code QUIC} codecs to a metrics library. If the codec is sharded
+ * (see {@link QuicServerCodecBuilder#buildShards(int)}) each shard registers its own {@link QuicCodecMetrics}, which
+ * can be aggregated by the implementation.
+ */
+public interface QuicMetricsCollector {
+
+    /**
+     * Called once the codec was added to the {@link io.netty.channel.ChannelPipeline}. The given
+     * {@link QuicCodecMetrics} is updated by the codec until {@link #unregister(QuicCodecMetrics)} is called.
+     */
+    void register(QuicCodecMetrics metrics);
+
+    /**
+     * Called once the codec was removed from the {@link io.netty.channel.ChannelPipeline}.
+     */
+    void unregister(QuicCodecMetrics metrics);
+}
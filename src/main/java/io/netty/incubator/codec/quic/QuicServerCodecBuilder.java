@@ -20,8 +20,10 @@ import io.netty.channel.ChannelOption;
 import io.netty.util.AttributeKey;
 import io.netty.util.internal.ObjectUtil;
 
+import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.LinkedHashMap;
+import java.util.List;
 import java.util.Map;
 
 /**
@@ -39,6 +41,9 @@ public final class QuicServerCodecBuilder extends QuicCodecBuilder<QuicServerCod
     private ChannelHandler streamHandler;
     private QuicConnectionIdGenerator connectionIdAddressGenerator;
     private QuicTokenHandler tokenHandler;
+    private int maxHandshakesPerSecond;
+    private int maxPendingHandshakes;
+    private int maxVersionNegotiationsPerSecond;
 
     public QuicServerCodecBuilder() { }
 
@@ -113,6 +118,31 @@ public final class QuicServerCodecBuilder extends QuicCodecBuilder<QuicServerCod
         return self();
     }
 
+    /**
+     * Only send a Retry to validate the address of the remote peer when the server is under load, which is the case
+     * if more than {@code maxHandshakesPerSecond} new connections are started per second or more than
+     * {@code maxPendingHandshakes} handshakes are in progress. This keeps the extra round-trip of the Retry off the
+     * normal traffic, while still protecting the server during floods. The limits apply to each codec (and so each
+     * shard) on its own.
+     *
+     * By default a Retry is sent for every new connection for which the {@link QuicTokenHandler} writes a token.
+     */
+    public QuicServerCodecBuilder adaptiveRetry(int maxHandshakesPerSecond, int maxPendingHandshakes) {
+        this.maxHandshakesPerSecond = ObjectUtil.checkPositive(maxHandshakesPerSecond, "maxHandshakesPerSecond");
+        this.maxPendingHandshakes = ObjectUtil.checkPositive(maxPendingHandshakes, "maxPendingHandshakes");
+        return self();
+    }
+
+    /**
+     * Limit the number of version negotiation packets that each codec sends per second, packets that exceed the
+     * limit are dropped. {@code 0} means no limit, which is the default.
+     */
+    public QuicServerCodecBuilder maxVersionNegotiationsPerSecond(int maxVersionNegotiationsPerSecond) {
+        this.maxVersionNegotiationsPerSecond = ObjectUtil.checkPositiveOrZero(
+                maxVersionNegotiationsPerSecond, "maxVersionNegotiationsPerSecond");
+        return self();
+    }
+
     @Override
     protected void validate() {
         super.validate();
@@ -124,18 +154,73 @@ public final class QuicServerCodecBuilder extends QuicCodecBuilder<QuicServerCod
         }
     }
 
+    /**
+     * Build {@code numShards} QUIC codecs that together form one QUIC server. Each of these should be added to the
+     * {@link io.netty.channel.ChannelPipeline} of its own {@link io.netty.channel.socket.DatagramChannel}, usually
+     * bound to the same address via {@code SO_REUSEPORT} and served by different {@link io.netty.channel.EventLoop}s.
+     *
+     * Each codec encodes its shard into the connection ids it chooses (see
+     * {@link #connectionIdAddressGenerator(QuicConnectionIdGenerator)}). Packets that are received by a codec that
+     * does not own the connection are forwarded to the owning codec.
+     */
+    public List<ChannelHandler> buildShards(int numShards) {
+        return buildShards(numShards, 0);
+    }
+
+    /**
+     * Build {@code numShards} QUIC codecs like {@link #buildShards(int)} does, but use the first
+     * {@code numHandshakeShards} of them only for handshakes. Once the handshake of a connection is complete it is
+     * handed off to one of the remaining worker shards (round-robin), which is where the {@link QuicChannel} is
+     * created and becomes active. This keeps expensive handshakes from adding latency to established connections.
+     *
+     * Handshake and worker shards must be bound to the same address via {@code SO_REUSEPORT}, as a worker sends the
+     * packets of a connection via its own {@link io.netty.channel.socket.DatagramChannel}.
+     */
+    public List<ChannelHandler> buildShards(int numShards, int numHandshakeShards) {
+        if (numShards < 1 || numShards > ShardedQuicConnectionIdGenerator.MAX_SHARDS) {
+            throw new IllegalArgumentException("numShards: " + numShards + " (expected: 1-" +
+                    ShardedQuicConnectionIdGenerator.MAX_SHARDS + ')');
+        }
+        if (numHandshakeShards < 0 || numHandshakeShards >= numShards) {
+            throw new IllegalArgumentException("numHandshakeShards: " + numHandshakeShards + " (expected: 0-" +
+                    (numShards - 1) + ')');
+        }
+        validate();
+        QuicheConfig config = createConfig();
+        QuicheQuicServerShards shards = new QuicheQuicServerShards(numShards, numHandshakeShards);
+        List<ChannelHandler> codecs = new ArrayList<>(numShards);
+        for (int i = 0; i < numShards; i++) {
+            codecs.add(newCodec(config, segmentedDatagramPacketAllocator(),
+                    new ShardedQuicConnectionIdGenerator(generator(), i, numShards), shards, i));
+        }
+        return codecs;
+    }
+
     @Override
-    protected ChannelHandler build(QuicheConfig config) {
+    protected ChannelHandler build(QuicheConfig config,
+                                   SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator) {
         validate();
-        QuicTokenHandler tokenHandler = this.tokenHandler;
+        return newCodec(config, segmentedDatagramPacketAllocator, generator(), null, 0);
+    }
+
+    private QuicConnectionIdGenerator generator() {
         QuicConnectionIdGenerator generator = connectionIdAddressGenerator;
         if (generator == null) {
             generator = QuicConnectionIdGenerator.randomGenerator();
         }
+        return generator;
+    }
+
+    private ChannelHandler newCodec(QuicheConfig config,
+                                    SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator,
+                                    QuicConnectionIdGenerator generator, QuicheQuicServerShards shards, int shardId) {
+        QuicTokenHandler tokenHandler = this.tokenHandler;
         ChannelHandler handler = this.handler;
         ChannelHandler streamHandler = this.streamHandler;
-        return new QuicheQuicServerCodec(config, tokenHandler, generator,
+        return new QuicheQuicServerCodec(config, segmentedDatagramPacketAllocator, tokenHandler, generator,
                 handler, Quic.optionsArray(options), Quic.attributesArray(attrs),
-                streamHandler, Quic.optionsArray(streamOptions), Quic.attributesArray(streamAttrs));
+                streamHandler, Quic.optionsArray(streamOptions), Quic.attributesArray(streamAttrs),
+                shards, shardId, metricsCollector(),
+                maxHandshakesPerSecond, maxPendingHandshakes, maxVersionNegotiationsPerSecond);
     }
 }
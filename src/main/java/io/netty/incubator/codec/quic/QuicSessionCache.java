@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import java.net.InetSocketAddress;
+
+/**
+ * Stores the TLS sessions of QUIC client connections, so reconnects to the same server can resume the session and
+ * send 0-RTT early data. Implementations must be thread-safe as the same cache is usually shared between
+ * {@link io.netty.channel.EventLoop}s.
+ *
+ * See {@link QuicChannelBootstrap#sessionCache(QuicSessionCache)}.
+ */
+public interface QuicSessionCache {
+
+    /**
+     * Returns the serialized session for the given server or {@code null} if there is none.
+     *
+     * @param serverName    the server name that is used to verify the certificate of the server, may be
+     *                      {@code null}.
+     * @param address       the address of the server.
+     */
+    byte[] getSession(String serverName, InetSocketAddress address);
+
+    /**
+     * Store the serialized session for the given server, replacing any previous one.
+     *
+     * @param serverName    the server name that is used to verify the certificate of the server, may be
+     *                      {@code null}.
+     * @param address       the address of the server.
+     * @param session       the serialized session.
+     */
+    void saveSession(String serverName, InetSocketAddress address, byte[] session);
+
+    /**
+     * Returns a new {@link QuicSessionCache} that keeps the sessions of at most {@code maxEntries} servers and
+     * evicts the least recently used one once it is full.
+     */
+    static QuicSessionCache newLruCache(int maxEntries) {
+        return new LruQuicSessionCache(maxEntries);
+    }
+}
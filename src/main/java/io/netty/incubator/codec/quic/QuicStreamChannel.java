@@ -15,6 +15,8 @@
  */
 package io.netty.incubator.codec.quic;
 
+import io.netty.channel.ChannelFuture;
+import io.netty.channel.ChannelPromise;
 import io.netty.channel.socket.DuplexChannel;
 
 /**
@@ -43,6 +45,25 @@ public interface QuicStreamChannel extends DuplexChannel {
      */
     long streamId();
 
+    /**
+     * Returns the {@link QuicStreamPriority} of the stream or {@code null} if none was set.
+     */
+    QuicStreamPriority priority();
+
+    /**
+     * Updates the priority of the stream. This affects the order in which data of the streams of the same
+     * {@link QuicChannel} is sent.
+     */
+    default ChannelFuture updatePriority(QuicStreamPriority priority) {
+        return updatePriority(priority, newPromise());
+    }
+
+    /**
+     * Updates the priority of the stream and notifies the {@link ChannelPromise} once done. This affects the order in
+     * which data of the streams of the same {@link QuicChannel} is sent.
+     */
+    ChannelFuture updatePriority(QuicStreamPriority priority, ChannelPromise promise);
+
     @Override
     QuicChannel parent();
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.ChannelId;
+import io.netty.channel.DefaultChannelId;
+
+/**
+ * {@link ChannelId} of a {@link QuicheQuicStreamChannel}, which is derived from the id of its {@link QuicChannel} and
+ * the stream id. This is a lot cheaper than {@link DefaultChannelId#newInstance()}, which matters when streams are
+ * short-lived, and also makes it easy to see to which connection a stream belongs.
+ */
+final class QuicStreamChannelId implements ChannelId {
+    private static final long serialVersionUID = -4214361092428371578L;
+
+    private final ChannelId parentId;
+    private final long streamId;
+
+    QuicStreamChannelId(ChannelId parentId, long streamId) {
+        this.parentId = parentId;
+        this.streamId = streamId;
+    }
+
+    @Override
+    public String asShortText() {
+        return parentId.asShortText() + '/' + streamId;
+    }
+
+    @Override
+    public String asLongText() {
+        return parentId.asLongText() + '/' + streamId;
+    }
+
+    @Override
+    public int compareTo(ChannelId o) {
+        if (o instanceof QuicStreamChannelId) {
+            QuicStreamChannelId other = (QuicStreamChannelId) o;
+            int res = parentId.compareTo(other.parentId);
+            if (res != 0) {
+                return res;
+            }
+            return Long.compare(streamId, other.streamId);
+        }
+        // Order by the parent first, so all streams of a connection are grouped together.
+        int res = parentId.compareTo(o);
+        return res != 0 ? res : 1;
+    }
+
+    @Override
+    public boolean equals(Object o) {
+        if (this == o) {
+            return true;
+        }
+        if (!(o instanceof QuicStreamChannelId)) {
+            return false;
+        }
+        QuicStreamChannelId other = (QuicStreamChannelId) o;
+        return streamId == other.streamId && parentId.equals(other.parentId);
+    }
+
+    @Override
+    public int hashCode() {
+        return 31 * parentId.hashCode() + Long.hashCode(streamId);
+    }
+
+    @Override
+    public String toString() {
+        return asShortText();
+    }
+}
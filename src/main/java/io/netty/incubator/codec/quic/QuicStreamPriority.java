@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+/**
+ * The priority of a {@link QuicStreamChannel}, following the
+ * <a href="https://tools.ietf.org/html/draft-ietf-httpbis-priority-02">Extensible Prioritization Scheme</a>.
+ *
+ * Data of streams with a lower urgency is sent before data of streams with a higher urgency. Streams that are
+ * incremental and have the same urgency share the available capacity, while non-incremental streams are sent one
+ * after the other.
+ *
+ * Streams without an explicit priority are scheduled after all streams that have one, which is the same as quiche
+ * does.
+ */
+public final class QuicStreamPriority {
+    /**
+     * The highest urgency (and so the most important) that can be used.
+     */
+    public static final int MIN_URGENCY = 0;
+
+    /**
+     * The lowest urgency (and so the least important) that can be used.
+     */
+    public static final int MAX_URGENCY = 7;
+
+    private final int urgency;
+    private final boolean incremental;
+
+    /**
+     * Create a new instance
+     *
+     * @param urgency       the urgency of the stream, between {@link #MIN_URGENCY} and {@link #MAX_URGENCY}.
+     * @param incremental   {@code true} if the data of the stream can be processed incrementally by the remote peer.
+     */
+    public QuicStreamPriority(int urgency, boolean incremental) {
+        if (urgency < MIN_URGENCY || urgency > MAX_URGENCY) {
+            throw new IllegalArgumentException(
+                    "urgency: " + urgency + " (expected: " + MIN_URGENCY + "-" + MAX_URGENCY + ")");
+        }
+        this.urgency = urgency;
+        this.incremental = incremental;
+    }
+
+    /**
+     * Returns the urgency of the stream.
+     */
+    public int urgency() {
+        return urgency;
+    }
+
+    /**
+     * Returns {@code true} if the data of the stream can be processed incrementally by the remote peer.
+     */
+    public boolean isIncremental() {
+        return incremental;
+    }
+
+    @Override
+    public boolean equals(Object o) {
+        if (this == o) {
+            return true;
+        }
+        if (!(o instanceof QuicStreamPriority)) {
+            return false;
+        }
+        QuicStreamPriority that = (QuicStreamPriority) o;
+        return urgency == that.urgency && incremental == that.incremental;
+    }
+
+    @Override
+    public int hashCode() {
+        return 31 * urgency + (incremental ? 1 : 0);
+    }
+
+    @Override
+    public String toString() {
+        return "QuicStreamPriority{urgency=" + urgency + ", incremental=" + incremental + '}';
+    }
+}
@@ -44,7 +44,7 @@ final class Quiche {
 
         // Let's enable debug logging for quiche if its enabled in our logger.
         if (DEBUG_LOGGING_ENABLED) {
-            quiche_enable_debug_logging(new QuicheLogger(logger));
+            QuicheLogger.start(logger);
         }
     }
 
@@ -196,6 +196,39 @@ final class Quiche {
     static native int quiche_header_info(long bufAddr, int bufLength, int dcil, long versionAddr, long typeAddr,
                                          long scidAddr, long scidLenAddr, long dcidAddr, long dcidLenAddr,
                                          long tokenAddr, long tokenLenAddr);
+
+    // Layout of one entry that is used by quiche_header_info_batch(...).
+    // This needs to be kept in sync with what is defined in netty_quic_quiche.c
+    static final int HEADER_INFO_BUF_OFFSET = 0;
+    static final int HEADER_INFO_BUF_LEN_OFFSET = 8;
+    static final int HEADER_INFO_RES_OFFSET = 12;
+    static final int HEADER_INFO_VERSION_OFFSET = 16;
+    static final int HEADER_INFO_TYPE_OFFSET = 20;
+    static final int HEADER_INFO_SCID_LEN_OFFSET = 24;
+    static final int HEADER_INFO_DCID_LEN_OFFSET = 28;
+    static final int HEADER_INFO_TOKEN_LEN_OFFSET = 32;
+    static final int HEADER_INFO_SCID_OFFSET = 36;
+    static final int HEADER_INFO_DCID_OFFSET = HEADER_INFO_SCID_OFFSET + QUICHE_MAX_CONN_ID_LEN;
+    static final int HEADER_INFO_TOKEN_OFFSET = HEADER_INFO_DCID_OFFSET + QUICHE_MAX_CONN_ID_LEN;
+
+    /**
+     * Returns the size of one entry that is used by {@link #quiche_header_info_batch(long, int, int, int)} when
+     * tokens of up to {@code maxTokenLength} bytes should be supported. The size is always a multiple of 8 so
+     * all entries are correctly aligned.
+     */
+    static int headerInfoEntryLength(int maxTokenLength) {
+        return (HEADER_INFO_TOKEN_OFFSET + maxTokenLength + 7) & ~7;
+    }
+
+    /**
+     * Calls <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L196">quiche_header_info</a>
+     * for each of the {@code numEntries} entries that start at {@code entriesAddr}. Each entry is
+     * {@code entryLen} bytes in size and must have the address and length of the packet filled in at
+     * {@link #HEADER_INFO_BUF_OFFSET} and {@link #HEADER_INFO_BUF_LEN_OFFSET}. The result of
+     * {@code quiche_header_info} and all the parsed values are stored in the entry itself.
+     */
+    static native void quiche_header_info_batch(long entriesAddr, int numEntries, int entryLen, int dcil);
+
     /**
      * See <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L215">quiche_negotiate_version</a>.
      */
@@ -224,11 +257,53 @@ final class Quiche {
      */
     static native int quiche_conn_recv(long connAddr, long bufAddr, int bufLen);
 
+    // Flags that are part of the status returned by quiche_conn_recv_and_poll(...).
+    // This needs to be kept in sync with what is defined in netty_quic_quiche.c
+    static final long RECV_AND_POLL_ESTABLISHED = 1L << 32;
+    static final long RECV_AND_POLL_EARLY_DATA = 1L << 33;
+    static final long RECV_AND_POLL_CLOSED = 1L << 34;
+    static final long RECV_AND_POLL_TRUNCATED = 1L << 35;
+    private static final int RECV_AND_POLL_STREAMS_SHIFT = 40;
+
+    /**
+     * Calls <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L249">quiche_conn_recv</a> and
+     * after that checks the state of the connection. If the connection is established or in early data the ids of
+     * up to {@code maxStreamIds} readable streams are written to {@code streamIdsAddr}.
+     *
+     * The returned status contains the result of {@code quiche_conn_recv} (see {@link #recvAndPollResult(long)}),
+     * the {@code RECV_AND_POLL_*} flags and the number of stream ids that were written
+     * (see {@link #recvAndPollStreams(long)}). If {@link #RECV_AND_POLL_TRUNCATED} is set there were more readable
+     * streams than could be written and {@link #quiche_conn_readable(long)} must be used to process all of them.
+     */
+    static native long quiche_conn_recv_and_poll(long connAddr, long bufAddr, int bufLen,
+                                                 long streamIdsAddr, int maxStreamIds);
+
+    static int recvAndPollResult(long status) {
+        return (int) status;
+    }
+
+    static int recvAndPollStreams(long status) {
+        return (int) (status >>> RECV_AND_POLL_STREAMS_SHIFT);
+    }
+
     /**
      * See <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L262">quiche_conn_send</a>.
      */
     static native int quiche_conn_send(long connAddr, long outAddr, int outLen);
 
+    /**
+     * Calls <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L262">quiche_conn_send</a>
+     * multiple times and packs the produced packets back-to-back into the buffer at {@code outAddr}.
+     * Each packet takes at most {@code maxPacketLen} bytes and its length is stored as an {@code int} (in native
+     * byte order) at {@code packetLensAddr}.
+     *
+     * This method will return the number of packets written. If nothing was written the error of the
+     * underlying {@code quiche_conn_send} call is returned. If this number is less than {@code maxPackets} there
+     * is nothing more to send for now.
+     */
+    static native int quiche_conn_send_batch(long connAddr, long outAddr, int outLen, int maxPacketLen,
+                                             long packetLensAddr, int maxPackets);
+
     /**
      * See <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L373">quiche_conn_free</a>.
      */
@@ -248,12 +323,53 @@ final class Quiche {
      */
     static native int quiche_conn_stream_send(long connAddr, long streamId, long bufAddr, int bufLen, boolean fin);
 
+    // Each entry used by quiche_conn_stream_send_iov(...) consists of the address and the length as int64.
+    static final int QUICHE_STATS_RECV_OFFSET = 0;
+    static final int QUICHE_STATS_SENT_OFFSET = QUICHE_STATS_RECV_OFFSET + Long.BYTES;
+    static final int QUICHE_STATS_LOST_OFFSET = QUICHE_STATS_SENT_OFFSET + Long.BYTES;
+    static final int QUICHE_STATS_RTT_OFFSET = QUICHE_STATS_LOST_OFFSET + Long.BYTES;
+    static final int QUICHE_STATS_CWND_OFFSET = QUICHE_STATS_RTT_OFFSET + Long.BYTES;
+    static final int QUICHE_STATS_DELIVERY_RATE_OFFSET = QUICHE_STATS_CWND_OFFSET + Long.BYTES;
+    static final int QUICHE_STATS_LEN = QUICHE_STATS_DELIVERY_RATE_OFFSET + Long.BYTES;
+
+    static final int STREAM_SEND_IOV_ENTRY_SIZE = 2 * Long.BYTES;
+
+    /**
+     * Calls <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L262">quiche_conn_stream_send</a>
+     * for each of the {@code iovCount} (address, length) pairs that start at {@code iovAddr} until either all were
+     * written or the stream has no capacity left. {@code fin} is only set for the last pair.
+     *
+     * Returns the number of bytes that were written or the error if nothing could be written.
+     */
+    static native int quiche_conn_stream_send_iov(long connAddr, long streamId, long iovAddr, int iovCount,
+                                                  boolean fin);
+
+    // Returned by quiche_conn_stream_send_array(...) if the array could not be accessed.
+    // This needs to be kept in sync with what is defined in netty_quic_quiche.c
+    static final int NETTY_QUIC_ERR_OUT_OF_MEMORY = Integer.MIN_VALUE;
+
+    /**
+     * See <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L262">quiche_conn_stream_send</a>,
+     * but uses the given {@code byte[]} directly via {@code GetPrimitiveArrayCritical} to not need a copy to direct
+     * memory.
+     *
+     * Returns {@link #NETTY_QUIC_ERR_OUT_OF_MEMORY} if the JVM could not provide access to the array.
+     */
+    static native int quiche_conn_stream_send_array(long connAddr, long streamId, byte[] array, int offset, int len,
+                                                    boolean fin);
+
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L271">quiche_conn_stream_shutdown</a>.
      */
     static native int quiche_conn_stream_shutdown(long connAddr, long streamId, int direction, long err);
 
+    /**
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L275">quiche_conn_stream_priority</a>.
+     */
+    static native int quiche_conn_stream_priority(long connAddr, long streamId, byte urgency, boolean incremental);
+
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L274">quiche_conn_stream_capacity</a>.
@@ -300,11 +416,43 @@ final class Quiche {
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L361">quiche_conn_stats</a>.
-     * The implementation relies on all fields of
-     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L340">quiche_stats</a> being numerical.
-     * The assumption made allows passing primitive array rather than dealing with objects.
+     * The fields of
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L340">quiche_stats</a> are written as
+     * {@code int64_t}s to {@code statsAddr} in the order of the {@code QUICHE_STATS_*_OFFSET} constants, so no new
+     * objects need to be created.
+     */
+    static native void quiche_conn_stats(long connAddr, long statsAddr);
+
+    /**
+     * Returns {@code true} if the native library was compiled against a quiche version that allows to get and set
+     * the TLS session of a connection. If not {@link #quiche_conn_session(long, long, int)} and
+     * {@link #quiche_conn_set_session(long, long, int)} always return {@link #QUICHE_ERR_DONE}.
+     */
+    static native boolean quiche_session_resumption_supported();
+
+    /**
+     * Copies the serialized TLS session of the connection to {@code buf}, which can be used with
+     * {@link #quiche_conn_set_session(long, long, int)} to resume it later. Returns the length of the session,
+     * {@link #QUICHE_ERR_DONE} if there is none yet or {@link #QUICHE_ERR_BUFFER_TOO_SHORT} if {@code buf} is too
+     * small.
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.10.0/include/quiche.h#L291">quiche_conn_session</a>.
      */
-    static native long[] quiche_conn_stats(long connAddr);
+    static native int quiche_conn_session(long connAddr, long buf, int bufLen);
+
+    /**
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.10.0/include/quiche.h#L288">quiche_conn_set_session</a>.
+     */
+    static native int quiche_conn_set_session(long connAddr, long buf, int bufLen);
+
+    /**
+     * Enables qlog for the connection and writes it to {@code path}. Returns {@code false} if qlog could not be
+     * enabled, which is always the case if the native library was not compiled with qlog support.
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L218">quiche_conn_set_qlog_path</a>.
+     */
+    static native boolean quiche_conn_set_qlog_path(long connAddr, String path, String logTitle, String logDescription);
 
     /**
      * See
@@ -324,15 +472,24 @@ final class Quiche {
      */
     static native long quiche_conn_readable(long connAddr);
 
+    /**
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L285">quiche_conn_writable</a>.
+     *
+     * The returned iterator can be used with {@link #quiche_stream_iter_next(long, long, int)} and must be released
+     * via {@link #quiche_stream_iter_free(long)}.
+     */
+    static native long quiche_conn_writable(long connAddr);
+
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L329">quiche_stream_iter_next</a>.
      *
-     * This method will fill the {@code streamIds} array and return the number of streams that were filled into
-     * the array. If the number is the same as the length of the array you should call it again until it returns
-     * less to ensure you process all the streams later on.
+     * This method will write up to {@code len} stream ids to {@code streamIdsAddr} and return the number of
+     * streams that were written. If the number is the same as {@code len} you should call it again until it
+     * returns less to ensure you process all the streams later on.
      */
-    static native int quiche_stream_iter_next(long iterAddr, long[] streamIds);
+    static native int quiche_stream_iter_next(long iterAddr, long streamIdsAddr, int len);
 
     /**
      * See
@@ -348,6 +505,20 @@ final class Quiche {
      */
     static native int quiche_conn_dgram_max_writable_len(long connAddr);
 
+    /**
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L361">
+     *     quiche_conn_dgram_recv</a>.
+     */
+    static native int quiche_conn_dgram_recv(long connAddr, long buf, int size);
+
+    /**
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L365">
+     *     quiche_conn_dgram_send</a>.
+     */
+    static native int quiche_conn_dgram_send(long connAddr, long buf, int size);
+
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L115">quiche_config_new</a>.
@@ -368,6 +539,24 @@ final class Quiche {
      */
     static native int quiche_config_load_priv_key_from_pem_file(long configAddr, String path);
 
+    // Returned by the *_from_pem(...) methods if the PEM can not be loaded from memory on this platform.
+    // This needs to be kept in sync with what is defined in netty_quic_quiche.c
+    static final int PEM_FROM_MEMORY_UNSUPPORTED = 1;
+
+    /**
+     * Same as {@link #quiche_config_load_cert_chain_from_pem_file(long, String)} but loads the given PEM from
+     * memory, without writing it to the file system. Returns {@link #PEM_FROM_MEMORY_UNSUPPORTED} if this is not
+     * supported on the current platform.
+     */
+    static native int quiche_config_load_cert_chain_from_pem(long configAddr, byte[] pem);
+
+    /**
+     * Same as {@link #quiche_config_load_priv_key_from_pem_file(long, String)} but loads the given PEM from memory,
+     * without writing it to the file system. Returns {@link #PEM_FROM_MEMORY_UNSUPPORTED} if this is not supported
+     * on the current platform.
+     */
+    static native int quiche_config_load_priv_key_from_pem(long configAddr, byte[] pem);
+
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#126">
@@ -487,6 +676,14 @@ final class Quiche {
      */
     static native void quiche_config_enable_hystart(long configAddr, boolean value);
 
+    /**
+     * See
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#187">
+     *     quiche_config_enable_dgram</a>.
+     */
+    static native void quiche_config_enable_dgram(long configAddr, boolean enable,
+                                                  int recv_queue_len, int send_queue_len);
+
     /**
      * See
      * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#192">
@@ -495,10 +692,24 @@ final class Quiche {
     static native void quiche_config_free(long configAddr);
 
     /**
+     * Enables debug logging of quiche. Log lines are not passed to Java directly but collected in a native ring buffer
+     * that must be drained via {@link #quiche_log_drain(long, int)}. Returns {@code false} if logging was already
+     * enabled or the ring could not be allocated.
      * See
-     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L108">quiche_config_new</a>.
+     * <a href="https://github.com/cloudflare/quiche/blob/0.6.0/include/quiche.h#L41">quiche_enable_debug_logging</a>.
      */
-    private static native void quiche_enable_debug_logging(QuicheLogger logger);
+    static native boolean quiche_enable_debug_logging();
+
+    /**
+     * Copies as many log lines from the native ring buffer to {@code buf} as fit. Each line is prefixed by its length
+     * as an {@code int} in native byte order. Returns the number of bytes written. Must not be called concurrently.
+     */
+    static native int quiche_log_drain(long buf, int bufLen);
+
+    /**
+     * Returns the number of log lines that were dropped so far because the native ring buffer was full.
+     */
+    static native long quiche_log_dropped();
 
     private static native long buffer_memory_address(ByteBuffer buffer);
 
@@ -511,6 +722,15 @@ final class Quiche {
                 buffer_memory_address(buf.internalNioBuffer(buf.readerIndex(), buf.readableBytes()));
     }
 
+    /**
+     * Returns the memory address of the {@link ByteBuf#readerIndex()} of the given direct {@link ByteBuf}.
+     */
+    static long readerMemoryAddress(ByteBuf buf) {
+        assert buf.isDirect();
+        return buf.hasMemoryAddress() ? buf.memoryAddress() + buf.readerIndex() :
+                buffer_memory_address(buf.internalNioBuffer(buf.readerIndex(), buf.readableBytes()));
+    }
+
     static long memoryAddress(ByteBuffer buf) {
         assert buf.isDirect();
         return buffer_memory_address(buf);
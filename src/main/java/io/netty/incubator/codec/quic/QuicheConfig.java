@@ -15,9 +15,28 @@
  */
 package io.netty.incubator.codec.quic;
 
+import java.net.InetSocketAddress;
+import java.util.concurrent.atomic.AtomicReferenceArray;
+
+/**
+ * The configuration of a codec. The native {@code quiche_config} that is created from it is shared by all the codecs
+ * that use the same {@link QuicheConfig}, like the shards of a server.
+ *
+ * If flow control autotuning is enabled there is one native config per window tier, as quiche only takes the flow
+ * control windows from the config when a connection is created. Each tier has four times the windows of the previous
+ * one, up to the configured limits. The native configs of all tiers are created when the first codec is attached and
+ * when the certificate of the {@link QuicCertificateProvider} is updated, never while creating a connection.
+ */
 final class QuicheConfig {
+    // The factor (as shift) by which the windows grow from one tier to the next.
+    private static final int WINDOW_TIER_SHIFT = 2;
+    private static final int MAX_WINDOW_TIERS = 8;
+    // The number of peers we remember the bandwidth-delay product of.
+    private static final int MAX_BDP_HISTORY_PEERS = 4096;
+
     private final String certPath;
     private final String keyPath;
+    private final QuicCertificateProvider certificateProvider;
     private final Boolean verifyPeer;
     private final Boolean grease;
     private final  boolean earlyData;
@@ -35,15 +54,32 @@ final class QuicheConfig {
     private final Boolean disableActiveMigration;
     private final Boolean enableHystart;
     private final QuicCongestionControlAlgorithm congestionControlAlgorithm;
+    private final int recvQueueLen;
+    private final int sendQueueLen;
+    private final QuicheQuicMemoryBudget memoryBudget;
+    private final boolean pacing;
+    private final long maxDataLimit;
+    private final long maxStreamDataLimit;
+    private final int windowTiers;
+    private final QuicheQuicBdpHistory bdpHistory;
+
+    // The native configs of all window tiers, null while no codec is attached.
+    private volatile AtomicReferenceArray<QuicheNativeConfig> nativeConfigs;
+    // The number of codecs that use the native config, guarded by this.
+    private int users;
 
-    QuicheConfig(String certPath, String keyPath, Boolean verifyPeer, Boolean grease, boolean earlyData,
+    QuicheConfig(String certPath, String keyPath, QuicCertificateProvider certificateProvider,
+                        Boolean verifyPeer, Boolean grease, boolean earlyData,
                         byte[] protos, Long maxIdleTimeout, Long maxUdpPayloadSize, Long initialMaxData,
                         Long initialMaxStreamDataBidiLocal, Long initialMaxStreamDataBidiRemote,
                         Long initialMaxStreamDataUni, Long initialMaxStreamsBidi, Long initialMaxStreamsUni,
                         Long ackDelayExponent, Long maxAckDelay, Boolean disableActiveMigration, Boolean enableHystart,
-                        QuicCongestionControlAlgorithm congestionControlAlgorithm) {
+                        QuicCongestionControlAlgorithm congestionControlAlgorithm,
+                        int recvQueueLen, int sendQueueLen, long maxConnectionMemory, long maxTotalMemory,
+                        boolean pacing, long maxDataLimit, long maxStreamDataLimit) {
         this.certPath = certPath;
         this.keyPath = keyPath;
+        this.certificateProvider = certificateProvider;
         this.verifyPeer = verifyPeer;
         this.grease = grease;
         this.earlyData = earlyData;
@@ -61,19 +97,217 @@ final class QuicheConfig {
         this.disableActiveMigration = disableActiveMigration;
         this.enableHystart = enableHystart;
         this.congestionControlAlgorithm = congestionControlAlgorithm;
+        this.recvQueueLen = recvQueueLen;
+        this.sendQueueLen = sendQueueLen;
+        this.memoryBudget = new QuicheQuicMemoryBudget(maxConnectionMemory, maxTotalMemory);
+        this.pacing = pacing;
+        this.maxDataLimit = maxDataLimit;
+        this.maxStreamDataLimit = maxStreamDataLimit;
+        // Add tiers until all windows reached their limit. The tier is chosen by the connection window, so without
+        // one there is nothing to tune.
+        int tiers = 1;
+        if (initialMaxData != null && initialMaxData > 0) {
+            while (tiers < MAX_WINDOW_TIERS && (canGrow(initialMaxData, maxDataLimit, tiers - 1) ||
+                    canGrow(initialMaxStreamDataBidiLocal, maxStreamDataLimit, tiers - 1) ||
+                    canGrow(initialMaxStreamDataBidiRemote, maxStreamDataLimit, tiers - 1) ||
+                    canGrow(initialMaxStreamDataUni, maxStreamDataLimit, tiers - 1))) {
+                tiers++;
+            }
+        }
+        this.windowTiers = tiers;
+        this.bdpHistory = tiers > 1 ? new QuicheQuicBdpHistory(MAX_BDP_HISTORY_PEERS) : null;
+    }
+
+    private static boolean canGrow(Long window, long limit, int tier) {
+        return window != null && window > 0 && window(window, limit, tier) < limit;
     }
 
     /**
-     * Creates the native config object and return it.
+     * Returns the window of the given tier, which is never smaller than the configured {@code window} and, unless
+     * the configured {@code window} already is, never larger than {@code limit}.
      */
-    long createNativeConfig() {
-        long config = Quiche.quiche_config_new(Quiche.QUICHE_PROTOCOL_VERSION);
+    private static Long window(Long window, long limit, int tier) {
+        if (window == null || window <= 0 || tier == 0 || window >= limit) {
+            return window;
+        }
+        if (window > limit >> (WINDOW_TIER_SHIFT * tier)) {
+            return limit;
+        }
+        return window << (WINDOW_TIER_SHIFT * tier);
+    }
+
+    /**
+     * Returns {@code true} if the support of QUIC DATAGRAM frames was enabled.
+     */
+    boolean isDatagramSupported() {
+        return recvQueueLen > 0 && sendQueueLen > 0;
+    }
+
+    /**
+     * Returns {@code true} if outgoing packets should be paced.
+     */
+    boolean isPacingEnabled() {
+        return pacing;
+    }
+
+    /**
+     * Returns the {@link QuicheQuicBdpHistory} that is updated by the connections, or {@code null} if flow control
+     * autotuning is disabled.
+     */
+    QuicheQuicBdpHistory bdpHistory() {
+        return bdpHistory;
+    }
+
+    /**
+     * Returns the window tier to use for a new connection to the given peer. This is the smallest tier whose
+     * connection window is at least twice the bandwidth-delay product that was measured for the peer before, so a
+     * connection that was limited by its window gets a larger one the next time.
+     */
+    int windowTier(InetSocketAddress remote) {
+        if (bdpHistory == null || remote == null) {
+            return 0;
+        }
+        long bdp = bdpHistory.get(remote.getAddress());
+        int tier = 0;
+        while (tier < windowTiers - 1 && window(initialMaxData, maxDataLimit, tier) < 2 * bdp) {
+            tier++;
+        }
+        return tier;
+    }
+
+    /**
+     * Returns the {@link QuicheQuicMemoryBudget} that is shared by all the codecs that use this config.
+     */
+    QuicheQuicMemoryBudget memoryBudget() {
+        return memoryBudget;
+    }
+
+    /**
+     * Register a codec that uses this config, the native configs are created for the first one.
+     */
+    void attach() {
+        if (certificateProvider == null) {
+            attach0();
+        } else {
+            // Always lock the provider first, as it reloads our native configs while holding its lock.
+            synchronized (certificateProvider) {
+                if (attach0()) {
+                    certificateProvider.register(this);
+                }
+            }
+        }
+    }
+
+    private synchronized boolean attach0() {
+        if (users++ == 0) {
+            nativeConfigs = createNativeConfigs();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Unregister a codec that uses this config, the native configs are released once the last one is gone.
+     */
+    void detach() {
+        if (certificateProvider == null) {
+            detach0();
+        } else {
+            synchronized (certificateProvider) {
+                if (detach0()) {
+                    certificateProvider.unregister(this);
+                }
+            }
+        }
+    }
+
+    private synchronized boolean detach0() {
+        assert users > 0;
+        if (--users == 0) {
+            AtomicReferenceArray<QuicheNativeConfig> configs = nativeConfigs;
+            nativeConfigs = null;
+            release(configs);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Replace the native configs with new ones that use the current certificate of the
+     * {@link QuicCertificateProvider}. This is called by the thread that updated the provider.
+     */
+    synchronized void reloadNativeConfigs() {
+        AtomicReferenceArray<QuicheNativeConfig> configs = nativeConfigs;
+        if (configs == null) {
+            return;
+        }
+        AtomicReferenceArray<QuicheNativeConfig> newConfigs = createNativeConfigs();
+        for (int i = 0; i < newConfigs.length(); i++) {
+            // Existing connections don't need the old config anymore, so we can just release it.
+            configs.getAndSet(i, newConfigs.get(i)).release();
+        }
+    }
+
+    // Create the native configs of all tiers up front, so the event loops never need to create one.
+    private AtomicReferenceArray<QuicheNativeConfig> createNativeConfigs() {
+        AtomicReferenceArray<QuicheNativeConfig> configs = new AtomicReferenceArray<>(windowTiers);
         try {
-            if (certPath != null && Quiche.quiche_config_load_cert_chain_from_pem_file(config, certPath) != 0) {
-                throw new IllegalArgumentException("Unable to load certificate chain");
+            for (int i = 0; i < windowTiers; i++) {
+                configs.set(i, createNativeConfig(i));
             }
-            if (keyPath != null && Quiche.quiche_config_load_priv_key_from_pem_file(config, keyPath) != 0) {
-                throw new IllegalArgumentException("Unable to load private key");
+        } catch (Throwable cause) {
+            release(configs);
+            throw cause;
+        }
+        return configs;
+    }
+
+    private static void release(AtomicReferenceArray<QuicheNativeConfig> configs) {
+        for (int i = 0; i < configs.length(); i++) {
+            QuicheNativeConfig config = configs.get(i);
+            if (config != null) {
+                config.release();
+            }
+        }
+    }
+
+    /**
+     * Returns the retained {@link QuicheNativeConfig} with the initial windows, see {@link #acquireNativeConfig(int)}.
+     */
+    QuicheNativeConfig acquireNativeConfig() {
+        return acquireNativeConfig(0);
+    }
+
+    /**
+     * Returns the retained {@link QuicheNativeConfig} of the given window tier to use for a new connection, which
+     * must be released once the connection was created.
+     */
+    QuicheNativeConfig acquireNativeConfig(int tier) {
+        for (;;) {
+            AtomicReferenceArray<QuicheNativeConfig> configs = nativeConfigs;
+            if (configs == null) {
+                throw new IllegalStateException("QuicheConfig not attached");
+            }
+            QuicheNativeConfig config = configs.get(tier);
+            if (config.tryRetain()) {
+                return config;
+            }
+            // The config was replaced and freed concurrently, try again.
+        }
+    }
+
+    private QuicheNativeConfig createNativeConfig(int tier) {
+        long config = Quiche.quiche_config_new(Quiche.QUICHE_PROTOCOL_VERSION);
+        try {
+            if (certificateProvider != null) {
+                certificateProvider.load(config);
+            } else {
+                if (certPath != null && Quiche.quiche_config_load_cert_chain_from_pem_file(config, certPath) != 0) {
+                    throw new IllegalArgumentException("Unable to load certificate chain");
+                }
+                if (keyPath != null && Quiche.quiche_config_load_priv_key_from_pem_file(config, keyPath) != 0) {
+                    throw new IllegalArgumentException("Unable to load private key");
+                }
             }
             if (verifyPeer != null) {
                 Quiche.quiche_config_verify_peer(config, verifyPeer);
@@ -93,17 +327,21 @@ final class QuicheConfig {
             if (maxUdpPayloadSize != null) {
                 Quiche.quiche_config_set_max_udp_payload_size(config, maxUdpPayloadSize);
             }
-            if (initialMaxData != null) {
-                Quiche.quiche_config_set_initial_max_data(config, initialMaxData);
+            Long maxData = window(initialMaxData, maxDataLimit, tier);
+            if (maxData != null) {
+                Quiche.quiche_config_set_initial_max_data(config, maxData);
             }
-            if (initialMaxStreamDataBidiLocal != null) {
-                Quiche.quiche_config_set_initial_max_stream_data_bidi_local(config, initialMaxStreamDataBidiLocal);
+            Long maxStreamDataBidiLocal = window(initialMaxStreamDataBidiLocal, maxStreamDataLimit, tier);
+            if (maxStreamDataBidiLocal != null) {
+                Quiche.quiche_config_set_initial_max_stream_data_bidi_local(config, maxStreamDataBidiLocal);
             }
-            if (initialMaxStreamDataBidiRemote != null) {
-                Quiche.quiche_config_set_initial_max_stream_data_bidi_remote(config, initialMaxStreamDataBidiRemote);
+            Long maxStreamDataBidiRemote = window(initialMaxStreamDataBidiRemote, maxStreamDataLimit, tier);
+            if (maxStreamDataBidiRemote != null) {
+                Quiche.quiche_config_set_initial_max_stream_data_bidi_remote(config, maxStreamDataBidiRemote);
             }
-            if (initialMaxStreamDataUni != null) {
-                Quiche.quiche_config_set_initial_max_stream_data_uni(config, initialMaxStreamDataUni);
+            Long maxStreamDataUni = window(initialMaxStreamDataUni, maxStreamDataLimit, tier);
+            if (maxStreamDataUni != null) {
+                Quiche.quiche_config_set_initial_max_stream_data_uni(config, maxStreamDataUni);
             }
             if (initialMaxStreamsBidi != null) {
                 Quiche.quiche_config_set_initial_max_streams_bidi(config, initialMaxStreamsBidi);
@@ -136,7 +374,10 @@ final class QuicheConfig {
                                 "Unknown congestionControlAlgorithm: " + congestionControlAlgorithm);
                 }
             }
-            return config;
+            if (isDatagramSupported()) {
+                Quiche.quiche_config_enable_dgram(config, true, recvQueueLen, sendQueueLen);
+            }
+            return new QuicheNativeConfig(config);
         } catch (Throwable cause) {
             Quiche.quiche_config_free(config);
             throw cause;
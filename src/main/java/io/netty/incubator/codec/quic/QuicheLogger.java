@@ -15,20 +15,69 @@
  */
 package io.netty.incubator.codec.quic;
 
+import io.netty.buffer.ByteBuf;
+import io.netty.util.CharsetUtil;
+import io.netty.util.concurrent.DefaultThreadFactory;
+import io.netty.util.internal.SystemPropertyUtil;
 import io.netty.util.internal.logging.InternalLogger;
 
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
+
 /**
  * Delegates QUICHE logging to {@link InternalLogger}.
+ *
+ * quiche logs from the thread that processes the packets, so the native side only copies the lines into a lock-free
+ * ring buffer. A background thread drains the ring in batches and passes the lines to the {@link InternalLogger}.
+ * Lines that do not fit into the ring are dropped and counted.
  */
-final class QuicheLogger {
+final class QuicheLogger implements Runnable {
+    private static final long DRAIN_INTERVAL_MILLIS = SystemPropertyUtil.getLong(
+            "io.netty.incubator.codec.quic.logDrainIntervalMillis", 100);
+    private static final int DRAIN_BUFFER_SIZE = 64 * 1024;
+
     private final InternalLogger logger;
+    // Only accessed from the drain thread.
+    private final ByteBuf buffer = QuicheQuicCodec.allocateNativeOrder(DRAIN_BUFFER_SIZE);
+    private long dropped;
 
-    QuicheLogger(InternalLogger logger) {
+    private QuicheLogger(InternalLogger logger) {
         this.logger = logger;
     }
 
-    // Called from JNI.
-    void log(String msg) {
-        logger.debug(msg);
+    /**
+     * Enable quiche debug logging and start draining the log lines to the given {@link InternalLogger}.
+     */
+    static void start(InternalLogger logger) {
+        if (!Quiche.quiche_enable_debug_logging()) {
+            return;
+        }
+        ScheduledExecutorService executor = Executors.newSingleThreadScheduledExecutor(
+                new DefaultThreadFactory("quiche-logger", true));
+        executor.scheduleWithFixedDelay(new QuicheLogger(logger),
+                DRAIN_INTERVAL_MILLIS, DRAIN_INTERVAL_MILLIS, TimeUnit.MILLISECONDS);
+    }
+
+    @Override
+    public void run() {
+        for (;;) {
+            buffer.clear();
+            int written = Quiche.quiche_log_drain(Quiche.memoryAddress(buffer), buffer.capacity());
+            if (written == 0) {
+                break;
+            }
+            buffer.writerIndex(written);
+            while (buffer.isReadable()) {
+                int len = buffer.readInt();
+                logger.debug(buffer.toString(buffer.readerIndex(), len, CharsetUtil.UTF_8));
+                buffer.skipBytes(len);
+            }
+        }
+        long dropped = Quiche.quiche_log_dropped();
+        if (dropped != this.dropped) {
+            logger.debug("Dropped {} quiche log lines as the log buffer was full", dropped - this.dropped);
+            this.dropped = dropped;
+        }
     }
 }
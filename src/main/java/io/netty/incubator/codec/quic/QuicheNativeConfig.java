@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Reference counted native {@code quiche_config} that can be shared by multiple codecs. quiche only uses the config
+ * while creating a connection, so it can be freed once it was replaced even if connections that were created with
+ * it are still alive.
+ */
+final class QuicheNativeConfig {
+    private final AtomicInteger refCnt = new AtomicInteger(1);
+    private final long address;
+
+    QuicheNativeConfig(long address) {
+        this.address = address;
+    }
+
+    /**
+     * Returns the address of the {@code quiche_config}.
+     */
+    long address() {
+        return address;
+    }
+
+    /**
+     * Increment the reference count and return {@code true}, or return {@code false} if the config was already freed.
+     */
+    boolean tryRetain() {
+        for (;;) {
+            int refCnt = this.refCnt.get();
+            if (refCnt == 0) {
+                return false;
+            }
+            if (this.refCnt.compareAndSet(refCnt, refCnt + 1)) {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Decrement the reference count and free the {@code quiche_config} once it reaches {@code 0}.
+     */
+    void release() {
+        int refCnt = this.refCnt.decrementAndGet();
+        if (refCnt == 0) {
+            Quiche.quiche_config_free(address);
+        } else if (refCnt < 0) {
+            throw new IllegalStateException("QuicheNativeConfig released too often");
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.internal.ObjectUtil;
+
+import java.net.InetAddress;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * Bounded history of the bandwidth-delay product that was measured on the connections to each peer, which evicts
+ * the least recently used peer. It is only looked up and updated once per connection, so a lock is cheap enough here.
+ *
+ * The estimate grows to a larger measurement right away, so a peer on a long fat path gets larger windows on its
+ * next connection, and only decays slowly so a single short connection does not undo that.
+ */
+final class QuicheQuicBdpHistory {
+    private final Map<InetAddress, Long> peers;
+
+    QuicheQuicBdpHistory(int maxPeers) {
+        ObjectUtil.checkPositive(maxPeers, "maxPeers");
+        peers = new LinkedHashMap<InetAddress, Long>(16, 0.75f, true) {
+            @Override
+            protected boolean removeEldestEntry(Map.Entry<InetAddress, Long> eldest) {
+                return size() > maxPeers;
+            }
+        };
+    }
+
+    /**
+     * Returns the estimated bandwidth-delay product in bytes for the given peer, or {@code 0} if it is unknown.
+     */
+    long get(InetAddress peer) {
+        synchronized (peers) {
+            Long bdp = peers.get(peer);
+            return bdp == null ? 0 : bdp;
+        }
+    }
+
+    /**
+     * Update the estimate of the given peer with the bandwidth-delay product in bytes that was measured on one of
+     * its connections.
+     */
+    void record(InetAddress peer, long bdp) {
+        synchronized (peers) {
+            Long old = peers.get(peer);
+            if (old == null || bdp >= old) {
+                peers.put(peer, bdp);
+            } else {
+                peers.put(peer, old - (old - bdp) / 4);
+            }
+        }
+    }
+}
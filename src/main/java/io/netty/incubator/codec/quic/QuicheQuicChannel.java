@@ -17,9 +17,11 @@ package io.netty.incubator.codec.quic;
 
 import io.netty.buffer.ByteBuf;
 import io.netty.buffer.ByteBufAllocator;
+import io.netty.buffer.CompositeByteBuf;
 import io.netty.buffer.Unpooled;
 import io.netty.channel.AbstractChannel;
 import io.netty.channel.Channel;
+import io.netty.channel.ChannelException;
 import io.netty.channel.ChannelFuture;
 import io.netty.channel.ChannelFutureListener;
 import io.netty.channel.ChannelHandler;
@@ -38,9 +40,12 @@ import io.netty.util.collection.LongObjectHashMap;
 import io.netty.util.collection.LongObjectMap;
 import io.netty.util.concurrent.Future;
 import io.netty.util.concurrent.Promise;
+import io.netty.util.internal.StringUtil;
+import io.netty.util.internal.SystemPropertyUtil;
 import io.netty.util.internal.logging.InternalLogger;
 import io.netty.util.internal.logging.InternalLoggerFactory;
 
+import java.io.File;
 import java.net.ConnectException;
 import java.net.InetSocketAddress;
 import java.net.SocketAddress;
@@ -48,11 +53,11 @@ import java.nio.ByteBuffer;
 import java.nio.channels.AlreadyConnectedException;
 import java.nio.channels.ClosedChannelException;
 import java.nio.channels.ConnectionPendingException;
-import java.util.ArrayDeque;
+import java.util.Arrays;
 import java.util.Map;
-import java.util.Queue;
 import java.util.concurrent.ScheduledFuture;
 import java.util.concurrent.TimeUnit;
+import java.util.function.Predicate;
 /**
  * {@link QuicChannel} implementation that uses <a href="https://github.com/cloudflare/quiche">quiche</a>.
  */
@@ -107,29 +112,88 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
     }
 
     private static final ChannelMetadata METADATA = new ChannelMetadata(false);
-    private final long[] readableStreams = new long[128];
+    // The maximum number of packets we let quiche produce in one quiche_conn_send_batch(...) call.
+    private static final int MAX_SEND_BATCH = Math.max(1, SystemPropertyUtil.getInt(
+            "io.netty.incubator.codec.quic.maxSendBatch", 16));
+    // The maximum number of readable stream ids we let quiche_conn_recv_and_poll(...) write in one call.
+    private static final int MAX_READABLE_STREAMS = 128;
+    // The maximum number of writable stream ids we let quiche_stream_iter_next(...) write in one call.
+    private static final int MAX_WRITABLE_STREAMS = 128;
+    // The maximum number of memory regions we pass to quiche_conn_stream_send_iov(...) in one call.
+    private static final int MAX_STREAM_SEND_IOV = 64;
+    // The maximum length of a serialized TLS session that we store in the QuicSessionCache.
+    private static final int MAX_SESSION_LEN = 8192;
+    // Pace slightly faster than cwnd / rtt so the pacing itself does not end up limiting the congestion controller.
+    private static final double PACING_GAIN = 1.25;
+    // The number of packets we always allow to be sent in one burst when pacing, so we still write batches that can
+    // be coalesced and flushed with few syscalls.
+    private static final int PACING_MIN_BURST_PACKETS = 10;
+    // The minimum interval over which the receive rate is measured for the QuicheQuicBdpHistory.
+    private static final long RECV_RATE_MIN_INTERVAL_NANOS = TimeUnit.MILLISECONDS.toNanos(10);
     private final LongObjectMap<QuicheQuicStreamChannel> streams = new LongObjectHashMap<>();
-    private final Queue<Long> flushPendingQueue = new ArrayDeque<>();
-    private final QuicChannelConfig config;
+    // Streams that have pending writes and wait for quiche to report them as writable.
+    private final LongObjectMap<QuicheQuicStreamChannel> flushPendingStreams = new LongObjectHashMap<>();
+    // Streams that were reported as writable and will be notified in order of their urgency.
+    private QuicheQuicStreamChannel[] writableStreams = new QuicheQuicStreamChannel[16];
+    private final DefaultQuicChannelConfig config;
     private final boolean server;
     private final QuicStreamIdGenerator idGenerator;
     private final ChannelHandler streamHandler;
     private final Map.Entry<ChannelOption<?>, Object>[] streamOptionsArray;
     private final Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray;
     private final TimeoutHandler timeoutHandler = new TimeoutHandler();
+    private final PacingHandler pacingHandler = new PacingHandler();
+    private final StreamSendIovProcessor streamSendIovProcessor = new StreamSendIovProcessor();
+    private QuicheQuicTimerWheel timerWheel;
+    private QuicheQuicReadyQueue readyQueue;
+    private final QuicheQuicReadyQueue.Entry readyEntry = new QuicheQuicReadyQueue.Entry(this);
+    private boolean datagramSupported;
+    private boolean pacing;
+    // The number of bytes we may send right now without exceeding the pacing rate.
+    private long pacingBudget;
+    private long pacingLastNanos;
+    private QuicheQuicBdpHistory bdpHistory;
+    // The highest receive rate in bytes per second that was measured over one interval.
+    private long peakRecvRate;
+    private long recvIntervalStartNanos;
+    private long recvIntervalBytes;
+    private long recvIntervalNanos = RECV_RATE_MIN_INTERVAL_NANOS;
+    private QuicheQuicCodecMetrics metrics;
+    private QuicheQuicMemoryBudget memoryBudget;
+    // The memory that is accounted to this connection in the memoryBudget.
+    private long memoryUsed;
     private final InetSocketAddress remote;
 
     private long connAddr;
     private boolean inFireChannelReadCompleteQueue;
     private boolean fireChannelReadCompletePending;
     private boolean connectionSendNeeded;
-    private ByteBuf finBuffer;
+    // Not taken from QuicheScratchBuffers as the stream ids are read while the streams are notified, which may
+    // process the readable streams of another channel on the same event loop.
+    private ByteBuf readableStreamsBuffer;
+    // Only valid while the lengths of a batch are processed in connectionSend().
+    private ByteBuf sendLengthsBuffer;
+    // Holds the datagrams of a batch in connectionSend() until these are written to the parent.
+    private DatagramPacket[] sendPackets;
+    private SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator;
     private ChannelPromise connectPromise;
     private ScheduledFuture<?> connectTimeoutFuture;
     private ByteBuffer connectId;
     private ByteBuffer key;
+    // The connection id the client chose for its first Initial. Only set for server connections that were accepted
+    // without a Retry, as these use another connection id as key.
+    private ByteBuffer originalKey;
     private CloseData closeData;
-    private QuicConnectionStats statsAtClose;
+    private MutableQuicConnectionStats statsAtClose;
+    private final long creationNanos = System.nanoTime();
+    private long handshakeDurationNanos = -1;
+    private long totalStreams;
+    // Only set for server connections that are handed off to another shard once the handshake is complete.
+    private Predicate<QuicheQuicChannel> handOff;
+    private boolean handedOff;
+    // Only used by clients to resume sessions.
+    private QuicSessionCache sessionCache;
+    private boolean qlogEnabled;
 
     private static final int CLOSED = 0;
     private static final int OPEN = 1;
@@ -138,7 +202,9 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
     private volatile String traceId;
 
     private QuicheQuicChannel(Channel parent, boolean server, ByteBuffer key, long connAddr, String traceId,
-                      InetSocketAddress remote, ChannelHandler streamHandler,
+                              InetSocketAddress remote,
+                              SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator,
+                              ChannelHandler streamHandler,
                               Map.Entry<ChannelOption<?>, Object>[] streamOptionsArray,
                               Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray) {
         super(parent);
@@ -151,6 +217,7 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
         this.remote = remote;
         this.connAddr = connAddr;
         this.traceId = traceId;
+        this.segmentedDatagramPacketAllocator = segmentedDatagramPacketAllocator;
         this.streamHandler = streamHandler;
         this.streamOptionsArray = streamOptionsArray;
         this.streamAttrsArray = streamAttrsArray;
@@ -160,20 +227,22 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
                                        Map.Entry<ChannelOption<?>, Object>[] streamOptionsArray,
                                        Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray) {
         return new QuicheQuicChannel(parent, false, null,
-                -1, null, remote, streamHandler,
+                -1, null, remote, SegmentedDatagramPacketAllocator.NONE, streamHandler,
                 streamOptionsArray, streamAttrsArray);
     }
 
     static QuicheQuicChannel forServer(Channel parent, ByteBuffer key,
                                        long connAddr, String traceId, InetSocketAddress remote,
+                                       SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator,
                                        ChannelHandler streamHandler,
                                        Map.Entry<ChannelOption<?>, Object>[] streamOptionsArray,
                                        Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray) {
         return new QuicheQuicChannel(parent, true, key, connAddr, traceId, remote,
-                streamHandler, streamOptionsArray, streamAttrsArray);
+                segmentedDatagramPacketAllocator, streamHandler, streamOptionsArray, streamAttrsArray);
     }
 
-    private void connect(long configAddr) throws Exception {
+    private void connect(long configAddr, SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator)
+            throws Exception {
         assert this.connAddr == -1;
         assert this.traceId == null;
         assert this.key == null;
@@ -193,6 +262,11 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
             }
             this.traceId = Quiche.traceId(connection, idBuffer);
             this.connAddr = connection;
+            if (sessionCache != null) {
+                resumeSession(serverName);
+            }
+            enableQLog(config.qlog());
+            this.segmentedDatagramPacketAllocator = segmentedDatagramPacketAllocator;
 
             connectionSendNeeded = true;
             key = connectId;
@@ -205,6 +279,225 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
         return key;
     }
 
+    void originalKey(ByteBuffer originalKey) {
+        this.originalKey = originalKey;
+    }
+
+    ByteBuffer originalKey() {
+        return originalKey;
+    }
+
+    /**
+     * Set the {@link QuicSessionCache} that is used to resume the session of this client connection. This must be
+     * done before the channel is connected.
+     */
+    void sessionCache(QuicSessionCache sessionCache) {
+        assert !server;
+        this.sessionCache = sessionCache;
+    }
+
+    /**
+     * Enable qlog for the connection if it is sampled by the given {@link QLogConfiguration}. This is a no-op if the
+     * connection was not created yet, in which case it is done once it is.
+     */
+    void enableQLog(QLogConfiguration qlog) {
+        if (qlog == null) {
+            return;
+        }
+        if (isRegistered() && !eventLoop().inEventLoop()) {
+            eventLoop().execute(() -> enableQLog0(qlog));
+        } else {
+            enableQLog0(qlog);
+        }
+    }
+
+    private void enableQLog0(QLogConfiguration qlog) {
+        if (qlogEnabled || isConnDestroyed() || !qlog.sample()) {
+            return;
+        }
+        String path = qlog.path() + File.separatorChar + traceId + (server ? "-server" : "-client") + ".qlog";
+        qlogEnabled = Quiche.quiche_conn_set_qlog_path(connAddr, path, qlog.logTitle(), qlog.logDescription());
+        if (!qlogEnabled) {
+            logger.debug("Unable to enable qlog for {}", this);
+        }
+    }
+
+    private void resumeSession(String serverName) {
+        byte[] session = sessionCache.getSession(serverName, remote);
+        if (session == null) {
+            return;
+        }
+        ByteBuf sessionBuffer = alloc().directBuffer(session.length).writeBytes(session);
+        try {
+            int res = Quiche.quiche_conn_set_session(connAddr, Quiche.readerMemoryAddress(sessionBuffer),
+                    sessionBuffer.readableBytes());
+            if (res < 0 && res != Quiche.QUICHE_ERR_DONE) {
+                // The session is unusable, just do a full handshake then.
+                logger.debug("Unable to resume session: {}", Quiche.errorAsString(res));
+            }
+        } finally {
+            sessionBuffer.release();
+        }
+    }
+
+    private void saveSession() {
+        ByteBuf sessionBuffer = alloc().directBuffer(MAX_SESSION_LEN);
+        try {
+            int res = Quiche.quiche_conn_session(connAddr, Quiche.memoryAddress(sessionBuffer),
+                    sessionBuffer.capacity());
+            if (res > 0) {
+                byte[] session = new byte[res];
+                sessionBuffer.getBytes(0, session);
+                sessionCache.saveSession(config().getPeerCertServerName(), remote, session);
+            }
+        } finally {
+            sessionBuffer.release();
+        }
+    }
+
+    /**
+     * Set the {@link QuicheQuicTimerWheel} that is used for the timeouts of this connection. This must be done
+     * before anything is sent.
+     */
+    void timerWheel(QuicheQuicTimerWheel timerWheel) {
+        this.timerWheel = timerWheel;
+    }
+
+    /**
+     * Set the {@link QuicheQuicReadyQueue} of the codec that handles this connection.
+     */
+    void readyQueue(QuicheQuicReadyQueue readyQueue) {
+        this.readyQueue = readyQueue;
+    }
+
+    /**
+     * Set the {@link QuicheQuicCodecMetrics} of the codec that handles this connection.
+     */
+    void metrics(QuicheQuicCodecMetrics metrics) {
+        this.metrics = metrics;
+    }
+
+    void memoryBudget(QuicheQuicMemoryBudget memoryBudget) {
+        assert this.memoryBudget == null;
+        this.memoryBudget = memoryBudget;
+        addMemory(QuicheQuicMemoryBudget.CONNECTION_COST);
+    }
+
+    /**
+     * Account memory that was allocated (positive) or released (negative) for this connection or one of its streams.
+     * Once the connection is destroyed all of its memory was released already.
+     */
+    void addMemory(long bytes) {
+        if (memoryBudget == null || isConnDestroyed()) {
+            return;
+        }
+        memoryUsed += bytes;
+        memoryBudget.add(bytes);
+    }
+
+    private boolean canOpenStream() {
+        if (memoryBudget == null || memoryBudget.canOpenStream(memoryUsed)) {
+            return true;
+        }
+        metrics.streamShed();
+        return false;
+    }
+
+    /**
+     * Set if QUIC DATAGRAM frames were enabled in the config that is used by this connection.
+     */
+    void datagramSupported(boolean datagramSupported) {
+        this.datagramSupported = datagramSupported;
+    }
+
+    /**
+     * Set if the packets of this connection should be paced instead of being sent in bursts of a full congestion
+     * window.
+     */
+    void pacing(boolean pacing) {
+        this.pacing = pacing;
+    }
+
+    /**
+     * Set the {@link QuicheQuicBdpHistory} to update with the bandwidth-delay product of this connection once it is
+     * closed, or {@code null} if flow control autotuning is disabled.
+     */
+    void bdpHistory(QuicheQuicBdpHistory bdpHistory) {
+        this.bdpHistory = bdpHistory;
+    }
+
+    /**
+     * Set the {@link Predicate} that is tested once the handshake of this server connection is complete. If it
+     * returns {@code true} the connection was taken over via {@link #detachConnection()} and this channel is closed.
+     * Until then no streams or DATAGRAMs are read from the connection, these are picked up by the channel that
+     * takes over the connection.
+     */
+    void handOff(Predicate<QuicheQuicChannel> handOff) {
+        assert server;
+        this.handOff = handOff;
+    }
+
+    /**
+     * Returns {@code true} if the connection was taken over by another channel, see
+     * {@link #handOff(Predicate)}. Everything that was not consumed by {@link #recv(ByteBuf, boolean)} belongs to
+     * the channel that took over the connection.
+     */
+    boolean isHandedOff() {
+        return handedOff;
+    }
+
+    /**
+     * Detach the underlying connection from this channel and close the channel without closing the connection.
+     * The caller takes over the ownership of the returned connection and is responsible to free it.
+     */
+    long detachConnection() {
+        assert !isConnDestroyed();
+        long addr = connAddr;
+        timeoutHandler.cancel();
+        pacingHandler.cancel();
+        connAddr = -1;
+        unsafe().close(voidPromise());
+        releaseResources();
+        return addr;
+    }
+
+    /**
+     * Activate a server connection that was taken over from another channel after its handshake completed. This
+     * must be called from the {@link EventLoop} once the channel is registered.
+     */
+    void handOffComplete(long handshakeDurationNanos) {
+        assert server && state == OPEN;
+        if (isConnDestroyed()) {
+            return;
+        }
+        state = ACTIVE;
+        this.handshakeDurationNanos = handshakeDurationNanos;
+        pipeline().fireChannelActive();
+
+        // Pick up everything that was received while the handshake was done by the other channel.
+        QuicChannelUnsafe unsafe = (QuicChannelUnsafe) unsafe();
+        unsafe.processReadableStreams();
+        if (datagramSupported) {
+            unsafe.recvDatagrams(Quic.MAX_DATAGRAM_SIZE);
+        }
+        if (fireChannelReadCompletePending) {
+            fireChannelReadCompletePending = false;
+            pipeline().fireChannelReadComplete();
+        }
+        connectionSendNeeded = true;
+        if (connectionSend()) {
+            flushParent();
+        }
+    }
+
+    long handshakeDurationNanos() {
+        return handshakeDurationNanos;
+    }
+
+    String traceId() {
+        return traceId;
+    }
+
     private boolean closeAllIfConnectionClosed() {
         if (Quiche.quiche_conn_is_closed(connAddr)) {
             forceClose();
@@ -227,23 +520,42 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
             return;
         }
         unsafe().close(voidPromise());
+        if (server && handshakeDurationNanos == -1) {
+            // The handshake never completed.
+            metrics.handshakeFinished();
+        }
         // making sure that connection statistics is avaliable
         // even after channel is closed
-        statsAtClose = collectStats0(eventLoop().newPromise());
+        statsAtClose = new MutableQuicConnectionStats();
+        collectStats0(statsAtClose);
+        if (bdpHistory != null && peakRecvRate > 0 && statsAtClose.rttNanos() > 0) {
+            bdpHistory.record(remote.getAddress(),
+                    peakRecvRate * statsAtClose.rttNanos() / TimeUnit.SECONDS.toNanos(1));
+        }
         Quiche.quiche_conn_free(connAddr);
         connAddr = -1;
+        releaseResources();
+        timeoutHandler.cancel();
+        pacingHandler.cancel();
+    }
+
+    private void releaseResources() {
         state = CLOSED;
 
         closeStreams();
-        flushPendingQueue.clear();
-
-        if (finBuffer != null) {
-            finBuffer.release();
-            finBuffer = null;
+        flushPendingStreams.clear();
+        if (readyQueue != null) {
+            readyQueue.remove(readyEntry);
         }
-        state = CLOSED;
 
-        timeoutHandler.cancel();
+        if (readableStreamsBuffer != null) {
+            readableStreamsBuffer.release();
+            readableStreamsBuffer = null;
+        }
+        if (memoryBudget != null) {
+            memoryBudget.add(-memoryUsed);
+            memoryUsed = 0;
+        }
     }
 
     @Override
@@ -253,11 +565,21 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
             protected void onUnhandledInboundMessage(ChannelHandlerContext ctx, Object msg) {
                 QuicStreamChannel channel = (QuicStreamChannel) msg;
                 Quic.setupChannel(channel, streamOptionsArray, streamAttrsArray, streamHandler, logger);
-                ctx.channel().eventLoop().register(channel);
+                registerStream((QuicheQuicStreamChannel) channel, channel.voidPromise());
             }
         };
     }
 
+    /**
+     * Register the stream on the {@link EventLoop} of this connection. As we are on the {@link EventLoop} already this
+     * is done inline, without going through {@link EventLoop#register(Channel)} which would allocate a promise for
+     * every stream.
+     */
+    private void registerStream(QuicheQuicStreamChannel streamChannel, ChannelPromise promise) {
+        assert eventLoop().inEventLoop();
+        streamChannel.unsafe().register(eventLoop(), promise);
+    }
+
     @Override
     public Future<QuicStreamChannel> createStream(QuicStreamType type, ChannelHandler handler,
                                                   Promise<QuicStreamChannel> promise) {
@@ -347,6 +669,14 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
     @Override
     protected void doClose() throws Exception {
         state = CLOSED;
+        if (isConnDestroyed()) {
+            // The connection was detached from this channel, so there is nothing to close.
+            return;
+        }
+        if (sessionCache != null && handshakeDurationNanos != -1) {
+            // The session ticket is usually received after the handshake, so store it once we are done.
+            saveSession();
+        }
 
         final boolean app;
         final int err;
@@ -371,8 +701,47 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
     }
 
     @Override
-    protected void doWrite(ChannelOutboundBuffer channelOutboundBuffer) {
-        throw new UnsupportedOperationException();
+    protected Object filterOutboundMessage(Object msg) {
+        if (msg instanceof ByteBuf) {
+            if (!datagramSupported) {
+                throw new UnsupportedOperationException("QUIC DATAGRAM frames were not enabled");
+            }
+            ByteBuf buffer = (ByteBuf) msg;
+            // We pass the memory address to quiche so we need one contiguous chunk of direct memory.
+            if (buffer.isDirect() && buffer.nioBufferCount() == 1) {
+                return buffer;
+            }
+            return newDirectBuffer(buffer);
+        }
+        throw new UnsupportedOperationException("unsupported message type: " + StringUtil.simpleClassName(msg));
+    }
+
+    @Override
+    protected void doWrite(ChannelOutboundBuffer channelOutboundBuffer) throws Exception {
+        boolean sendSomething = false;
+        try {
+            for (;;) {
+                ByteBuf buffer = (ByteBuf) channelOutboundBuffer.current();
+                if (buffer == null) {
+                    break;
+                }
+                int res = Quiche.quiche_conn_dgram_send(connectionAddressChecked(),
+                        Quiche.readerMemoryAddress(buffer), buffer.readableBytes());
+                if (res < 0) {
+                    // DATAGRAMs are unreliable anyway so we never queue these on our side. If quiche can not take
+                    // the DATAGRAM (the send queue is full or it is too large) we just drop it and fail the write.
+                    channelOutboundBuffer.remove(Quiche.newException(res));
+                } else {
+                    sendSomething = true;
+                    channelOutboundBuffer.remove();
+                }
+            }
+        } finally {
+            if (sendSomething) {
+                // As we called quiche_conn_dgram_send(...) we need to ensure we will call quiche_conn_send(...).
+                tryConnectionSend();
+            }
+        }
     }
 
     @Override
@@ -421,7 +790,10 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
     }
 
     void streamClosed(long streamId) {
-        streams.remove(streamId);
+        if (streams.remove(streamId) != null) {
+            addMemory(-QuicheQuicMemoryBudget.STREAM_COST);
+        }
+        flushPendingStreams.remove(streamId);
     }
 
     boolean isStreamLocalCreated(long streamId) {
@@ -480,63 +852,41 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
         boolean sendSomething = false;
         try {
             for (;;) {
-                Object current =  streamOutboundBuffer.current();
+                Object current = streamOutboundBuffer.current();
                 if (current == null) {
                     break;
                 }
-                final ByteBuf buffer;
-                final boolean fin;
-                if (current instanceof ByteBuf) {
-                    buffer = (ByteBuf) current;
-                    fin = false;
-                } else {
-                    QuicStreamFrame streamFrame = (QuicStreamFrame) current;
-                    buffer = streamFrame.content();
-                    fin = streamFrame.hasFin();
-                }
-                int readable = buffer.readableBytes();
-                if (readable == 0 && !fin) {
-                    // Skip empty buffers.
-                    streamOutboundBuffer.remove();
-                    continue;
-                }
+                // Collect as many of the flushed messages as possible so we can hand all of them to quiche at once.
+                streamSendIovProcessor.reset();
+                streamOutboundBuffer.forEachFlushedMessage(streamSendIovProcessor);
+                int messages = streamSendIovProcessor.messages;
+                boolean fin = streamSendIovProcessor.fin;
+                int iovCount = streamSendIovProcessor.iovCount;
 
                 final int res;
-                if (!buffer.isDirect()) {
-                    ByteBuf tmpBuffer = allocator.directBuffer(readable);
-                    try {
-                        tmpBuffer.writeBytes(buffer, buffer.readerIndex(), readable);
-                        res = streamSend(streamId, tmpBuffer, fin);
-                    } finally {
-                        tmpBuffer.release();
-                    }
-                } else if (buffer.nioBufferCount() > 1) {
-                    ByteBuffer[] nioBuffers  = buffer.nioBuffers();
-                    int lastIdx = nioBuffers.length - 1;
-                    for (int i = 0; i < lastIdx; i++) {
-                        ByteBuffer nioBuffer = nioBuffers[i];
-                        while (nioBuffer.hasRemaining()) {
-                            int localRes = streamSend(streamId, nioBuffer, false);
-                            if (Quiche.throwIfError(localRes) || localRes == 0) {
-                                // stream has no capacity left stop trying to send.
-                                return StreamSendResult.NO_SPACE;
-                            }
-                            nioBuffer.position(nioBuffer.position() + localRes);
-
-                            streamOutboundBuffer.removeBytes(localRes);
-                            sendSomething = true;
-                        }
-                    }
-                    res = streamSend(streamId, nioBuffers[lastIdx], fin);
+                if (iovCount > 0) {
+                    res = Quiche.quiche_conn_stream_send_iov(connectionAddressChecked(), streamId,
+                            Quiche.memoryAddress(streamSendIovProcessor.streamSendIovBuffer), iovCount, fin);
+                } else if (messages > 0) {
+                    // Only empty buffers, just remove these.
+                    removeStreamSendMessages(streamOutboundBuffer, messages, 0);
+                    continue;
                 } else {
-                    res = streamSend(streamId, buffer, fin);
+                    // The current message is not a direct buffer, send it on its own.
+                    messages = 1;
+                    fin = current instanceof QuicStreamFrame && ((QuicStreamFrame) current).hasFin();
+                    res = streamSendHeap(streamId, allocator, streamSendContent(current), fin);
                 }
 
-                if (Quiche.throwIfError(res) || res == 0) {
+                if (Quiche.throwIfError(res)) {
+                    // stream has no capacity left stop trying to send.
+                    return StreamSendResult.NO_SPACE;
+                }
+                if (!removeStreamSendMessages(streamOutboundBuffer, messages, res)) {
+                    sendSomething |= res > 0;
                     // stream has no capacity left stop trying to send.
                     return StreamSendResult.NO_SPACE;
                 }
-                streamOutboundBuffer.removeBytes(res);
                 sendSomething = true;
                 if (fin) {
                     return StreamSendResult.FIN;
@@ -554,6 +904,141 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
         }
     }
 
+    private static ByteBuf streamSendContent(Object msg) {
+        return msg instanceof ByteBuf ? (ByteBuf) msg : ((QuicStreamFrame) msg).content();
+    }
+
+    // Remove all messages that were completely written and update the progress of the message that was partially
+    // written (if any). Returns true if all messages were completely written.
+    private static boolean removeStreamSendMessages(ChannelOutboundBuffer streamOutboundBuffer,
+                                                    int messages, int written) {
+        for (int i = 0; i < messages; i++) {
+            ByteBuf buffer = streamSendContent(streamOutboundBuffer.current());
+            int readable = buffer.readableBytes();
+            if (written < readable) {
+                if (written > 0) {
+                    buffer.skipBytes(written);
+                    streamOutboundBuffer.progress(written);
+                }
+                return false;
+            }
+            written -= readable;
+            streamOutboundBuffer.remove();
+        }
+        return true;
+    }
+
+    private int streamSendHeap(long streamId, ByteBufAllocator allocator, ByteBuf buffer, boolean fin)
+            throws Exception {
+        int readable = buffer.readableBytes();
+        if (buffer.hasArray()) {
+            int res = Quiche.quiche_conn_stream_send_array(connectionAddressChecked(), streamId, buffer.array(),
+                    buffer.arrayOffset() + buffer.readerIndex(), readable, fin);
+            if (res == Quiche.NETTY_QUIC_ERR_OUT_OF_MEMORY) {
+                throw new OutOfMemoryError("Unable to access the array of the buffer");
+            }
+            return res;
+        }
+        ByteBuf tmpBuffer = allocator.directBuffer(readable);
+        try {
+            tmpBuffer.writeBytes(buffer, buffer.readerIndex(), readable);
+            return streamSend(streamId, tmpBuffer, fin);
+        } finally {
+            tmpBuffer.release();
+        }
+    }
+
+    /**
+     * Collects the memory regions of the flushed messages into the iov buffer that is used by
+     * {@link Quiche#quiche_conn_stream_send_iov(long, long, long, int, boolean)}. Stops at the first message that
+     * is not backed by direct memory, after a message with FIN or once the iov buffer is full.
+     */
+    private static final class StreamSendIovProcessor implements ChannelOutboundBuffer.MessageProcessor {
+        ByteBuf streamSendIovBuffer;
+        int messages;
+        int iovCount;
+        boolean fin;
+
+        void reset() {
+            messages = 0;
+            iovCount = 0;
+            fin = false;
+            // Take the buffer again for each batch, as completing the writes of the previous batch may have
+            // triggered writes on other streams that use the same scratch buffer.
+            streamSendIovBuffer = QuicheScratchBuffers.get().streamSendIov(
+                    MAX_STREAM_SEND_IOV * Quiche.STREAM_SEND_IOV_ENTRY_SIZE);
+        }
+
+        @Override
+        public boolean processMessage(Object msg) {
+            ByteBuf buffer = streamSendContent(msg);
+            boolean fin = msg instanceof QuicStreamFrame && ((QuicStreamFrame) msg).hasFin();
+            int iovCountBefore = iovCount;
+            if (!addIov(buffer, fin)) {
+                // Rollback, this message will be handled by the next call.
+                iovCount = iovCountBefore;
+                return false;
+            }
+            messages++;
+            if (fin) {
+                this.fin = true;
+                return false;
+            }
+            return true;
+        }
+
+        private boolean addIov(ByteBuf buffer, boolean fin) {
+            int readable = buffer.readableBytes();
+            if (readable == 0) {
+                // Empty buffers only need to be passed to quiche if these carry the FIN.
+                return !fin || addIov(Quiche.memoryAddress(streamSendIovBuffer), 0);
+            }
+            if (!buffer.isDirect()) {
+                return false;
+            }
+            if (buffer instanceof CompositeByteBuf) {
+                // Iterate the components directly, which is cheaper than using nioBuffers().
+                CompositeByteBuf composite = (CompositeByteBuf) buffer;
+                int index = composite.readerIndex();
+                int end = composite.writerIndex();
+                for (int i = composite.toComponentIndex(index); index < end; i++) {
+                    ByteBuf component = composite.internalComponent(i);
+                    int offset = index - composite.toByteIndex(i);
+                    int length = Math.min(component.readableBytes() - offset, end - index);
+                    if (length > 0) {
+                        if (!component.isDirect() || component.nioBufferCount() != 1 ||
+                                !addIov(Quiche.readerMemoryAddress(component) + offset, length)) {
+                            return false;
+                        }
+                        index += length;
+                    }
+                }
+                return true;
+            }
+            if (buffer.nioBufferCount() == 1) {
+                return addIov(Quiche.readerMemoryAddress(buffer), readable);
+            }
+            for (ByteBuffer nioBuffer: buffer.nioBuffers(buffer.readerIndex(), readable)) {
+                if (nioBuffer.hasRemaining() &&
+                        !addIov(Quiche.memoryAddress(nioBuffer) + nioBuffer.position(), nioBuffer.remaining())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        private boolean addIov(long address, int length) {
+            if (iovCount == MAX_STREAM_SEND_IOV) {
+                return false;
+            }
+            int offset = iovCount * Quiche.STREAM_SEND_IOV_ENTRY_SIZE;
+            streamSendIovBuffer.setLong(offset, address);
+            streamSendIovBuffer.setLong(offset + Long.BYTES, length);
+            iovCount++;
+            return true;
+        }
+    }
+
     void streamClose(long streamId) throws Exception {
         try {
             // Just write an empty buffer and set fin to true.
@@ -572,15 +1057,8 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
                 Quiche.memoryAddress(buffer) + buffer.readerIndex(), buffer.readableBytes(), fin);
     }
 
-    private int streamSend(long streamId, ByteBuffer buffer, boolean fin) throws Exception {
-        return Quiche.quiche_conn_stream_send(connectionAddressChecked(), streamId,
-                Quiche.memoryAddress(buffer) + buffer.position(), buffer.remaining(), fin);
-    }
-
     StreamRecvResult streamRecv(long streamId, ByteBuf buffer) throws Exception {
-        if (finBuffer == null) {
-            finBuffer = alloc().directBuffer(1);
-        }
+        ByteBuf finBuffer = QuicheScratchBuffers.get().fin();
         int writerIndex = buffer.writerIndex();
         long memoryAddress = Quiche.memoryAddress(buffer);
         int recvLen = Quiche.quiche_conn_stream_recv(connectionAddressChecked(), streamId,
@@ -610,54 +1088,117 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
     }
 
     /**
-     * Receive some data on a QUIC connection.
+     * Pass the QUIC packet to the connection. If {@code notifyReadable} is {@code true} all streams that became
+     * readable are notified as well, which should be done for the last packet of a burst that belongs to this
+     * connection.
+     */
+    void recv(ByteBuf buffer, boolean notifyReadable) {
+        ((QuicChannelUnsafe) unsafe()).connectionRecv(buffer, notifyReadable);
+    }
+
+    /**
+     * Called once the parent {@link Channel} became writable again. Flush the streams that have pending writes and
+     * send at most {@code maxBatches} batches of datagrams. If there is more to send the connection will add itself
+     * to the {@link QuicheQuicReadyQueue} again.
+     */
+    boolean writable(int maxBatches) {
+        handleWritableStreams();
+        return connectionSend(maxBatches);
+    }
+
+    void streamHasPendingWrites(QuicheQuicStreamChannel channel) {
+        flushPendingStreams.put(channel.streamId(), channel);
+        markReady();
+    }
+
+    /**
+     * Called once the stream can not make progress anymore, as quiche will never report it as writable again.
      */
-    void recv(ByteBuf buffer) {
-        ((QuicChannelUnsafe) unsafe()).connectionRecv(buffer);
+    void streamHasNoPendingWrites(long streamId) {
+        flushPendingStreams.remove(streamId);
     }
 
-    boolean writable() {
-        if (handleWritableStreams()) {
-            return connectionSend();
+    private void markReady() {
+        if (readyQueue != null && !isConnDestroyed()) {
+            readyQueue.add(readyEntry);
         }
-        return false;
     }
 
-    void streamHasPendingWrites(long streamId) {
-        flushPendingQueue.add(streamId);
+    void streamPriority(long streamId, QuicStreamPriority priority) throws Exception {
+        Quiche.throwIfError(Quiche.quiche_conn_stream_priority(connectionAddressChecked(), streamId,
+                (byte) priority.urgency(), priority.isIncremental()));
     }
 
     private boolean handleWritableStreams() {
-        int pending = flushPendingQueue.size();
-        if (isConnDestroyed() || pending == 0) {
+        if (isConnDestroyed() || flushPendingStreams.isEmpty()) {
+            return false;
+        }
+        if (!Quiche.quiche_conn_is_established(connAddr) &&
+                !Quiche.quiche_conn_is_in_early_data(connAddr)) {
             return false;
         }
 
-        boolean mayNeedWrite = false;
-        if (Quiche.quiche_conn_is_established(connAddr) ||
-                Quiche.quiche_conn_is_in_early_data(connAddr)) {
-            // We only want to process the number of channels that were in the queue when we entered
-            // handleWritableStreams(). Otherwise we may would loop forever as a channel may add itself again
-            // if the write was again partial.
-            for (int i = 0; i < pending; i++) {
-                Long streamId = flushPendingQueue.poll();
-                if (streamId == null) {
-                    break;
-                    // Checking quiche_conn_stream_capacity(...) is cheaper then calling channel.writable() just
-                    // to notice that we can not write again.
-                } else if (Quiche.quiche_conn_stream_capacity(connAddr, streamId) <= 0) {
-                    // Still not writable, put back in the queue.
-                   flushPendingQueue.add(streamId);
-                } else {
-                    QuicheQuicStreamChannel channel = streams.get(streamId.longValue());
-                    if (channel != null) {
-                        mayNeedWrite = true;
-                        channel.writable();
+        int writable = collectWritableStreams();
+        // Notify the streams in order of their urgency so the more important streams get the chance to fill the
+        // capacity of the connection first.
+        int remaining = writable;
+        for (int urgencyIndex = 0; remaining > 0; urgencyIndex++) {
+            for (int i = 0; i < writable; i++) {
+                QuicheQuicStreamChannel channel = writableStreams[i];
+                if (channel != null && channel.urgencyIndex() <= urgencyIndex) {
+                    writableStreams[i] = null;
+                    remaining--;
+                    // This may add the stream again to flushPendingStreams if the write was partial.
+                    channel.writable();
+                }
+            }
+        }
+        return writable > 0;
+    }
+
+    /**
+     * Use the writable streams iterator of quiche to find the streams that have pending writes and can make progress.
+     * This way we only need to touch the streams that quiche reports as writable and not all of the streams that
+     * have pending writes.
+     */
+    private int collectWritableStreams() {
+        long writableIterator = Quiche.quiche_conn_writable(connAddr);
+        if (writableIterator == -1) {
+            return 0;
+        }
+        ByteBuf writableStreamsBuffer = QuicheScratchBuffers.get().writableStreams(
+                MAX_WRITABLE_STREAMS * Long.BYTES);
+        long streamIdsAddress = Quiche.memoryAddress(writableStreamsBuffer);
+        int writable = 0;
+        try {
+            for (;;) {
+                int streams = Quiche.quiche_stream_iter_next(
+                        writableIterator, streamIdsAddress, MAX_WRITABLE_STREAMS);
+                for (int i = 0; i < streams; i++) {
+                    long streamId = writableStreamsBuffer.getLong(i * Long.BYTES);
+                    QuicheQuicStreamChannel channel = flushPendingStreams.get(streamId);
+                    if (channel == null) {
+                        continue;
+                    }
+                    // quiche only takes the stream level flow control into account for the iterator, so check the
+                    // capacity which also includes the connection level flow control.
+                    if (Quiche.quiche_conn_stream_capacity(connAddr, streamId) <= 0) {
+                        // The connection level flow control is exhausted, no other stream can make progress either.
+                        return writable;
                     }
+                    flushPendingStreams.remove(streamId);
+                    if (writable == writableStreams.length) {
+                        writableStreams = Arrays.copyOf(writableStreams, writable << 1);
+                    }
+                    writableStreams[writable++] = channel;
+                }
+                if (streams < MAX_WRITABLE_STREAMS) {
+                    return writable;
                 }
             }
+        } finally {
+            Quiche.quiche_stream_iter_free(writableIterator);
         }
-        return mayNeedWrite;
     }
 
     /**
@@ -697,11 +1238,16 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
      * {@link Channel#flush()} at some point.
      */
     private boolean connectionSend() {
+        return connectionSend(Integer.MAX_VALUE);
+    }
+
+    private boolean connectionSend(int maxBatches) {
         if (isConnDestroyed() || !connectionSendNeeded) {
             return false;
         }
         connectionSendNeeded = false;
-        ChannelFuture lastFuture = null;
+        boolean written = false;
+        int batches = 0;
 
         // Use the datagram size that was advertised by the remote peer, or if none was fallback to some safe default.
         int len = Quiche.quiche_conn_dgram_max_writable_len(connAddr);
@@ -709,42 +1255,187 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
             len = Quic.MAX_DATAGRAM_SIZE;
         }
 
+        // If UDP_SEGMENT is supported we let quiche produce at least as many packets per batch as we can coalesce
+        // into one datagram.
+        int maxSegments = segmentedDatagramPacketAllocator.maxNumSegments();
+        int batchSize = Math.max(MAX_SEND_BATCH, maxSegments);
         for (;;) {
-            ByteBuf out = alloc().directBuffer(len);
-            int writerIndex = out.writerIndex();
-            int written = Quiche.quiche_conn_send(
-                    connAddr, Quiche.memoryAddress(out) + writerIndex, out.writableBytes());
+            // Take the buffers again for each batch as writing the packets of the previous one may have triggered a
+            // send on another channel that uses the same scratch buffers.
+            QuicheScratchBuffers scratchBuffers = QuicheScratchBuffers.get();
+            sendLengthsBuffer = scratchBuffers.sendLengths(batchSize * Integer.BYTES);
+            long lengthsAddress = Quiche.memoryAddress(sendLengthsBuffer);
+
+            int maxPackets = batchSize;
+            if (pacing) {
+                maxPackets = pacedPackets(len, batchSize);
+                if (maxPackets == 0) {
+                    // We are sending faster than the pacing rate, the PacingHandler will continue once there is
+                    // enough budget again.
+                    connectionSendNeeded = true;
+                    break;
+                }
+            }
+
+            // Let quiche fill multiple packets into one scratch buffer, copy the produced bytes into one pooled
+            // buffer of exactly that size and write slices of it. This way we need one JNI call and one allocation per
+            // batch, and the datagrams do not keep more memory alive than they actually use.
+            ByteBuf out = scratchBuffers.send(len * maxPackets);
+            int packets = Quiche.quiche_conn_send_batch(connAddr, Quiche.memoryAddress(out),
+                    out.capacity(), len, lengthsAddress, maxPackets);
 
             try {
-                if (Quiche.throwIfError(written)) {
-                    out.release();
+                if (Quiche.throwIfError(packets)) {
                     break;
                 }
             } catch (Exception e) {
-                out.release();
                 pipeline().fireExceptionCaught(e);
                 break;
             }
 
-            if (written == 0) {
-                // No need to create a new datagram packet. Just release and try again.
-                out.release();
-                continue;
+            if (sendPackets == null || sendPackets.length < batchSize) {
+                sendPackets = new DatagramPacket[batchSize];
+            }
+            // Copy all datagrams out of the scratch buffers before writing any of them, as a write may trigger a send
+            // on another channel that uses the same scratch buffers.
+            int bytes = 0;
+            for (int j = 0; j < packets; j++) {
+                bytes += packetLength(j);
+            }
+            ByteBuf batch = alloc().directBuffer(bytes).writeBytes(out, 0, bytes);
+            int datagrams = 0;
+            int offset = 0;
+            int i = 0;
+            while (i < packets) {
+                int segmentSize = packetLength(i);
+                int segments = 1;
+                int packetLen = segmentSize;
+                if (maxSegments > 1) {
+                    // Coalesce all following packets of the same size. The last segment is allowed to be smaller.
+                    while (i + segments < packets && segments < maxSegments) {
+                        int nextLen = packetLength(i + segments);
+                        if (nextLen > segmentSize) {
+                            break;
+                        }
+                        packetLen += nextLen;
+                        segments++;
+                        if (nextLen < segmentSize) {
+                            break;
+                        }
+                    }
+                }
+                ByteBuf content = batch.retainedSlice(offset, packetLen);
+                if (segments > 1) {
+                    sendPackets[datagrams++] = segmentedDatagramPacketAllocator.newPacket(
+                            content, segmentSize, remote);
+                } else {
+                    sendPackets[datagrams++] = new DatagramPacket(content, remote);
+                }
+                offset += packetLen;
+                i += segments;
+            }
+            batch.release();
+            for (int j = 0; j < datagrams; j++) {
+                DatagramPacket packet = sendPackets[j];
+                sendPackets[j] = null;
+                parent().write(packet);
+                written = true;
+            }
+            if (metrics != null) {
+                metrics.packetsWritten(packets, offset);
+            }
+            if (pacing) {
+                pacingBudget -= offset;
+            }
+
+            if (packets < maxPackets) {
+                // Nothing more to send for now.
+                break;
+            }
+            if (++batches == maxBatches || !parent().isWritable()) {
+                // Stop writing more into the parent and continue once the codec resumes this connection. This
+                // way a single connection can't buffer unlimited data in the parent or starve the others.
+                connectionSendNeeded = true;
+                markReady();
+                break;
             }
-            out.writerIndex(writerIndex + written);
-            lastFuture = parent().write(new DatagramPacket(out, remote));
         }
-        if (lastFuture != null) {
-            lastFuture.addListener(timeoutHandler);
+        if (written) {
+            // The timeout may have changed as we sent something.
+            timeoutHandler.scheduleTimeout();
             return true;
         }
         return false;
     }
 
+    /**
+     * Returns how many packets of at most {@code maxPacketLen} bytes can be sent now without exceeding the pacing
+     * rate, up to {@code maxPackets}. If this is {@code 0} the {@link PacingHandler} was scheduled to continue sending
+     * once there is enough budget.
+     *
+     * quiche does not provide a pacing rate itself, so we derive it from the congestion window and the smoothed rtt
+     * and refill a token bucket from it. As the {@link QuicheQuicTimerWheel} can not wake us up more often than once
+     * per tick the bucket holds at least the bytes of one tick, which bounds the size of the bursts.
+     */
+    private int pacedPackets(int maxPacketLen, int maxPackets) {
+        ByteBuf stats = QuicheScratchBuffers.get().stats();
+        Quiche.quiche_conn_stats(connAddr, Quiche.memoryAddress(stats));
+        long rttNanos = stats.getLong(Quiche.QUICHE_STATS_RTT_OFFSET);
+        long cwnd = stats.getLong(Quiche.QUICHE_STATS_CWND_OFFSET);
+        // quiche reports its initial rtt until there is a real sample, which is taken during the handshake already.
+        double bytesPerNano = PACING_GAIN * cwnd / Math.max(1, rttNanos);
+        long maxBudget = Math.max((long) PACING_MIN_BURST_PACKETS * maxPacketLen,
+                (long) (bytesPerNano * QuicheQuicTimerWheel.TICK_NANOS));
+        long now = System.nanoTime();
+        if (pacingLastNanos == 0) {
+            pacingBudget = maxBudget;
+        } else {
+            pacingBudget = Math.min(maxBudget, pacingBudget + (long) ((now - pacingLastNanos) * bytesPerNano));
+        }
+        pacingLastNanos = now;
+
+        int packets = (int) Math.min(maxPackets, pacingBudget / maxPacketLen);
+        if (packets == 0) {
+            pacingHandler.schedule((long) ((maxPacketLen - pacingBudget) / bytesPerNano));
+        }
+        return packets;
+    }
+
+    /**
+     * Update the peak receive rate. The rate is measured over at least one rtt, as a peer that is limited by our
+     * flow control windows sends in bursts of one window per rtt.
+     */
+    private void updateRecvRate(int bytes) {
+        long now = System.nanoTime();
+        if (recvIntervalStartNanos == 0) {
+            recvIntervalStartNanos = now;
+        }
+        recvIntervalBytes += bytes;
+        long elapsed = now - recvIntervalStartNanos;
+        if (elapsed >= recvIntervalNanos) {
+            peakRecvRate = Math.max(peakRecvRate, recvIntervalBytes * TimeUnit.SECONDS.toNanos(1) / elapsed);
+            recvIntervalStartNanos = now;
+            recvIntervalBytes = 0;
+
+            ByteBuf stats = QuicheScratchBuffers.get().stats();
+            Quiche.quiche_conn_stats(connAddr, Quiche.memoryAddress(stats));
+            recvIntervalNanos = Math.max(RECV_RATE_MIN_INTERVAL_NANOS,
+                    stats.getLong(Quiche.QUICHE_STATS_RTT_OFFSET));
+        }
+    }
+
+    private int packetLength(int idx) {
+        return sendLengthsBuffer.getInt(idx * Integer.BYTES);
+    }
+
     private final class QuicChannelUnsafe extends AbstractChannel.AbstractUnsafe {
 
         void connectStream(QuicStreamType type, ChannelHandler handler,
                            Promise<QuicStreamChannel> promise) {
+            if (!canOpenStream()) {
+                promise.setFailure(new ChannelException("Memory budget of the connection exhausted"));
+                return;
+            }
             long streamId = idGenerator.nextStreamId(type == QuicStreamType.BIDIRECTIONAL);
             try {
                 Quiche.throwIfError(streamSend(streamId, Unpooled.EMPTY_BUFFER, false));
@@ -756,14 +1447,16 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
             if (handler != null) {
                 streamChannel.pipeline().addLast(handler);
             }
-            eventLoop().register(streamChannel).addListener((ChannelFuture f) -> {
-                if (f.isSuccess()) {
-                    promise.setSuccess(streamChannel);
-                } else {
-                    promise.setFailure(f.cause());
-                    streams.remove(streamId);
-                }
-            });
+            ChannelPromise registerPromise = streamChannel.newPromise();
+            registerStream(streamChannel, registerPromise);
+            // Registration is done inline, so the promise is complete already.
+            assert registerPromise.isDone();
+            if (registerPromise.isSuccess()) {
+                promise.setSuccess(streamChannel);
+            } else {
+                promise.setFailure(registerPromise.cause());
+                streamClosed(streamId);
+            }
         }
 
         @Override
@@ -820,30 +1513,45 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
             channelPromise.setFailure(new UnsupportedOperationException());
         }
 
-        void connectionRecv(ByteBuf buffer) {
+        void connectionRecv(ByteBuf buffer, boolean notifyReadable) {
             if (isConnDestroyed()) {
                 return;
             }
 
             ByteBuf tmpBuffer = null;
+            ByteBuf recvBuffer = buffer;
             // We need to make a copy if the buffer is read only as recv(...) may modify the input buffer as well.
             // See https://docs.rs/quiche/0.6.0/quiche/struct.Connection.html#method.recv
             if (buffer.isReadOnly()) {
                 tmpBuffer = alloc().directBuffer(buffer.readableBytes());
-                tmpBuffer.writeBytes(buffer);
-                buffer = tmpBuffer;
+                tmpBuffer.writeBytes(buffer, buffer.readerIndex(), buffer.readableBytes());
+                recvBuffer = tmpBuffer;
+            }
+            int bufferReadable = recvBuffer.readableBytes();
+            int packetLength = bufferReadable;
+            if (bdpHistory != null) {
+                updateRecvRate(packetLength);
+            }
+            long startAddress = Quiche.memoryAddress(recvBuffer) + recvBuffer.readerIndex();
+            long memoryAddress = startAddress;
+
+            long streamIdsAddress = 0;
+            int maxStreamIds = 0;
+            if (notifyReadable && handOff == null) {
+                streamIdsAddress = readableStreamsAddress();
+                maxStreamIds = MAX_READABLE_STREAMS;
             }
-            int bufferReadable = buffer.readableBytes();
-            int bufferReaderIndex = buffer.readerIndex();
-            long memoryAddress = Quiche.memoryAddress(buffer) + bufferReaderIndex;
 
             // We need to call quiche_conn_send(...),
             // see https://docs.rs/quiche/0.6.0/quiche/struct.Connection.html#method.send
             connectionSendNeeded = true;
             try {
                 do  {
-                    // Call quiche_conn_recv(...) until we consumed all bytes or we did receive some error.
-                    int res = Quiche.quiche_conn_recv(connAddr, memoryAddress, bufferReadable);
+                    // Call quiche_conn_recv(...) until we consumed all bytes or we did receive some error. This also
+                    // gives us the state of the connection and the readable streams without extra JNI calls.
+                    long status = Quiche.quiche_conn_recv_and_poll(
+                            connAddr, memoryAddress, bufferReadable, streamIdsAddress, maxStreamIds);
+                    int res = Quiche.recvAndPollResult(status);
                     boolean done;
                     try {
                         done = Quiche.throwIfError(res);
@@ -853,84 +1561,174 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
                     }
 
                     // Handle pending channelActive if needed.
-                    if (handlePendingChannelActive()) {
+                    if (handlePendingChannelActive((status & Quiche.RECV_AND_POLL_ESTABLISHED) != 0)) {
                         // Connection was closed right away.
+                        if (handedOff && res > 0) {
+                            // The rest of the buffer is left for the channel that took over the connection.
+                            memoryAddress += res;
+                        }
                         return;
                     }
 
-                    if (Quiche.quiche_conn_is_established(connAddr) || Quiche.quiche_conn_is_in_early_data(connAddr)) {
-                        long readableIterator = Quiche.quiche_conn_readable(connAddr);
-                        if (readableIterator != -1) {
-                            try {
-                                for (;;) {
-                                    int readable = Quiche.quiche_stream_iter_next(readableIterator, readableStreams);
-                                    for (int i = 0; i < readable; i++) {
-                                        long streamId = readableStreams[i];
-                                        QuicheQuicStreamChannel streamChannel = streams.get(streamId);
-                                        if (streamChannel == null) {
-                                            // We create a new channel and fire it through the pipeline which
-                                            // means we also need to ensure we call fireChannelReadCompletePending.
-                                            fireChannelReadCompletePending = true;
-                                            streamChannel = addNewStreamChannel(streamId);
-                                            streamChannel.readable();
-                                            pipeline().fireChannelRead(streamChannel);
-                                        } else {
-                                            streamChannel.readable();
-                                        }
-                                    }
-                                    if (readable < readableStreams.length) {
-                                        break;
-                                    }
-                                }
-                            } finally {
-                                Quiche.quiche_stream_iter_free(readableIterator);
-                            }
+                    if ((status & Quiche.RECV_AND_POLL_TRUNCATED) != 0) {
+                        // There are more readable streams then we could fit in the buffer, use the iterator.
+                        processReadableStreams();
+                    } else {
+                        int readable = Quiche.recvAndPollStreams(status);
+                        for (int i = 0; i < readable; i++) {
+                            streamReadable(readableStreamsBuffer.getLong(i * Long.BYTES));
                         }
                     }
 
-                    if (done) {
+                    if (done || (status & Quiche.RECV_AND_POLL_CLOSED) != 0) {
                         break;
                     } else {
                         memoryAddress += res;
                         bufferReadable -= res;
                     }
                 } while (bufferReadable > 0);
+
+                if (datagramSupported && handOff == null) {
+                    // A DATAGRAM can never be larger then the packet it was received in.
+                    recvDatagrams(packetLength);
+                }
             } finally {
-                buffer.skipBytes((int) (memoryAddress - Quiche.memoryAddress(buffer)));
+                buffer.skipBytes((int) (memoryAddress - startAddress));
                 if (tmpBuffer != null) {
                     tmpBuffer.release();
                 }
             }
         }
 
-        private boolean handlePendingChannelActive() {
+        private void recvDatagrams(int maxLength) {
+            while (!isConnDestroyed()) {
+                // Receive into a scratch buffer first, so we only allocate for datagrams that were actually queued and
+                // only as much as these need. Take it again for each datagram as the previous one may have triggered
+                // a receive on another channel that uses the same scratch buffer.
+                ByteBuf scratch = QuicheScratchBuffers.get().datagram(maxLength);
+                int res = Quiche.quiche_conn_dgram_recv(connAddr, Quiche.memoryAddress(scratch), maxLength);
+                if (res < 0) {
+                    if (res != Quiche.QUICHE_ERR_DONE) {
+                        pipeline().fireExceptionCaught(Quiche.newException(res));
+                    }
+                    return;
+                }
+                ByteBuf datagram = alloc().directBuffer(res).writeBytes(scratch, 0, res);
+                fireChannelReadCompletePending = true;
+                pipeline().fireChannelRead(datagram);
+            }
+        }
+
+        private long readableStreamsAddress() {
+            if (readableStreamsBuffer == null) {
+                readableStreamsBuffer = QuicheQuicCodec.allocateNativeOrder(MAX_READABLE_STREAMS * Long.BYTES);
+            }
+            return Quiche.memoryAddress(readableStreamsBuffer);
+        }
+
+        private void processReadableStreams() {
+            long readableIterator = Quiche.quiche_conn_readable(connAddr);
+            if (readableIterator != -1) {
+                long streamIdsAddress = readableStreamsAddress();
+                try {
+                    for (;;) {
+                        int readable = Quiche.quiche_stream_iter_next(
+                                readableIterator, streamIdsAddress, MAX_READABLE_STREAMS);
+                        for (int i = 0; i < readable; i++) {
+                            streamReadable(readableStreamsBuffer.getLong(i * Long.BYTES));
+                        }
+                        if (readable < MAX_READABLE_STREAMS) {
+                            break;
+                        }
+                    }
+                } finally {
+                    Quiche.quiche_stream_iter_free(readableIterator);
+                }
+            }
+        }
+
+        private void streamReadable(long streamId) {
+            QuicheQuicStreamChannel streamChannel = streams.get(streamId);
+            if (streamChannel == null) {
+                if (!canOpenStream()) {
+                    rejectStream(streamId);
+                    return;
+                }
+                // We create a new channel and fire it through the pipeline which
+                // means we also need to ensure we call fireChannelReadCompletePending.
+                fireChannelReadCompletePending = true;
+                streamChannel = addNewStreamChannel(streamId);
+                streamChannel.readable();
+                pipeline().fireChannelRead(streamChannel);
+            } else {
+                streamChannel.readable();
+            }
+        }
+
+        private boolean handlePendingChannelActive(boolean established) {
             if (server) {
-                if (state == OPEN && Quiche.quiche_conn_is_established(connAddr)) {
+                if (state == OPEN && established) {
+                    handshakeDurationNanos = System.nanoTime() - creationNanos;
+                    metrics.handshakeFinished();
+                    Predicate<QuicheQuicChannel> handOff = QuicheQuicChannel.this.handOff;
+                    if (handOff != null) {
+                        QuicheQuicChannel.this.handOff = null;
+                        if (handOff.test(QuicheQuicChannel.this)) {
+                            // The connection is owned by another channel now.
+                            handedOff = true;
+                            return true;
+                        }
+                    }
                     // We didnt notify before about channelActive... Update state and fire the event.
                     state = ACTIVE;
                     pipeline().fireChannelActive();
+                    if (handOff != null) {
+                        // Nobody took over the connection, pick up the streams that we did not read so far.
+                        processReadableStreams();
+                    }
                 }
-            } else if (connectPromise != null && Quiche.quiche_conn_is_established(connAddr)) {
-                ChannelPromise promise = connectPromise;
-                connectPromise = null;
-                state = ACTIVE;
-                boolean promiseSet = promise.trySuccess();
-                pipeline().fireChannelActive();
-                if (!promiseSet) {
-                    this.close(this.voidPromise());
-                    return true;
+            } else if (established && handshakeDurationNanos == -1) {
+                handshakeDurationNanos = System.nanoTime() - creationNanos;
+                if (connectPromise != null) {
+                    return completeConnect();
                 }
             }
             return false;
         }
 
+        // Returns true if the channel was closed because the connect was cancelled.
+        boolean completeConnect() {
+            ChannelPromise promise = connectPromise;
+            connectPromise = null;
+            state = ACTIVE;
+            boolean promiseSet = promise.trySuccess();
+            pipeline().fireChannelActive();
+            if (!promiseSet) {
+                this.close(this.voidPromise());
+                return true;
+            }
+            return false;
+        }
+
         private QuicheQuicStreamChannel addNewStreamChannel(long streamId) {
             QuicheQuicStreamChannel streamChannel = new QuicheQuicStreamChannel(
                     QuicheQuicChannel.this, streamId);
             QuicheQuicStreamChannel old = streams.put(streamId, streamChannel);
             assert old == null;
+            totalStreams++;
+            addMemory(QuicheQuicMemoryBudget.STREAM_COST);
             return streamChannel;
         }
+
+        // Refuse a stream that was opened by the remote peer, quiche discards the data it buffered for it and
+        // tells the peer to stop sending.
+        private void rejectStream(long streamId) {
+            Quiche.quiche_conn_stream_shutdown(connAddr, streamId, Quiche.QUICHE_SHUTDOWN_READ, 0);
+            if (streamType(streamId) == QuicStreamType.BIDIRECTIONAL) {
+                Quiche.quiche_conn_stream_shutdown(connAddr, streamId, Quiche.QUICHE_SHUTDOWN_WRITE, 0);
+            }
+            connectionSendNeeded = true;
+        }
     }
 
     /**
@@ -941,19 +1739,37 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
         if (connectionSend()) {
             flushParent();
         }
+        if (!isConnDestroyed() && Quiche.quiche_conn_is_in_early_data(connAddr)) {
+            // The session was resumed, so we can send stream data as 0-RTT early data until the handshake is done.
+            ((QuicChannelUnsafe) unsafe()).completeConnect();
+        }
     }
 
     // TODO: Come up with something better.
-    static QuicheQuicChannel handleConnect(SocketAddress address, long config) throws Exception {
+    static QuicheQuicChannel handleConnect(SocketAddress address, long config,
+                                           SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator)
+            throws Exception {
         if (address instanceof QuicheQuicChannel.QuicheQuicChannelAddress) {
             QuicheQuicChannel.QuicheQuicChannelAddress addr = (QuicheQuicChannel.QuicheQuicChannelAddress) address;
             QuicheQuicChannel channel = addr.channel;
-            channel.connect(config);
+            channel.connect(config, segmentedDatagramPacketAllocator);
             return channel;
         }
         return null;
     }
 
+    /**
+     * Returns the remote address of the {@link QuicheQuicChannel} that is connected via
+     * {@link #handleConnect(SocketAddress, long, SegmentedDatagramPacketAllocator)}, or {@code null} if the given
+     * address does not belong to one.
+     */
+    static InetSocketAddress connectRemoteAddress(SocketAddress address) {
+        if (address instanceof QuicheQuicChannel.QuicheQuicChannelAddress) {
+            return ((QuicheQuicChannel.QuicheQuicChannelAddress) address).channel.remote;
+        }
+        return null;
+    }
+
     /**
      * Just a container to pass the {@link QuicheQuicChannel} to {@link QuicheQuicClientCodec}.
      */
@@ -966,89 +1782,106 @@ final class QuicheQuicChannel extends AbstractChannel implements QuicChannel {
         }
     }
 
-    private final class TimeoutHandler implements ChannelFutureListener, Runnable {
-        private Future<?> timeoutFuture;
-
-        @Override
-        public void operationComplete(ChannelFuture future) {
-            if (future.isSuccess()) {
-                // Schedule timeout.
-                // See https://docs.rs/quiche/0.6.0/quiche/#generating-outgoing-packets
-                timeoutFuture = null;
-                scheduleTimeout();
-            }
-        }
+    private final class TimeoutHandler extends QuicheQuicTimerWheel.Timeout {
 
         @Override
-        public void run() {
+        protected void expire() {
             if (!isConnDestroyed()) {
                 // Notify quiche there was a timeout.
                 Quiche.quiche_conn_on_timeout(connAddr);
 
                 if (Quiche.quiche_conn_is_closed(connAddr)) {
-                    timeoutFuture = null;
                     forceClose();
                 } else {
                     // We need to set connectionSendNeeded to true as we always need to call this method when
-                    // a timeout was triggered.
+                    // a timeout was triggered. If something was sent this will also reschedule the timeout.
                     // See https://docs.rs/quiche/0.6.0/quiche/struct.Connection.html#method.send.
                     connectionSendNeeded = true;
                     boolean send = connectionSend();
                     if (send) {
                         flushParent();
                     }
-                    if (!closeAllIfConnectionClosed() && send) {
-                        // The connection is alive, reschedule.
-                        timeoutFuture = null;
-                        scheduleTimeout();
-                    }
+                    closeAllIfConnectionClosed();
                 }
             }
         }
 
-        private void scheduleTimeout() {
-            cancel();
+        void scheduleTimeout() {
             if (isConnDestroyed()) {
+                cancel();
                 return;
             }
+            // See https://docs.rs/quiche/0.6.0/quiche/#generating-outgoing-packets
             long nanos = Quiche.quiche_conn_timeout_as_nanos(connAddr);
-            timeoutFuture = eventLoop().schedule(this,
-                    nanos, TimeUnit.NANOSECONDS);
+            if (nanos < 0) {
+                // quiche returns UINT64_MAX if there is no timeout.
+                cancel();
+            } else {
+                timerWheel.schedule(this, nanos);
+            }
+        }
+
+        void cancel() {
+            if (timerWheel != null) {
+                timerWheel.cancel(this);
+            }
+        }
+    }
+
+    private final class PacingHandler extends QuicheQuicTimerWheel.Timeout {
+
+        @Override
+        protected void expire() {
+            if (!isConnDestroyed()) {
+                connectionSendNeeded = true;
+                if (connectionSend()) {
+                    flushParent();
+                }
+            }
+        }
+
+        void schedule(long nanos) {
+            timerWheel.schedule(this, nanos);
         }
 
         void cancel() {
-            if (timeoutFuture != null) {
-                timeoutFuture.cancel(false);
-                timeoutFuture = null;
+            if (timerWheel != null) {
+                timerWheel.cancel(this);
             }
         }
     }
 
     @Override
-    public Future<QuicConnectionStats> collectStats(Promise<QuicConnectionStats> promise) {
+    public Future<QuicConnectionStats> collectStats(MutableQuicConnectionStats stats,
+                                                    Promise<QuicConnectionStats> promise) {
         if (eventLoop().inEventLoop()) {
-            collectStats0(promise);
+            collectStats0(stats, promise);
         } else {
-            eventLoop().execute(() -> collectStats0(promise));
+            eventLoop().execute(() -> collectStats0(stats, promise));
         }
         return promise;
     }
 
-    private QuicConnectionStats collectStats0(Promise<QuicConnectionStats> promise) {
+    private void collectStats0(MutableQuicConnectionStats stats, Promise<QuicConnectionStats> promise) {
         if (isConnDestroyed()) {
-            promise.setSuccess(statsAtClose);
-            return statsAtClose;
-        }
-
-        final long[] stats = Quiche.quiche_conn_stats(connAddr);
-        if (stats == null) {
-            promise.setFailure(new IllegalStateException("native quiche_conn_stats(...) failed"));
-            return null;
+            stats.copyFrom(statsAtClose);
+        } else {
+            collectStats0(stats);
         }
+        promise.setSuccess(stats);
+    }
 
-        final DefaultQuicConnectionStats connStats =
-            new DefaultQuicConnectionStats(stats[0], stats[1], stats[2], stats[3], stats[4], stats[5]);
-        promise.setSuccess(connStats);
-        return connStats;
+    private void collectStats0(MutableQuicConnectionStats stats) {
+        ByteBuf statsBuffer = QuicheScratchBuffers.get().stats();
+        Quiche.quiche_conn_stats(connAddr, Quiche.memoryAddress(statsBuffer));
+        stats.setNativeStats(statsBuffer.getLong(Quiche.QUICHE_STATS_RECV_OFFSET),
+                statsBuffer.getLong(Quiche.QUICHE_STATS_SENT_OFFSET),
+                statsBuffer.getLong(Quiche.QUICHE_STATS_LOST_OFFSET),
+                statsBuffer.getLong(Quiche.QUICHE_STATS_RTT_OFFSET),
+                statsBuffer.getLong(Quiche.QUICHE_STATS_CWND_OFFSET),
+                statsBuffer.getLong(Quiche.QUICHE_STATS_DELIVERY_RATE_OFFSET));
+        stats.setStreamStats(streams.size(), totalStreams);
+        stats.setMemoryUsed(memoryUsed);
+        stats.setHandshakeDurationNanos(handshakeDurationNanos);
     }
 }
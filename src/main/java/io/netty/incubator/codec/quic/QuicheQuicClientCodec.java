@@ -16,42 +16,56 @@
 package io.netty.incubator.codec.quic;
 
 import io.netty.buffer.ByteBuf;
+import io.netty.channel.ChannelException;
 import io.netty.channel.ChannelHandlerContext;
 import io.netty.channel.ChannelPromise;
 
 import java.net.InetSocketAddress;
 import java.net.SocketAddress;
-import java.nio.ByteBuffer;
 
 /**
  * {@link QuicheQuicCodec} for QUIC clients.
  */
 final class QuicheQuicClientCodec extends QuicheQuicCodec {
 
-    QuicheQuicClientCodec(QuicheConfig config) {
+    QuicheQuicClientCodec(QuicheConfig config, SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator,
+                          QuicMetricsCollector metricsCollector) {
         // Let's just use Quic.MAX_DATAGRAM_SIZE as the maximum size for a token on the client side. This should be
         // safe enough and as we not have too many codecs at the same time this should be ok.
-        super(config, Quic.MAX_DATAGRAM_SIZE);
+        super(config, Quic.MAX_DATAGRAM_SIZE, segmentedDatagramPacketAllocator, metricsCollector);
     }
 
     @Override
     protected QuicheQuicChannel quicPacketRead(
             ChannelHandlerContext ctx, InetSocketAddress sender, InetSocketAddress recipient,
             byte type, int version, ByteBuf scid, ByteBuf dcid,
-            ByteBuf token) {
-        ByteBuffer key = dcid.internalNioBuffer(dcid.readerIndex(), dcid.readableBytes());
-        return getChannel(key);
+            ByteBuf token, ByteBuf packet) {
+        QuicheQuicChannel channel = getChannel(dcid);
+        if (channel == null) {
+            metrics.packetDropped();
+        }
+        return channel;
     }
 
     @Override
     public void connect(ChannelHandlerContext ctx, SocketAddress remoteAddress,
                         SocketAddress localAddress, ChannelPromise promise) {
+        if (!config.memoryBudget().canOpenConnection()) {
+            metrics.connectionShed();
+            promise.setFailure(new ChannelException("Memory budget of the codec exhausted"));
+            return;
+        }
         final QuicheQuicChannel channel;
+        QuicheNativeConfig nativeConfig = config.acquireNativeConfig(
+                config.windowTier(QuicheQuicChannel.connectRemoteAddress(remoteAddress)));
         try {
-            channel = QuicheQuicChannel.handleConnect(remoteAddress, nativeConfig);
+            channel = QuicheQuicChannel.handleConnect(
+                    remoteAddress, nativeConfig.address(), segmentedDatagramPacketAllocator);
         } catch (Exception e) {
             promise.setFailure(e);
             return;
+        } finally {
+            nativeConfig.release();
         }
         if (channel != null) {
             putChannel(channel);
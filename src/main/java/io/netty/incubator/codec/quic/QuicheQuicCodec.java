@@ -17,6 +17,7 @@ package io.netty.incubator.codec.quic;
 
 import io.netty.buffer.ByteBuf;
 import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
 import io.netty.channel.ChannelDuplexHandler;
 import io.netty.channel.ChannelHandlerContext;
 import io.netty.channel.socket.DatagramPacket;
@@ -28,9 +29,6 @@ import java.net.InetSocketAddress;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
 import java.util.ArrayDeque;
-import java.util.HashMap;
-import java.util.Iterator;
-import java.util.Map;
 import java.util.Queue;
 
 /**
@@ -39,48 +37,95 @@ import java.util.Queue;
 abstract class QuicheQuicCodec extends ChannelDuplexHandler {
     private static final InternalLogger LOGGER = InternalLoggerFactory.getInstance(QuicheQuicCodec.class);
 
-    private final Map<ByteBuffer, QuicheQuicChannel> connections = new HashMap<>();
+    // The maximum number of QUIC packets we will parse and dispatch in one go. This matches the number of datagrams
+    // that may be read via recvmmsg(...) in the native epoll transport.
+    private static final int MAX_BURST = 64;
+    // The maximum number of send batches a connection may write each time it is resumed after the parent became
+    // writable again, before the next ready connection gets its turn.
+    private static final int SEND_QUANTUM = 4;
+
+    private final ConnectionIdChannelMap connections = new ConnectionIdChannelMap();
     private final Queue<QuicheQuicChannel> needsFireChannelReadComplete = new ArrayDeque<>();
+    private final QuicheQuicReadyQueue readyQueue = new QuicheQuicReadyQueue();
     private final int maxTokenLength;
+    private final int headerInfoEntryLength;
     private boolean needsFlush;
     private boolean inChannelRead;
 
-    private ByteBuf versionBuffer;
-    private ByteBuf typeBuffer;
-    private ByteBuf scidLenBuffer;
+    // The QUIC packets of the current burst that were not processed yet. Each buffer holds one reference that is
+    // released once the packet was processed.
+    private final ByteBuf[] burstBuffers = new ByteBuf[MAX_BURST];
+    private final InetSocketAddress[] burstSenders = new InetSocketAddress[MAX_BURST];
+    private final InetSocketAddress[] burstRecipients = new InetSocketAddress[MAX_BURST];
+    private final QuicheQuicChannel[] burstChannels = new QuicheQuicChannel[MAX_BURST];
+    private int burstSize;
+    private int burstHeapBytes;
+
+    private QuicheQuicTimerWheel timerWheel;
+    // Scratch buffers of the event loop, these are shared with other codecs and only valid during processBurst(...).
+    private ByteBuf headerInfoBuffer;
     private ByteBuf scidBuffer;
-    private ByteBuf dcidLenBuffer;
     private ByteBuf dcidBuffer;
     private ByteBuf tokenBuffer;
-    private ByteBuf tokenLenBuffer;
 
     protected final QuicheConfig config;
-    protected long nativeConfig;
+    protected final SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator;
+    protected final QuicheQuicCodecMetrics metrics = new QuicheQuicCodecMetrics();
+    private final QuicMetricsCollector metricsCollector;
 
-    QuicheQuicCodec(QuicheConfig config, int maxTokenLength) {
+    QuicheQuicCodec(QuicheConfig config, int maxTokenLength,
+                    SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator,
+                    QuicMetricsCollector metricsCollector) {
         this.config = config;
         this.maxTokenLength = maxTokenLength;
+        this.headerInfoEntryLength = Quiche.headerInfoEntryLength(maxTokenLength);
+        this.segmentedDatagramPacketAllocator = segmentedDatagramPacketAllocator;
+        this.metricsCollector = metricsCollector;
     }
 
-    protected QuicheQuicChannel getChannel(ByteBuffer key) {
-        return connections.get(key);
+    protected QuicheQuicChannel getChannel(ByteBuf connectionId) {
+        return connections.get(connectionId);
     }
 
     protected void putChannel(QuicheQuicChannel channel) {
+        channel.timerWheel(timerWheel);
+        channel.readyQueue(readyQueue);
+        channel.memoryBudget(config.memoryBudget());
+        channel.datagramSupported(config.isDatagramSupported());
+        channel.pacing(config.isPacingEnabled());
+        channel.bdpHistory(config.bdpHistory());
+        channel.metrics(metrics);
         connections.put(channel.key(), channel);
+        ByteBuffer originalKey = channel.originalKey();
+        if (originalKey != null) {
+            connections.put(originalKey, channel);
+        }
+    }
+
+    protected void removeChannel(QuicheQuicChannel channel) {
+        ByteBuffer originalKey = channel.originalKey();
+        if (originalKey != null && connections.get(originalKey) == channel) {
+            connections.remove(originalKey);
+        }
+        if (connections.remove(channel.key()) == channel) {
+            channelRemoved(channel);
+        }
+    }
+
+    /**
+     * Called once a closed {@link QuicheQuicChannel} was removed from this codec.
+     */
+    protected void channelRemoved(QuicheQuicChannel channel) {
+        // NOOP
     }
 
     @Override
     public void handlerAdded(ChannelHandlerContext ctx) {
-        versionBuffer = allocateNativeOrder(Integer.BYTES);
-        typeBuffer = allocateNativeOrder(Byte.BYTES);
-        scidBuffer = allocateNativeOrder(Quiche.QUICHE_MAX_CONN_ID_LEN);
-        scidLenBuffer = allocateNativeOrder(Integer.BYTES);
-        dcidBuffer = allocateNativeOrder(Quiche.QUICHE_MAX_CONN_ID_LEN);
-        dcidLenBuffer = allocateNativeOrder(Integer.BYTES);
-        tokenLenBuffer = allocateNativeOrder(Integer.BYTES);
-        tokenBuffer = allocateNativeOrder(maxTokenLength);
-        nativeConfig = config.createNativeConfig();
+        timerWheel = new QuicheQuicTimerWheel(ctx.channel().eventLoop());
+        config.attach();
+        if (metricsCollector != null) {
+            metricsCollector.register(metrics);
+        }
     }
 
     @SuppressWarnings("deprecation")
@@ -95,84 +140,184 @@ abstract class QuicheQuicCodec extends ChannelDuplexHandler {
 
     @Override
     public void handlerRemoved(ChannelHandlerContext ctx) {
-        for (QuicheQuicChannel ch: connections.values()) {
-            ch.forceClose();
+        releaseBurst();
+
+        for (int i = 0; i < connections.capacity(); i++) {
+            QuicheQuicChannel ch = connections.valueAt(i);
+            if (ch != null) {
+                ch.forceClose();
+            }
         }
         connections.clear();
+        timerWheel.close();
+        if (metricsCollector != null) {
+            metricsCollector.unregister(metrics);
+        }
 
         needsFireChannelReadComplete.clear();
+        readyQueue.clear();
 
-        Quiche.quiche_config_free(nativeConfig);
-
-        versionBuffer.release();
-        scidBuffer.release();
-        scidLenBuffer.release();
-        dcidBuffer.release();
-        dcidLenBuffer.release();
-        tokenLenBuffer.release();
-        tokenBuffer.release();
+        config.detach();
     }
 
     @Override
-    public void channelRead(ChannelHandlerContext ctx, Object msg) throws Exception {
+    public void channelRead(ChannelHandlerContext ctx, Object msg) {
         DatagramPacket packet = (DatagramPacket) msg;
+        inChannelRead = true;
+
+        // The reference is now owned by the burst.
+        addToBurst(ctx, packet.content(), packet.sender(), packet.recipient());
+    }
+
+    private void addToBurst(ChannelHandlerContext ctx, ByteBuf buffer,
+                            InetSocketAddress sender, InetSocketAddress recipient) {
+        int idx = burstSize;
+        burstBuffers[idx] = buffer;
+        burstSenders[idx] = sender;
+        burstRecipients[idx] = recipient;
+        if (!buffer.isDirect()) {
+            burstHeapBytes += buffer.readableBytes();
+        }
+        if (++burstSize == MAX_BURST) {
+            processBurst(ctx);
+        }
+    }
+
+    /**
+     * Process all QUIC packets of the current burst. The headers of all packets are parsed via one JNI call and
+     * after that all packets that belong to the same connection are passed to it in one go.
+     */
+    private void processBurst(ChannelHandlerContext ctx) {
+        int size = burstSize;
+        if (size == 0) {
+            return;
+        }
         try {
-            ByteBuf buffer = ((DatagramPacket) msg).content();
-            if (!buffer.isDirect()) {
-                // We need a direct buffer as otherwise we can not access the memoryAddress.
-                // Let's do a copy to direct memory.
-                ByteBuf direct = ctx.alloc().directBuffer(buffer.readableBytes());
-                try {
-                    direct.writeBytes(buffer, buffer.readerIndex(), buffer.readableBytes());
-                    channelRead(ctx, packet.sender(), packet.recipient(), direct);
-                } finally {
-                    direct.release();
+            if (burstHeapBytes > 0) {
+                copyHeapBuffers(ctx, size);
+            }
+            QuicheScratchBuffers scratchBuffers = QuicheScratchBuffers.get();
+            headerInfoBuffer = scratchBuffers.headerInfo(headerInfoEntryLength * MAX_BURST);
+            scidBuffer = scratchBuffers.scid();
+            dcidBuffer = scratchBuffers.dcid();
+            tokenBuffer = scratchBuffers.token(maxTokenLength);
+            long bytes = 0;
+            for (int i = 0, offset = 0; i < size; i++, offset += headerInfoEntryLength) {
+                ByteBuf buffer = burstBuffers[i];
+                int readable = buffer.readableBytes();
+                headerInfoBuffer.setLong(offset + Quiche.HEADER_INFO_BUF_OFFSET,
+                        Quiche.memoryAddress(buffer) + buffer.readerIndex());
+                headerInfoBuffer.setInt(offset + Quiche.HEADER_INFO_BUF_LEN_OFFSET, readable);
+                bytes += readable;
+            }
+            metrics.packetsRead(size, bytes);
+            Quiche.quiche_header_info_batch(Quiche.memoryAddress(headerInfoBuffer), size, headerInfoEntryLength,
+                    Quiche.QUICHE_MAX_CONN_ID_LEN);
+
+            for (int i = 0, offset = 0; i < size; i++, offset += headerInfoEntryLength) {
+                burstChannels[i] = quicPacketRead(ctx, i, offset);
+            }
+
+            for (int i = 0; i < size; i++) {
+                QuicheQuicChannel channel = burstChannels[i];
+                if (channel == null) {
+                    continue;
+                }
+                int last = i;
+                for (int j = i + 1; j < size; j++) {
+                    if (burstChannels[j] == channel) {
+                        last = j;
+                    }
+                }
+                // Pass all packets of the burst that belong to the same connection in one go while still
+                // preserving the order in which these were received. Readable streams only need to be notified
+                // once all of these were passed to the connection.
+                for (int j = i; j <= last; j++) {
+                    if (burstChannels[j] == channel) {
+                        burstChannels[j] = null;
+                        ByteBuf buffer = burstBuffers[j];
+                        if (!channel.isHandedOff()) {
+                            channel.recv(buffer, j == last);
+                        }
+                        if (channel.isHandedOff() && buffer.isReadable()) {
+                            // The connection was taken over while we processed the burst, pass on everything it
+                            // did not consume so far.
+                            handedOffPacketRead(channel, burstSenders[j], burstRecipients[j], buffer);
+                        }
+                    }
+                }
+                if (channel.markInFireChannelReadCompleteQueue()) {
+                    needsFireChannelReadComplete.add(channel);
                 }
-            } else {
-                channelRead(ctx, packet.sender(), packet.recipient(), buffer);
             }
         } finally {
-            packet.release();
+            releaseBurst();
         }
     }
 
-    private void channelRead(ChannelHandlerContext ctx, InetSocketAddress sender,
-                             InetSocketAddress recipient, ByteBuf buffer) throws Exception {
-        long contentAddress = Quiche.memoryAddress(buffer) + buffer.readerIndex();
-        int contentReadable = buffer.readableBytes();
-
-        // Ret various len values so quiche_header_info can make use of these.
-        scidLenBuffer.setInt(0, Quiche.QUICHE_MAX_CONN_ID_LEN);
-        dcidLenBuffer.setInt(0, Quiche.QUICHE_MAX_CONN_ID_LEN);
-        tokenLenBuffer.setInt(0, maxTokenLength);
-
-        int res = Quiche.quiche_header_info(contentAddress, contentReadable, Quiche.QUICHE_MAX_CONN_ID_LEN,
-                Quiche.memoryAddress(versionBuffer), Quiche.memoryAddress(typeBuffer),
-                Quiche.memoryAddress(scidBuffer), Quiche.memoryAddress(scidLenBuffer),
-                Quiche.memoryAddress(dcidBuffer), Quiche.memoryAddress(dcidLenBuffer),
-                Quiche.memoryAddress(tokenBuffer), Quiche.memoryAddress(tokenLenBuffer));
-        if (res >= 0) {
-            int version = versionBuffer.getInt(0);
-            byte type = typeBuffer.getByte(0);
-            int scidLen = scidLenBuffer.getInt(0);
-            int dcidLen = dcidLenBuffer.getInt(0);
-            int tokenLen = tokenLenBuffer.getInt(0);
-
-            QuicheQuicChannel channel = quicPacketRead(ctx, sender, recipient,
-                    type, version, scidBuffer.setIndex(0, scidLen),
-                    dcidBuffer.setIndex(0, dcidLen), tokenBuffer.setIndex(0, tokenLen));
-            if (channel != null) {
-                channel.recv(buffer);
-                if (channel.markInFireChannelReadCompleteQueue()) {
-                    needsFireChannelReadComplete.add(channel);
+    // We need direct buffers as otherwise we can not access the memoryAddress. Copy all heap buffers of the burst
+    // into one direct buffer so we only need one allocation.
+    private void copyHeapBuffers(ChannelHandlerContext ctx, int size) {
+        ByteBuf direct = ctx.alloc().directBuffer(burstHeapBytes);
+        try {
+            for (int i = 0; i < size; i++) {
+                ByteBuf buffer = burstBuffers[i];
+                if (!buffer.isDirect()) {
+                    int readable = buffer.readableBytes();
+                    int index = direct.writerIndex();
+                    direct.writeBytes(buffer, buffer.readerIndex(), readable);
+                    burstBuffers[i] = direct.retainedSlice(index, readable);
+                    buffer.release();
                 }
             }
-        } else {
+        } finally {
+            direct.release();
+        }
+    }
+
+    private QuicheQuicChannel quicPacketRead(ChannelHandlerContext ctx, int idx, int offset) {
+        int res = headerInfoBuffer.getInt(offset + Quiche.HEADER_INFO_RES_OFFSET);
+        if (res < 0) {
             LOGGER.debug("Unable to parse QUIC header via quiche_header_info: {}", Quiche.errorAsString(res));
+            metrics.packetDropped();
+            return null;
+        }
+        int version = headerInfoBuffer.getInt(offset + Quiche.HEADER_INFO_VERSION_OFFSET);
+        byte type = headerInfoBuffer.getByte(offset + Quiche.HEADER_INFO_TYPE_OFFSET);
+        int scidLen = headerInfoBuffer.getInt(offset + Quiche.HEADER_INFO_SCID_LEN_OFFSET);
+        int dcidLen = headerInfoBuffer.getInt(offset + Quiche.HEADER_INFO_DCID_LEN_OFFSET);
+        int tokenLen = headerInfoBuffer.getInt(offset + Quiche.HEADER_INFO_TOKEN_LEN_OFFSET);
+
+        scidBuffer.setBytes(0, headerInfoBuffer, offset + Quiche.HEADER_INFO_SCID_OFFSET, scidLen);
+        dcidBuffer.setBytes(0, headerInfoBuffer, offset + Quiche.HEADER_INFO_DCID_OFFSET, dcidLen);
+        if (tokenLen > 0) {
+            tokenBuffer.setBytes(0, headerInfoBuffer, offset + Quiche.HEADER_INFO_TOKEN_OFFSET, tokenLen);
+        }
+        try {
+            return quicPacketRead(ctx, burstSenders[idx], burstRecipients[idx],
+                    type, version, scidBuffer.setIndex(0, scidLen),
+                    dcidBuffer.setIndex(0, dcidLen), tokenBuffer.setIndex(0, tokenLen), burstBuffers[idx]);
+        } catch (Exception e) {
+            metrics.packetDropped();
+            ctx.fireExceptionCaught(e);
+            return null;
         }
     }
+
+    private void releaseBurst() {
+        for (int i = 0; i < burstSize; i++) {
+            burstBuffers[i].release();
+            burstBuffers[i] = null;
+            burstSenders[i] = null;
+            burstRecipients[i] = null;
+            burstChannels[i] = null;
+        }
+        burstSize = 0;
+        burstHeapBytes = 0;
+    }
+
     /**
-     * Handle a QUIC packet and return {@code true} if we need to call {@link ChannelHandlerContext#flush()}.
+     * Handle a QUIC packet and return the {@link QuicheQuicChannel} it belongs to.
      *
      * @param ctx the {@link ChannelHandlerContext}.
      * @param sender the {@link InetSocketAddress} of the sender of the QUIC packet
@@ -182,16 +327,36 @@ abstract class QuicheQuicCodec extends ChannelDuplexHandler {
      * @param scid the source connection id.
      * @param dcid the destination connection id
      * @param token the token
-     * @return {@code true} if we need to call {@link ChannelHandlerContext#flush()} before there is no new events
-     *                      for this handler in the current eventloop run.
+     * @param packet the whole QUIC packet. This buffer is released once the packet was processed, so it needs to
+     *               be retained if it is used after this method returns.
+     * @return the {@link QuicheQuicChannel} the packet needs to be passed to, or {@code null} if the packet was
+     *         handled already, for example because it was dropped or answered directly.
      * @throws Exception  thrown if there is an error during processing.
      */
     protected abstract QuicheQuicChannel quicPacketRead(ChannelHandlerContext ctx, InetSocketAddress sender,
                                                         InetSocketAddress recipient, byte type, int version,
-                                                        ByteBuf scid, ByteBuf dcid, ByteBuf token) throws Exception;
+                                                        ByteBuf scid, ByteBuf dcid, ByteBuf token,
+                                                        ByteBuf packet) throws Exception;
+
+    /**
+     * Handle a QUIC packet of a connection that was handed off to another channel while the burst the packet is part
+     * of was processed. By default the packet is dropped.
+     *
+     * @param channel the {@link QuicheQuicChannel} that handed off the connection.
+     * @param sender the {@link InetSocketAddress} of the sender of the QUIC packet
+     * @param recipient the {@link InetSocketAddress} of the recipient of the QUIC packet
+     * @param packet the QUIC packet. This buffer is released once the packet was processed, so it needs to
+     *               be retained if it is used after this method returns.
+     */
+    protected void handedOffPacketRead(QuicheQuicChannel channel, InetSocketAddress sender,
+                                       InetSocketAddress recipient, ByteBuf packet) {
+        metrics.packetDropped();
+    }
 
     @Override
     public final void channelReadComplete(ChannelHandlerContext ctx) {
+        processBurst(ctx);
+
         boolean writeDone = needsFlush;
         needsFlush = false;
         inChannelRead = false;
@@ -202,7 +367,7 @@ abstract class QuicheQuicCodec extends ChannelDuplexHandler {
             }
             writeDone |= channel.channelReadComplete();
             if (channel.freeIfClosed()) {
-                connections.remove(channel.key());
+                removeChannel(channel);
             }
         }
 
@@ -224,15 +389,7 @@ abstract class QuicheQuicCodec extends ChannelDuplexHandler {
     @Override
     public final void channelWritabilityChanged(ChannelHandlerContext ctx) {
         if (ctx.channel().isWritable()) {
-            boolean writeDone = false;
-            Iterator<Map.Entry<ByteBuffer, QuicheQuicChannel>> entries = connections.entrySet().iterator();
-            while (entries.hasNext()) {
-                QuicheQuicChannel channel = entries.next().getValue();
-                // TODO: Be a bit smarter about this.
-                writeDone |= channel.writable();
-                removeIfClosed(entries, channel);
-            }
-            if (writeDone) {
+            if (resumeReady(ctx.channel())) {
                 flushNow(ctx);
             }
         } else {
@@ -243,9 +400,36 @@ abstract class QuicheQuicCodec extends ChannelDuplexHandler {
         ctx.fireChannelWritabilityChanged();
     }
 
-    private static void removeIfClosed(Iterator<?> iterator, QuicheQuicChannel current) {
-        if (current.freeIfClosed()) {
-            iterator.remove();
+    /**
+     * Resume the connections in the {@link QuicheQuicReadyQueue} in round-robin order, each with a quantum of
+     * {@link #SEND_QUANTUM} batches, until the queue is empty, the parent becomes unwritable or a full round made no
+     * progress. Returns {@code true} if something was written.
+     */
+    private boolean resumeReady(Channel parent) {
+        boolean writeDone = false;
+        for (;;) {
+            boolean progress = false;
+            // Connections that are not done yet add themselves to the end of the queue again, so only visit the
+            // connections of this round.
+            int round = readyQueue.size();
+            while (round-- > 0 && parent.isWritable()) {
+                QuicheQuicReadyQueue.Entry entry = readyQueue.poll();
+                if (entry == null) {
+                    // Connections that were closed in the meantime removed themselves.
+                    break;
+                }
+                QuicheQuicChannel channel = entry.channel();
+                if (channel.writable(SEND_QUANTUM)) {
+                    progress = true;
+                }
+                if (channel.freeIfClosed()) {
+                    removeChannel(channel);
+                }
+            }
+            writeDone |= progress;
+            if (!progress || readyQueue.isEmpty() || !parent.isWritable()) {
+                return writeDone;
+            }
         }
     }
 
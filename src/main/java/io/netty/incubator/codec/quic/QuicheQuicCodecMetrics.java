@@ -0,0 +1,174 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.internal.StringUtil;
+
+import java.util.concurrent.atomic.AtomicLongFieldUpdater;
+
+/**
+ * {@link QuicCodecMetrics} implementation that is used by {@link QuicheQuicCodec}. All the methods that update the
+ * counters must only be called from the {@link io.netty.channel.EventLoop} of the codec. As there is only a single
+ * writer we can just use ordered writes and don't need any atomic read-modify-write operations.
+ */
+final class QuicheQuicCodecMetrics implements QuicCodecMetrics {
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> PACKETS_READ_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "packetsRead");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> BYTES_READ_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "bytesRead");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> PACKETS_WRITTEN_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "packetsWritten");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> BYTES_WRITTEN_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "bytesWritten");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> ACCEPTED_CONNECTIONS_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "acceptedConnections");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> PENDING_HANDSHAKES_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "pendingHandshakes");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> RETRIES_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "retries");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> VERSION_NEGOTIATIONS_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "versionNegotiations");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> DROPPED_PACKETS_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "droppedPackets");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> SHED_CONNECTIONS_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "shedConnections");
+    private static final AtomicLongFieldUpdater<QuicheQuicCodecMetrics> SHED_STREAMS_UPDATER =
+            AtomicLongFieldUpdater.newUpdater(QuicheQuicCodecMetrics.class, "shedStreams");
+
+    private volatile long packetsRead;
+    private volatile long bytesRead;
+    private volatile long packetsWritten;
+    private volatile long bytesWritten;
+    private volatile long acceptedConnections;
+    private volatile long pendingHandshakes;
+    private volatile long retries;
+    private volatile long versionNegotiations;
+    private volatile long droppedPackets;
+    private volatile long shedConnections;
+    private volatile long shedStreams;
+
+    void packetsRead(int packets, long bytes) {
+        PACKETS_READ_UPDATER.lazySet(this, packetsRead + packets);
+        BYTES_READ_UPDATER.lazySet(this, bytesRead + bytes);
+    }
+
+    void packetsWritten(int packets, long bytes) {
+        PACKETS_WRITTEN_UPDATER.lazySet(this, packetsWritten + packets);
+        BYTES_WRITTEN_UPDATER.lazySet(this, bytesWritten + bytes);
+    }
+
+    void connectionAccepted() {
+        ACCEPTED_CONNECTIONS_UPDATER.lazySet(this, acceptedConnections + 1);
+        PENDING_HANDSHAKES_UPDATER.lazySet(this, pendingHandshakes + 1);
+    }
+
+    // Called once the handshake of an accepted connection completed or failed.
+    void handshakeFinished() {
+        PENDING_HANDSHAKES_UPDATER.lazySet(this, pendingHandshakes - 1);
+    }
+
+    void retry() {
+        RETRIES_UPDATER.lazySet(this, retries + 1);
+    }
+
+    void versionNegotiation() {
+        VERSION_NEGOTIATIONS_UPDATER.lazySet(this, versionNegotiations + 1);
+    }
+
+    void packetDropped() {
+        DROPPED_PACKETS_UPDATER.lazySet(this, droppedPackets + 1);
+    }
+
+    void connectionShed() {
+        SHED_CONNECTIONS_UPDATER.lazySet(this, shedConnections + 1);
+    }
+
+    void streamShed() {
+        SHED_STREAMS_UPDATER.lazySet(this, shedStreams + 1);
+    }
+
+    @Override
+    public long packetsRead() {
+        return packetsRead;
+    }
+
+    @Override
+    public long bytesRead() {
+        return bytesRead;
+    }
+
+    @Override
+    public long packetsWritten() {
+        return packetsWritten;
+    }
+
+    @Override
+    public long bytesWritten() {
+        return bytesWritten;
+    }
+
+    @Override
+    public long acceptedConnections() {
+        return acceptedConnections;
+    }
+
+    @Override
+    public long pendingHandshakes() {
+        return pendingHandshakes;
+    }
+
+    @Override
+    public long retries() {
+        return retries;
+    }
+
+    @Override
+    public long versionNegotiations() {
+        return versionNegotiations;
+    }
+
+    @Override
+    public long droppedPackets() {
+        return droppedPackets;
+    }
+
+    @Override
+    public long shedConnections() {
+        return shedConnections;
+    }
+
+    @Override
+    public long shedStreams() {
+        return shedStreams;
+    }
+
+    @Override
+    public String toString() {
+        return StringUtil.simpleClassName(this) +
+                "[packetsRead=" + packetsRead +
+                ", bytesRead=" + bytesRead +
+                ", packetsWritten=" + packetsWritten +
+                ", bytesWritten=" + bytesWritten +
+                ", acceptedConnections=" + acceptedConnections +
+                ", pendingHandshakes=" + pendingHandshakes +
+                ", retries=" + retries +
+                ", versionNegotiations=" + versionNegotiations +
+                ", droppedPackets=" + droppedPackets +
+                ", shedConnections=" + shedConnections +
+                ", shedStreams=" + shedStreams +
+                ']';
+    }
+}
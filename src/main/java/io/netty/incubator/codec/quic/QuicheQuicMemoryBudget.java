@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import java.util.concurrent.atomic.LongAdder;
+
+/**
+ * Tracks the memory used by the connections of all codecs that share the same {@link QuicheConfig} and decides if
+ * new connections and streams can be accepted.
+ *
+ * quiche 0.6.0 does not expose how much memory a connection or the stream data it buffers uses, so the native part
+ * is estimated with a fixed cost per connection and per stream. On top of that the direct memory of the writes that
+ * are queued on the streams of a connection but were not taken by quiche yet is accounted exactly.
+ */
+final class QuicheQuicMemoryBudget {
+    // Rough estimate of the memory used by a quiche_conn including its TLS state.
+    static final long CONNECTION_COST = 16 * 1024;
+    // Rough estimate of the memory used by the state of a stream in quiche.
+    static final long STREAM_COST = 1024;
+
+    private final long maxConnectionMemory;
+    private final long maxTotalMemory;
+    private final LongAdder used = new LongAdder();
+
+    /**
+     * @param maxConnectionMemory   the memory a single connection may use before no new streams are accepted, or
+     *                              {@code 0} if unlimited.
+     * @param maxTotalMemory        the memory all connections may use before no new connections and streams are
+     *                              accepted, or {@code 0} if unlimited.
+     */
+    QuicheQuicMemoryBudget(long maxConnectionMemory, long maxTotalMemory) {
+        this.maxConnectionMemory = maxConnectionMemory;
+        this.maxTotalMemory = maxTotalMemory;
+    }
+
+    /**
+     * Returns {@code true} if a new connection can be accepted.
+     */
+    boolean canOpenConnection() {
+        return maxTotalMemory == 0 || used.sum() + CONNECTION_COST <= maxTotalMemory;
+    }
+
+    /**
+     * Returns {@code true} if a new stream can be opened on a connection that uses {@code connectionMemory} bytes.
+     */
+    boolean canOpenStream(long connectionMemory) {
+        if (maxConnectionMemory != 0 && connectionMemory + STREAM_COST > maxConnectionMemory) {
+            return false;
+        }
+        return maxTotalMemory == 0 || used.sum() + STREAM_COST <= maxTotalMemory;
+    }
+
+    /**
+     * Account memory that was allocated (positive) or released (negative).
+     */
+    void add(long bytes) {
+        used.add(bytes);
+    }
+
+    /**
+     * The memory that is used by all connections right now.
+     */
+    long used() {
+        return used.sum();
+    }
+}
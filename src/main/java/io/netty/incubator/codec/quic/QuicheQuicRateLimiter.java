@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Counts events in one second windows. This is not thread-safe and so must only be used from the
+ * {@link io.netty.channel.EventLoop} of the codec.
+ */
+final class QuicheQuicRateLimiter {
+    private static final long WINDOW_NANOS = TimeUnit.SECONDS.toNanos(1);
+
+    private final int maxPerSecond;
+    private long windowStart = System.nanoTime();
+    private int count;
+
+    /**
+     * Create a new instance that allows {@code maxPerSecond} events per second, {@code 0} means no limit.
+     */
+    QuicheQuicRateLimiter(int maxPerSecond) {
+        this.maxPerSecond = maxPerSecond;
+    }
+
+    /**
+     * Record one event and return {@code true} if the limit was not exceeded.
+     */
+    boolean tryAcquire() {
+        if (maxPerSecond == 0) {
+            return true;
+        }
+        long now = System.nanoTime();
+        if (now - windowStart >= WINDOW_NANOS) {
+            windowStart = now;
+            count = 0;
+        }
+        return ++count <= maxPerSecond;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+/**
+ * FIFO of the {@link QuicheQuicChannel}s of a codec that have streams with pending writes or datagrams they could not
+ * send as the parent {@link io.netty.channel.Channel} was not writable. Once the parent becomes writable again only
+ * these connections need to be resumed, which is done in round-robin order so no connection can starve the others.
+ *
+ * {@link Entry}s are linked into the queue directly, so adding and removing a connection never allocates and is
+ * {@code O(1)}. All operations must be done from the {@link io.netty.channel.EventLoop} of the codec.
+ */
+final class QuicheQuicReadyQueue {
+
+    /**
+     * Entry of the {@link QuicheQuicReadyQueue}, each {@link QuicheQuicChannel} owns exactly one.
+     */
+    static final class Entry {
+        private final QuicheQuicChannel channel;
+        private Entry prev;
+        private Entry next;
+        private boolean queued;
+
+        Entry(QuicheQuicChannel channel) {
+            this.channel = channel;
+        }
+
+        QuicheQuicChannel channel() {
+            return channel;
+        }
+
+        boolean isQueued() {
+            return queued;
+        }
+    }
+
+    private Entry head;
+    private Entry tail;
+    private int size;
+
+    /**
+     * Add the {@link Entry} to the end of the queue if it is not queued yet.
+     */
+    void add(Entry entry) {
+        if (entry.queued) {
+            return;
+        }
+        entry.queued = true;
+        entry.prev = tail;
+        entry.next = null;
+        if (tail == null) {
+            head = entry;
+        } else {
+            tail.next = entry;
+        }
+        tail = entry;
+        size++;
+    }
+
+    /**
+     * Remove the {@link Entry} from the queue if it is queued.
+     */
+    void remove(Entry entry) {
+        if (!entry.queued) {
+            return;
+        }
+        if (entry.prev == null) {
+            head = entry.next;
+        } else {
+            entry.prev.next = entry.next;
+        }
+        if (entry.next == null) {
+            tail = entry.prev;
+        } else {
+            entry.next.prev = entry.prev;
+        }
+        entry.prev = null;
+        entry.next = null;
+        entry.queued = false;
+        size--;
+    }
+
+    /**
+     * Remove and return the {@link Entry} at the head of the queue, or {@code null} if it is empty.
+     */
+    Entry poll() {
+        Entry entry = head;
+        if (entry != null) {
+            remove(entry);
+        }
+        return entry;
+    }
+
+    int size() {
+        return size;
+    }
+
+    boolean isEmpty() {
+        return size == 0;
+    }
+
+    void clear() {
+        while (poll() != null) {
+            // just unlink all entries.
+        }
+    }
+}
@@ -22,6 +22,7 @@ import io.netty.channel.ChannelOption;
 import io.netty.channel.socket.DatagramPacket;
 import io.netty.util.AttributeKey;
 import io.netty.util.CharsetUtil;
+import io.netty.util.internal.PlatformDependent;
 import io.netty.util.internal.logging.InternalLogger;
 import io.netty.util.internal.logging.InternalLoggerFactory;
 
@@ -29,6 +30,10 @@ import io.netty.util.internal.logging.InternalLoggerFactory;
 import java.net.InetSocketAddress;
 import java.nio.ByteBuffer;
 import java.util.Map;
+import java.util.Queue;
+import java.util.concurrent.RejectedExecutionException;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.function.Predicate;
 
 /**
  * {@link QuicheQuicCodec} for QUIC servers.
@@ -46,18 +51,41 @@ final class QuicheQuicServerCodec extends QuicheQuicCodec {
     private final Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray;
     // TODO: Make this configurable ?
     private static final int MAX_LOCAL_CONN_ID = Quiche.QUICHE_MAX_CONN_ID_LEN;
-    private ByteBuf mintTokenBuffer;
-    private ByteBuf connIdBuffer;
 
-    QuicheQuicServerCodec(QuicheConfig config, QuicTokenHandler tokenHandler,
+    // Only set if a Retry should just be sent under load, see QuicServerCodecBuilder.adaptiveRetry(int, int).
+    private final QuicheQuicRateLimiter handshakeRateLimiter;
+    private final int maxPendingHandshakes;
+    private final QuicheQuicRateLimiter versionNegotiationRateLimiter;
+
+    // Only used if the server is sharded across multiple channels, see QuicServerCodecBuilder.buildShards(int).
+    private final QuicheQuicServerShards shards;
+    private final int shardId;
+    // The packets that were forwarded by other shards and the connections that were handed off to us by handshake
+    // shards. Both share the queue so the packets of a connection that are forwarded once it was handed off are never
+    // processed before the connection itself.
+    private final Queue<Object> forwardedPackets;
+    private final AtomicBoolean forwardedPacketsScheduled;
+    private final Runnable processForwardedPacketsTask;
+    // Set while the packets that were forwarded by other shards are processed.
+    private boolean processingForwardedPackets;
+    private volatile ChannelHandlerContext ctx;
+
+    // Only used by handshake shards, see QuicServerCodecBuilder.buildShards(int, int).
+    private final Predicate<QuicheQuicChannel> handOff;
+
+    QuicheQuicServerCodec(QuicheConfig config, SegmentedDatagramPacketAllocator segmentedDatagramPacketAllocator,
+                          QuicTokenHandler tokenHandler,
                           QuicConnectionIdGenerator connectionIdAddressGenerator,
                           ChannelHandler handler,
                           Map.Entry<ChannelOption<?>, Object>[] optionsArray,
                           Map.Entry<AttributeKey<?>, Object>[] attrsArray,
                           ChannelHandler streamHandler,
                           Map.Entry<ChannelOption<?>, Object>[] streamOptionsArray,
-                          Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray) {
-        super(config, tokenHandler.maxTokenLength());
+                          Map.Entry<AttributeKey<?>, Object>[] streamAttrsArray,
+                          QuicheQuicServerShards shards, int shardId, QuicMetricsCollector metricsCollector,
+                          int maxHandshakesPerSecond, int maxPendingHandshakes,
+                          int maxVersionNegotiationsPerSecond) {
+        super(config, tokenHandler.maxTokenLength(), segmentedDatagramPacketAllocator, metricsCollector);
         this.tokenHandler = tokenHandler;
         this.connectionIdAddressGenerator = connectionIdAddressGenerator;
         this.handler = handler;
@@ -66,39 +94,198 @@ final class QuicheQuicServerCodec extends QuicheQuicCodec {
         this.streamHandler = streamHandler;
         this.streamOptionsArray = streamOptionsArray;
         this.streamAttrsArray = streamAttrsArray;
+        this.shards = shards;
+        this.shardId = shardId;
+        handshakeRateLimiter = maxPendingHandshakes > 0 ? new QuicheQuicRateLimiter(maxHandshakesPerSecond) : null;
+        this.maxPendingHandshakes = maxPendingHandshakes;
+        versionNegotiationRateLimiter = new QuicheQuicRateLimiter(maxVersionNegotiationsPerSecond);
+        if (shards == null) {
+            forwardedPackets = null;
+            forwardedPacketsScheduled = null;
+            processForwardedPacketsTask = null;
+        } else {
+            forwardedPackets = PlatformDependent.newMpscQueue();
+            forwardedPacketsScheduled = new AtomicBoolean();
+            processForwardedPacketsTask = this::processForwardedPackets;
+        }
+        if (shards != null && shards.isHandshakeShard(shardId)) {
+            handOff = this::handOffConnection;
+        } else {
+            handOff = null;
+        }
     }
 
     @Override
     public void handlerAdded(ChannelHandlerContext ctx) {
         super.handlerAdded(ctx);
-        connIdBuffer = allocateNativeOrder(MAX_LOCAL_CONN_ID);
-        mintTokenBuffer = allocateNativeOrder(tokenHandler.maxTokenLength());
+        if (shards != null) {
+            this.ctx = ctx;
+            shards.register(shardId, this);
+        }
     }
 
     @Override
     public void handlerRemoved(ChannelHandlerContext ctx) {
+        if (shards != null) {
+            shards.unregister(shardId, this);
+            this.ctx = null;
+            releaseForwardedPackets();
+        }
         super.handlerRemoved(ctx);
-        connIdBuffer.release();
-        mintTokenBuffer.release();
     }
 
     @Override
     protected QuicheQuicChannel quicPacketRead(ChannelHandlerContext ctx, InetSocketAddress sender,
                                                InetSocketAddress recipient, byte type, int version,
-                                               ByteBuf scid, ByteBuf dcid, ByteBuf token) throws Exception {
-        ByteBuffer dcidByteBuffer = dcid.internalNioBuffer(dcid.readerIndex(), dcid.readableBytes());
-        QuicheQuicChannel channel = getChannel(dcidByteBuffer);
+                                               ByteBuf scid, ByteBuf dcid, ByteBuf token,
+                                               ByteBuf packet) throws Exception {
+        QuicheQuicChannel channel = getChannel(dcid);
         if (channel == null) {
+            byte first = packet.getByte(packet.readerIndex());
+            boolean longHeader = (first & 0x80) != 0;
+            if (shards != null) {
+                final int target;
+                if (isClientChosenConnectionId(first, version, token)) {
+                    target = shards.acceptingShard(shardId, dcid);
+                } else {
+                    // The packet belongs to a connection of another shard. This can happen after NAT rebinding,
+                    // because the kernel hashed the 4-tuple to another socket or because the connection was handed
+                    // off to a worker.
+                    target = shards.route(shardId, dcid, longHeader, longPacketType(first) == 0,
+                            processingForwardedPackets);
+                }
+                if (target != shardId) {
+                    forward(target, new DatagramPacket(packet.retainedDuplicate(), recipient, sender));
+                    return null;
+                }
+            }
+            if (!longHeader) {
+                // A short header packet can never start a new connection.
+                metrics.packetDropped();
+                return null;
+            }
             return handleServer(ctx, sender, type, version, scid, dcid, token);
         }
 
         return channel;
     }
 
+    /**
+     * Returns {@code true} if the destination connection id of the packet was chosen by the client and so does not
+     * encode a shard. This is the case for Initial packets without a token, 0-RTT packets and packets of versions we
+     * don't support. All other packets use a connection id that was chosen by one of the shards.
+     */
+    private static boolean isClientChosenConnectionId(byte first, int version, ByteBuf token) {
+        if ((first & 0x80) == 0) {
+            // Short header.
+            return false;
+        }
+        if (!Quiche.quiche_version_is_supported(version)) {
+            return true;
+        }
+        int longPacketType = longPacketType(first);
+        return longPacketType == 0 && !token.isReadable() || longPacketType == 1;
+    }
+
+    // The type of a long header packet: 0 is Initial, 1 is 0-RTT, 2 is Handshake and 3 is Retry.
+    private static int longPacketType(byte first) {
+        return (first & 0x30) >> 4;
+    }
+
+    @Override
+    protected void handedOffPacketRead(QuicheQuicChannel channel, InetSocketAddress sender,
+                                       InetSocketAddress recipient, ByteBuf packet) {
+        // The worker was chosen when the connection was created, and adopted the connection already.
+        forward(ShardedQuicConnectionIdGenerator.shardOf(channel.key(), shards.numShards()),
+                new DatagramPacket(packet.retainedDuplicate(), recipient, sender));
+    }
+
+    private void forward(int owner, DatagramPacket packet) {
+        QuicheQuicServerCodec codec = shards.get(owner);
+        if (codec == null || !codec.addForwarded(packet)) {
+            LOGGER.debug("Dropping QUIC packet as shard {} is not active", owner);
+            metrics.packetDropped();
+            packet.release();
+        }
+    }
+
+    // Add a DatagramPacket or an AdoptedConnection to the queue that is processed on our event loop.
+    private boolean addForwarded(Object msg) {
+        ChannelHandlerContext ctx = this.ctx;
+        if (ctx == null) {
+            return false;
+        }
+        forwardedPackets.add(msg);
+        // Only schedule the task once for all the packets that are forwarded before it runs.
+        if (forwardedPacketsScheduled.compareAndSet(false, true)) {
+            try {
+                ctx.channel().eventLoop().execute(processForwardedPacketsTask);
+            } catch (RejectedExecutionException e) {
+                releaseForwardedPackets();
+            }
+        }
+        return true;
+    }
+
+    private void processForwardedPackets() {
+        forwardedPacketsScheduled.set(false);
+        ChannelHandlerContext ctx = this.ctx;
+        if (ctx == null) {
+            releaseForwardedPackets();
+            return;
+        }
+        processingForwardedPackets = true;
+        try {
+            for (;;) {
+                Object msg = forwardedPackets.poll();
+                if (msg == null) {
+                    break;
+                }
+                if (msg instanceof AdoptedConnection) {
+                    adoptConnection0(ctx, (AdoptedConnection) msg);
+                } else {
+                    channelRead(ctx, msg);
+                }
+            }
+            channelReadComplete(ctx);
+        } finally {
+            processingForwardedPackets = false;
+        }
+    }
+
+    private void releaseForwardedPackets() {
+        for (;;) {
+            Object msg = forwardedPackets.poll();
+            if (msg == null) {
+                break;
+            }
+            if (msg instanceof AdoptedConnection) {
+                // There is nothing we can do for the connection anymore.
+                Quiche.quiche_conn_free(((AdoptedConnection) msg).conn);
+            } else {
+                ((DatagramPacket) msg).release();
+            }
+        }
+    }
+
+    // Decide if we want the remote peer to prove its address before we do the work of a handshake.
+    private boolean retryNeeded() {
+        if (handshakeRateLimiter == null) {
+            return true;
+        }
+        // Always count the new connection, so the rate also includes the ones we accept without a Retry.
+        boolean rateExceeded = !handshakeRateLimiter.tryAcquire();
+        return rateExceeded || metrics.pendingHandshakes() >= maxPendingHandshakes;
+    }
+
     private QuicheQuicChannel handleServer(ChannelHandlerContext ctx, InetSocketAddress sender,
                                  @SuppressWarnings("unused") byte type, int version,
                                  ByteBuf scid, ByteBuf dcid, ByteBuf token) throws Exception {
         if (!Quiche.quiche_version_is_supported(version)) {
+            if (!versionNegotiationRateLimiter.tryAcquire()) {
+                metrics.packetDropped();
+                return null;
+            }
             // Version is not supported, try to negotiate it.
             ByteBuf out = ctx.alloc().directBuffer(Quic.MAX_DATAGRAM_SIZE);
             int outWriterIndex = out.writerIndex();
@@ -113,21 +300,28 @@ final class QuicheQuicServerCodec extends QuicheQuicCodec {
                 return null;
             }
 
+            metrics.versionNegotiation();
+            metrics.packetsWritten(1, res);
             ctx.writeAndFlush(new DatagramPacket(out.writerIndex(outWriterIndex + res), sender));
+            return null;
+        }
+
+        if (!config.memoryBudget().canOpenConnection()) {
+            // Shed the new connection, the peer will retry or give up.
+            metrics.connectionShed();
+            return null;
         }
 
         int offset = 0;
         boolean noToken = false;
         if (!token.isReadable()) {
-            // Clear buffers so we can reuse these.
-            mintTokenBuffer.clear();
-            connIdBuffer.clear();
+            QuicheScratchBuffers scratchBuffers = QuicheScratchBuffers.get();
+            ByteBuf mintTokenBuffer = scratchBuffers.mintToken(tokenHandler.maxTokenLength());
+            ByteBuf connIdBuffer = scratchBuffers.connId(MAX_LOCAL_CONN_ID);
 
             // The remote peer did not send a token.
-            if (tokenHandler.writeToken(mintTokenBuffer, dcid, sender)) {
-                ByteBuffer connId = connectionIdAddressGenerator.newId(
-                        dcid.internalNioBuffer(dcid.readerIndex(), dcid.readableBytes()), MAX_LOCAL_CONN_ID);
-                connIdBuffer.writeBytes(connId);
+            if (retryNeeded() && tokenHandler.writeToken(mintTokenBuffer, dcid, sender)) {
+                connIdBuffer.writeBytes(newConnectionId(dcid));
 
                 ByteBuf out = ctx.alloc().directBuffer(Quic.MAX_DATAGRAM_SIZE);
                 int outWriterIndex = out.writerIndex();
@@ -142,6 +336,8 @@ final class QuicheQuicServerCodec extends QuicheQuicCodec {
                     out.release();
                     Quiche.throwIfError(written);
                 } else {
+                    metrics.retry();
+                    metrics.packetsWritten(1, written);
                     ctx.writeAndFlush(new DatagramPacket(out.writerIndex(outWriterIndex + written), sender));
                 }
                 return null;
@@ -153,33 +349,141 @@ final class QuicheQuicServerCodec extends QuicheQuicCodec {
                 if (LOGGER.isDebugEnabled()) {
                     LOGGER.debug("invalid token: {}", token.toString(CharsetUtil.US_ASCII));
                 }
+                metrics.packetDropped();
                 return null;
             }
         }
 
-        final long conn;
+        final ByteBuf connId;
         if (noToken) {
-            conn = Quiche.quiche_accept_no_token(
-                    Quiche.memoryAddress(dcid) + dcid.readerIndex(), MAX_LOCAL_CONN_ID, nativeConfig);
+            // The connection id of the client may be shorter than ours and does not encode anything we need to route
+            // the packets of the connection, so choose our own just like we do for a Retry.
+            connId = QuicheScratchBuffers.get().connId(MAX_LOCAL_CONN_ID);
+            connId.writeBytes(newConnectionId(dcid));
         } else {
-            conn = Quiche.quiche_accept(Quiche.memoryAddress(dcid) + dcid.readerIndex(), MAX_LOCAL_CONN_ID,
-                    Quiche.memoryAddress(token) + offset, token.readableBytes() - offset, nativeConfig);
+            // The client uses the connection id we chose when we sent the Retry.
+            connId = dcid;
+        }
+
+        final long conn;
+        // The connection does not need the config anymore once it was created.
+        QuicheNativeConfig nativeConfig = config.acquireNativeConfig(config.windowTier(sender));
+        try {
+            if (noToken) {
+                conn = Quiche.quiche_accept_no_token(Quiche.memoryAddress(connId) + connId.readerIndex(),
+                        connId.readableBytes(), nativeConfig.address());
+            } else {
+                conn = Quiche.quiche_accept(Quiche.memoryAddress(connId) + connId.readerIndex(),
+                        connId.readableBytes(), Quiche.memoryAddress(token) + offset, token.readableBytes() - offset,
+                        nativeConfig.address());
+            }
+        } finally {
+            nativeConfig.release();
         }
         if (conn < 0) {
             LOGGER.debug("quiche_accept failed");
+            metrics.packetDropped();
             return null;
         }
 
         // Now create the key to store the channel in the map.
-        byte[] key = new byte[MAX_LOCAL_CONN_ID];
-        dcid.getBytes(dcid.readerIndex(), key);
+        byte[] key = new byte[connId.readableBytes()];
+        connId.getBytes(connId.readerIndex(), key);
 
         QuicheQuicChannel channel = QuicheQuicChannel.forServer(
-                ctx.channel(), ByteBuffer.wrap(key), conn, Quiche.traceId(conn, dcid), sender,
-                streamHandler, streamOptionsArray, streamAttrsArray);
-        Quic.setupChannel(channel, optionsArray, attrsArray, handler, LOGGER);
+                ctx.channel(), ByteBuffer.wrap(key), conn, Quiche.traceId(conn, connId), sender,
+                segmentedDatagramPacketAllocator, streamHandler, streamOptionsArray, streamAttrsArray);
+        if (noToken) {
+            // The client keeps using its own connection id until it received our first packet, so retransmitted
+            // Initial and 0-RTT packets need to find the connection as well.
+            byte[] originalKey = new byte[dcid.readableBytes()];
+            dcid.getBytes(dcid.readerIndex(), originalKey);
+            channel.originalKey(ByteBuffer.wrap(originalKey));
+        }
+        if (handOff == null) {
+            Quic.setupChannel(channel, optionsArray, attrsArray, handler, LOGGER);
+        } else {
+            // The channel is only set up once we know that no worker will take over the connection.
+            channel.handOff(handOff);
+        }
         putChannel(channel);
+        metrics.connectionAccepted();
         ctx.channel().eventLoop().register(channel);
         return channel;
     }
+
+    // Create the connection id for a new connection from the destination connection id the client chose.
+    private ByteBuffer newConnectionId(ByteBuf dcid) {
+        ByteBuffer input = dcid.internalNioBuffer(dcid.readerIndex(), dcid.readableBytes());
+        if (handOff != null) {
+            // Choose the worker that takes over the connection now, so every shard can route the packets of the
+            // connection to it without asking us.
+            int worker = shards.nextWorker();
+            return ((ShardedQuicConnectionIdGenerator) connectionIdAddressGenerator).newId(
+                    input, MAX_LOCAL_CONN_ID, worker == -1 ? shardId : worker);
+        }
+        return connectionIdAddressGenerator.newId(input, MAX_LOCAL_CONN_ID);
+    }
+
+    // Called on the handshake shard once the handshake of the connection is complete.
+    private boolean handOffConnection(QuicheQuicChannel channel) {
+        int workerId = ShardedQuicConnectionIdGenerator.shardOf(channel.key(), shards.numShards());
+        QuicheQuicServerCodec worker = workerId == shardId ? null : shards.get(workerId);
+        if (worker == null || !worker.adoptConnection(channel)) {
+            // The worker that was chosen for the connection is not able to take it over, serve it ourselves.
+            Quic.setupChannel(channel, optionsArray, attrsArray, handler, LOGGER);
+            return false;
+        }
+        // All shards route the packets of the connection to the worker from now on.
+        removeChannel(channel);
+        return true;
+    }
+
+    // Called on the handshake shard, the connection is adopted on the event loop of this worker shard.
+    private boolean adoptConnection(QuicheQuicChannel handshakeChannel) {
+        if (ctx == null) {
+            return false;
+        }
+        ByteBuffer key = handshakeChannel.key();
+        String traceId = handshakeChannel.traceId();
+        InetSocketAddress remote = (InetSocketAddress) handshakeChannel.remoteAddress0();
+        long handshakeDurationNanos = handshakeChannel.handshakeDurationNanos();
+        long conn = handshakeChannel.detachConnection();
+        if (!addForwarded(new AdoptedConnection(key, conn, traceId, remote, handshakeDurationNanos))) {
+            // The codec was removed in the meantime, there is nothing we can do for the connection anymore.
+            Quiche.quiche_conn_free(conn);
+        }
+        return true;
+    }
+
+    private void adoptConnection0(ChannelHandlerContext ctx, AdoptedConnection adopted) {
+        QuicheQuicChannel channel = QuicheQuicChannel.forServer(
+                ctx.channel(), adopted.key, adopted.conn, adopted.traceId, adopted.remote,
+                segmentedDatagramPacketAllocator, streamHandler, streamOptionsArray, streamAttrsArray);
+        Quic.setupChannel(channel, optionsArray, attrsArray, handler, LOGGER);
+        putChannel(channel);
+        // We are on the event loop so the channel is registered once this returns.
+        ctx.channel().eventLoop().register(channel);
+        channel.handOffComplete(adopted.handshakeDurationNanos);
+    }
+
+    /**
+     * A connection that was handed off by a handshake shard and is waiting to be adopted by this worker shard.
+     */
+    private static final class AdoptedConnection {
+        final ByteBuffer key;
+        final long conn;
+        final String traceId;
+        final InetSocketAddress remote;
+        final long handshakeDurationNanos;
+
+        AdoptedConnection(ByteBuffer key, long conn, String traceId, InetSocketAddress remote,
+                          long handshakeDurationNanos) {
+            this.key = key;
+            this.conn = conn;
+            this.traceId = traceId;
+            this.remote = remote;
+            this.handshakeDurationNanos = handshakeDurationNanos;
+        }
+    }
 }
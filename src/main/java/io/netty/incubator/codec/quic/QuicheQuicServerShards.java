@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.concurrent.atomic.AtomicReferenceArray;
+
+/**
+ * Holds all the {@link QuicheQuicServerCodec}s that are used by the shards of one QUIC server. Lookups are lock-free
+ * so they can be done from any {@link io.netty.channel.EventLoop}.
+ *
+ * The first {@link #numHandshakeShards()} shards (if any) are handshake shards. These do all the handshakes and then
+ * hand off the established connections to the other shards, the workers.
+ */
+final class QuicheQuicServerShards {
+    private final AtomicReferenceArray<QuicheQuicServerCodec> codecs;
+    private final int numHandshakeShards;
+    private final AtomicInteger nextWorker = new AtomicInteger();
+
+    QuicheQuicServerShards(int numShards, int numHandshakeShards) {
+        assert numHandshakeShards >= 0 && numHandshakeShards < numShards;
+        codecs = new AtomicReferenceArray<>(numShards);
+        this.numHandshakeShards = numHandshakeShards;
+    }
+
+    int numShards() {
+        return codecs.length();
+    }
+
+    int numHandshakeShards() {
+        return numHandshakeShards;
+    }
+
+    boolean isHandshakeShard(int shardId) {
+        return shardId < numHandshakeShards;
+    }
+
+    /**
+     * Returns the shard that accepts a new connection whose first packet was received by {@code shardId}. This is
+     * the receiving shard itself, so a connection stays on the socket the kernel chose for it, unless handshake
+     * shards are used and {@code shardId} is a worker.
+     */
+    int acceptingShard(int shardId, ByteBuf connectionId) {
+        if (numHandshakeShards == 0 || isHandshakeShard(shardId)) {
+            return shardId;
+        }
+        // The connection id was chosen by the client, so it is random and spreads the connections.
+        return ShardedQuicConnectionIdGenerator.shardOf(connectionId, numHandshakeShards);
+    }
+
+    /**
+     * Returns the shard that should handle a packet with a connection id that was chosen by one of the shards, but
+     * is not known by {@code shardId}. If this is {@code shardId} itself there is no other shard that knows it.
+     *
+     * Packets of established connections go to the owner of the connection and packets of handshakes go to the
+     * shard that created the connection, so both take one hop. The other of the two shards is only tried if the
+     * first one did not know the connection either, which can only happen while a connection is handed off from the
+     * handshake shard to its worker. A packet is never forwarded more than twice.
+     *
+     * @param shardId the shard that received the packet.
+     * @param connectionId the destination connection id of the packet.
+     * @param longHeader {@code true} if the packet uses a long header, which means it is part of the handshake.
+     * @param initial {@code true} if the packet is an Initial packet, which always belongs to the creator.
+     * @param forwarded {@code true} if the packet was already forwarded to {@code shardId} by another shard.
+     */
+    int route(int shardId, ByteBuf connectionId, boolean longHeader, boolean initial, boolean forwarded) {
+        int owner = ShardedQuicConnectionIdGenerator.shardOf(connectionId, numShards());
+        int creator = numHandshakeShards == 0 ? owner :
+                ShardedQuicConnectionIdGenerator.creatorOf(connectionId, numShards());
+        int first = longHeader ? creator : owner;
+        int second = initial ? creator : longHeader ? owner : creator;
+        if (!forwarded) {
+            return first != shardId ? first : second;
+        }
+        return first == shardId ? second : shardId;
+    }
+
+    /**
+     * Returns the next worker shard in a round-robin fashion or {@code -1} if there is none.
+     */
+    int nextWorker() {
+        int numWorkers = numShards() - numHandshakeShards;
+        for (int i = 0; i < numWorkers; i++) {
+            int worker = numHandshakeShards + Math.abs(nextWorker.getAndIncrement() % numWorkers);
+            if (codecs.get(worker) != null) {
+                return worker;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Returns the {@link QuicheQuicServerCodec} for the given shard or {@code null} if it is not active.
+     */
+    QuicheQuicServerCodec get(int shardId) {
+        return codecs.get(shardId);
+    }
+
+    void register(int shardId, QuicheQuicServerCodec codec) {
+        if (!codecs.compareAndSet(shardId, null, codec)) {
+            throw new IllegalStateException("Shard " + shardId + " is already in use by another channel");
+        }
+    }
+
+    void unregister(int shardId, QuicheQuicServerCodec codec) {
+        codecs.compareAndSet(shardId, codec, null);
+    }
+}
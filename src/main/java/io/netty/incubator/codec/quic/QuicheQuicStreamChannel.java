@@ -29,6 +29,7 @@ import io.netty.channel.RecvByteBufAllocator;
 import io.netty.channel.socket.ChannelInputShutdownEvent;
 import io.netty.channel.socket.ChannelInputShutdownReadComplete;
 import io.netty.channel.socket.ChannelOutputShutdownException;
+import io.netty.util.internal.ObjectUtil;
 import io.netty.util.internal.StringUtil;
 
 import java.net.SocketAddress;
@@ -48,13 +49,16 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
     private boolean inRecv;
     private boolean finReceived;
     private boolean finSent;
+    // The bytes of the outbound buffer that are accounted in the memory budget of the parent.
+    private long queuedBytes;
 
     private volatile boolean active = true;
     private volatile boolean inputShutdown;
     private volatile boolean outputShutdown;
+    private volatile QuicStreamPriority priority;
 
     QuicheQuicStreamChannel(QuicheQuicChannel parent, long streamId) {
-        super(parent);
+        super(parent, new QuicStreamChannelId(parent.id(), streamId));
         config = new DefaultQuicStreamChannelConfig(this);
         this.address = new QuicStreamAddress(streamId);
     }
@@ -84,6 +88,42 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
         return address.streamId();
     }
 
+    @Override
+    public QuicStreamPriority priority() {
+        return priority;
+    }
+
+    @Override
+    public ChannelFuture updatePriority(QuicStreamPriority priority, ChannelPromise promise) {
+        ObjectUtil.checkNotNull(priority, "priority");
+        if (eventLoop().inEventLoop()) {
+            updatePriority0(priority, promise);
+        } else {
+            eventLoop().execute(() -> updatePriority0(priority, promise));
+        }
+        return promise;
+    }
+
+    private void updatePriority0(QuicStreamPriority priority, ChannelPromise promise) {
+        try {
+            parent().streamPriority(streamId(), priority);
+        } catch (Throwable cause) {
+            promise.setFailure(cause);
+            return;
+        }
+        this.priority = priority;
+        promise.setSuccess();
+    }
+
+    /**
+     * Returns the urgency that is used to order this stream against others with pending writes.
+     */
+    int urgencyIndex() {
+        QuicStreamPriority priority = this.priority;
+        // Streams without a priority are scheduled after all others, which is the same as quiche does.
+        return priority == null ? QuicStreamPriority.MAX_URGENCY + 1 : priority.urgency();
+    }
+
     @Override
     public boolean isInputShutdown() {
         return inputShutdown || !isActive();
@@ -137,6 +177,7 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
     public void shutdownOutput0(ChannelPromise channelPromise) {
         outputShutdown = true;
         parent().streamShutdownWrite(streamId(), channelPromise);
+        failPendingWrites();
     }
 
     @Override
@@ -163,6 +204,22 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
         inputShutdown = true;
         outputShutdown = true;
         parent().streamShutdownReadAndWrite(streamId(), channelPromise);
+        failPendingWrites();
+    }
+
+    // The stream never becomes writable again once the output was shutdown, so fail the writes that wait for it.
+    private void failPendingWrites() {
+        if (!flushPending) {
+            return;
+        }
+        flushPending = false;
+        parent().streamHasNoPendingWrites(streamId());
+        ChannelOutboundBuffer outboundBuffer = unsafe().outboundBuffer();
+        if (outboundBuffer != null) {
+            failOutboundBuffer(outboundBuffer, () -> new ChannelOutputShutdownException("Output was shutdown"));
+        }
+        parent().addMemory(-queuedBytes);
+        queuedBytes = 0;
     }
 
     @Override
@@ -198,6 +255,11 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
     @Override
     protected void doClose() throws Exception {
         active = false;
+        parent().addMemory(-queuedBytes);
+        queuedBytes = 0;
+        // The writes were failed by the close already.
+        flushPending = false;
+        parent().streamHasNoPendingWrites(streamId());
         if (!finSent) {
             finSent = true;
             parent().streamClose(streamId());
@@ -229,6 +291,17 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
 
     @Override
     protected void doWrite(ChannelOutboundBuffer channelOutboundBuffer) throws Exception {
+        try {
+            doWrite0(channelOutboundBuffer);
+        } finally {
+            // Account everything that is still queued as quiche had no space left for it.
+            long pending = channelOutboundBuffer.totalPendingWriteBytes();
+            parent().addMemory(pending - queuedBytes);
+            queuedBytes = pending;
+        }
+    }
+
+    private void doWrite0(ChannelOutboundBuffer channelOutboundBuffer) {
         // reset first as streamSendMultiple may notify futures.
         flushPending = false;
         if (finSent) {
@@ -246,7 +319,7 @@ final class QuicheQuicStreamChannel extends AbstractChannel implements QuicStrea
                 .streamSendMultiple(streamId(), alloc(), channelOutboundBuffer);
         switch (result) {
             case NO_SPACE:
-                parent().streamHasPendingWrites(streamId());
+                parent().streamHasPendingWrites(this);
                 flushPending = true;
                 break;
             case DONE:
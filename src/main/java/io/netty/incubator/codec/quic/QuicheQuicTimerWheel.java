@@ -0,0 +1,274 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.EventLoop;
+import io.netty.util.concurrent.ScheduledFuture;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Hierarchical timer wheel that is used for the timeouts of all the {@link QuicheQuicChannel}s that are handled by
+ * the same codec. All operations must be done from the {@link EventLoop} that was used to create the wheel.
+ *
+ * The wheel has two levels: the first one has a bucket per tick for the deadlines in the current block of
+ * {@code WHEEL_SIZE} ticks, the second one a bucket per block for all the deadlines after it. The timeouts of a block
+ * are moved to the first level once the block is entered. {@link Timeout}s are linked into the buckets directly, so
+ * updating a deadline never allocates. Only one task is scheduled on the {@link EventLoop}, which expires all
+ * {@link Timeout}s of the ticks that passed in one go and then re-arms itself for the earliest deadline, so long
+ * timeouts don't wake us up before they are due.
+ */
+final class QuicheQuicTimerWheel {
+    static final long TICK_NANOS = TimeUnit.MILLISECONDS.toNanos(1);
+    private static final int WHEEL_SHIFT = 9;
+    private static final int WHEEL_SIZE = 1 << WHEEL_SHIFT;
+    private static final int WHEEL_MASK = WHEEL_SIZE - 1;
+
+    /**
+     * Entry of the {@link QuicheQuicTimerWheel}.
+     */
+    abstract static class Timeout {
+        private Timeout prev;
+        private Timeout next;
+        private long deadlineTick;
+        private int bucket = -1;
+
+        /**
+         * Returns {@code true} if this {@link Timeout} is currently scheduled.
+         */
+        final boolean isScheduled() {
+            return bucket != -1;
+        }
+
+        /**
+         * Called once the {@link Timeout} expired.
+         */
+        protected abstract void expire();
+    }
+
+    // The buckets of the first level followed by the ones of the second level.
+    private final Timeout[] buckets = new Timeout[2 * WHEEL_SIZE];
+    // One bit per bucket, set if the bucket is not empty.
+    private final long[] nonEmptyBuckets = new long[2 * WHEEL_SIZE / Long.SIZE];
+    private final EventLoop eventLoop;
+    private final long startNanos = System.nanoTime();
+    private final Runnable driver = this::expireTimeouts;
+    private ScheduledFuture<?> driverFuture;
+    private long driverTick = Long.MAX_VALUE;
+    // The last tick for which all timeouts were expired.
+    private long currentTick;
+    private int size;
+
+    QuicheQuicTimerWheel(EventLoop eventLoop) {
+        this.eventLoop = eventLoop;
+    }
+
+    /**
+     * (Re-)schedule the given {@link Timeout} so it expires after {@code delayNanos}. The {@link Timeout} may
+     * expire up to one tick later than requested, but never before.
+     */
+    void schedule(Timeout timeout, long delayNanos) {
+        assert eventLoop.inEventLoop();
+        long elapsed = System.nanoTime() - startNanos;
+        // Round up so we never expire too early.
+        long deadlineTick = Math.max((elapsed + delayNanos + TICK_NANOS - 1) / TICK_NANOS, currentTick + 1);
+        if (timeout.isScheduled()) {
+            if (timeout.deadlineTick == deadlineTick) {
+                return;
+            }
+            unlink(timeout);
+        }
+        link(timeout, deadlineTick);
+        if (deadlineTick < driverTick) {
+            scheduleDriver(deadlineTick, elapsed);
+        }
+    }
+
+    /**
+     * Cancel the given {@link Timeout} if it is scheduled.
+     */
+    void cancel(Timeout timeout) {
+        assert eventLoop.inEventLoop();
+        if (timeout.isScheduled()) {
+            unlink(timeout);
+        }
+        // We don't cancel the driver here. If it runs without anything to do it will just re-arm itself if needed.
+    }
+
+    /**
+     * Cancel all scheduled {@link Timeout}s without expiring them.
+     */
+    void close() {
+        for (int i = 0; i < buckets.length; i++) {
+            for (;;) {
+                Timeout timeout = buckets[i];
+                if (timeout == null) {
+                    break;
+                }
+                unlink(timeout);
+            }
+        }
+        if (driverFuture != null) {
+            driverFuture.cancel(false);
+            driverFuture = null;
+        }
+        driverTick = Long.MAX_VALUE;
+    }
+
+    private void link(Timeout timeout, long deadlineTick) {
+        long block = deadlineTick >>> WHEEL_SHIFT;
+        int bucket = block == currentTick >>> WHEEL_SHIFT ?
+                (int) (deadlineTick & WHEEL_MASK) : WHEEL_SIZE + (int) (block & WHEEL_MASK);
+        Timeout head = buckets[bucket];
+        timeout.prev = null;
+        timeout.next = head;
+        if (head != null) {
+            head.prev = timeout;
+        }
+        buckets[bucket] = timeout;
+        nonEmptyBuckets[bucket >>> 6] |= 1L << bucket;
+        timeout.deadlineTick = deadlineTick;
+        timeout.bucket = bucket;
+        size++;
+    }
+
+    private void unlink(Timeout timeout) {
+        int bucket = timeout.bucket;
+        if (timeout.prev == null) {
+            buckets[bucket] = timeout.next;
+            if (timeout.next == null) {
+                nonEmptyBuckets[bucket >>> 6] &= ~(1L << bucket);
+            }
+        } else {
+            timeout.prev.next = timeout.next;
+        }
+        if (timeout.next != null) {
+            timeout.next.prev = timeout.prev;
+        }
+        timeout.prev = null;
+        timeout.next = null;
+        timeout.bucket = -1;
+        size--;
+    }
+
+    private void scheduleDriver(long tick, long elapsed) {
+        if (driverFuture != null) {
+            driverFuture.cancel(false);
+        }
+        driverTick = tick;
+        driverFuture = eventLoop.schedule(driver, Math.max(0, tick * TICK_NANOS - elapsed), TimeUnit.NANOSECONDS);
+    }
+
+    private void expireTimeouts() {
+        driverFuture = null;
+        driverTick = Long.MAX_VALUE;
+
+        long elapsed = System.nanoTime() - startNanos;
+        long nowTick = elapsed / TICK_NANOS;
+        long ticks = Math.min(nowTick - currentTick, WHEEL_SIZE);
+
+        // Collect all expired timeouts first as expire() may schedule these again.
+        Timeout expired = null;
+        for (long tick = nowTick - ticks + 1; tick <= nowTick; tick++) {
+            Timeout timeout = buckets[(int) (tick & WHEEL_MASK)];
+            while (timeout != null) {
+                Timeout next = timeout.next;
+                if (timeout.deadlineTick <= nowTick) {
+                    unlink(timeout);
+                    timeout.next = expired;
+                    expired = timeout;
+                }
+                timeout = next;
+            }
+        }
+        if (nowTick > currentTick) {
+            long oldBlock = currentTick >>> WHEEL_SHIFT;
+            currentTick = nowTick;
+            long newBlock = nowTick >>> WHEEL_SHIFT;
+            long blocks = Math.min(newBlock - oldBlock, WHEEL_SIZE);
+
+            // Move the timeouts of the blocks we entered to the first level, or expire them if these passed already.
+            // Timeouts that are more than one rotation of the second level away stay where they are.
+            for (long block = newBlock - blocks + 1; block <= newBlock; block++) {
+                Timeout timeout = buckets[WHEEL_SIZE + (int) (block & WHEEL_MASK)];
+                while (timeout != null) {
+                    Timeout next = timeout.next;
+                    if (timeout.deadlineTick >>> WHEEL_SHIFT <= newBlock) {
+                        unlink(timeout);
+                        if (timeout.deadlineTick <= nowTick) {
+                            timeout.next = expired;
+                            expired = timeout;
+                        } else {
+                            link(timeout, timeout.deadlineTick);
+                        }
+                    }
+                    timeout = next;
+                }
+            }
+        }
+
+        while (expired != null) {
+            Timeout next = expired.next;
+            expired.next = null;
+            expired.expire();
+            expired = next;
+        }
+
+        if (size > 0 && driverTick == Long.MAX_VALUE) {
+            scheduleDriver(nextDeadlineTick(), System.nanoTime() - startNanos);
+        }
+    }
+
+    // Returns the earliest deadline of all scheduled timeouts, or the first tick of the next block of the second level
+    // that is not empty if it only contains timeouts that are more than one rotation away.
+    private long nextDeadlineTick() {
+        long block = currentTick >>> WHEEL_SHIFT;
+        // All the timeouts of the first level belong to the current block.
+        int ticksLeftInBlock = (int) (((block + 1) << WHEEL_SHIFT) - currentTick - 1);
+        int distance = nextNonEmptyBucket(0, (int) ((currentTick + 1) & WHEEL_MASK), ticksLeftInBlock);
+        if (distance >= 0) {
+            return currentTick + 1 + distance;
+        }
+        distance = nextNonEmptyBucket(WHEEL_SIZE, (int) ((block + 1) & WHEEL_MASK), WHEEL_SIZE);
+        assert distance >= 0;
+        long nextBlock = block + 1 + distance;
+        long deadlineTick = Long.MAX_VALUE;
+        for (Timeout timeout = buckets[WHEEL_SIZE + (int) (nextBlock & WHEEL_MASK)]; timeout != null;
+             timeout = timeout.next) {
+            if (timeout.deadlineTick >>> WHEEL_SHIFT == nextBlock) {
+                deadlineTick = Math.min(deadlineTick, timeout.deadlineTick);
+            }
+        }
+        return deadlineTick == Long.MAX_VALUE ? nextBlock << WHEEL_SHIFT : deadlineTick;
+    }
+
+    // Returns the distance from start to the first bucket of the level at the given offset that is not empty, looking
+    // at no more than count buckets, or -1 if all of these are empty.
+    private int nextNonEmptyBucket(int offset, int start, int count) {
+        for (int i = 0; i < count; i++) {
+            int bucket = offset + ((start + i) & WHEEL_MASK);
+            long word = nonEmptyBuckets[bucket >>> 6] >>> bucket;
+            if (word == 0) {
+                // Skip to the next word.
+                i += Long.SIZE - 1 - (bucket & (Long.SIZE - 1));
+                continue;
+            }
+            int distance = i + Long.numberOfTrailingZeros(word);
+            return distance < count ? distance : -1;
+        }
+        return -1;
+    }
+}
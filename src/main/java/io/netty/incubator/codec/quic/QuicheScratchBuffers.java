@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.util.concurrent.FastThreadLocal;
+
+/**
+ * Direct scratch buffers that are shared by all the codecs and channels that run on the same thread, which is
+ * usually an {@link io.netty.channel.EventLoop}. Each buffer is only used while processing a single packet or for a
+ * single native call, which can not be re-entered from another codec or channel on the same thread.
+ *
+ * All buffers use the native byte order, see {@link QuicheQuicCodec#allocateNativeOrder(int)}.
+ */
+final class QuicheScratchBuffers {
+
+    private static final FastThreadLocal<QuicheScratchBuffers> BUFFERS = new FastThreadLocal<QuicheScratchBuffers>() {
+        @Override
+        protected QuicheScratchBuffers initialValue() {
+            return new QuicheScratchBuffers();
+        }
+
+        @Override
+        protected void onRemoval(QuicheScratchBuffers buffers) {
+            buffers.release();
+        }
+    };
+
+    private ByteBuf headerInfo;
+    private ByteBuf scid;
+    private ByteBuf dcid;
+    private ByteBuf token;
+    private ByteBuf connId;
+    private ByteBuf mintToken;
+    private ByteBuf fin;
+    private ByteBuf send;
+    private ByteBuf sendLengths;
+    private ByteBuf writableStreams;
+    private ByteBuf streamSendIov;
+    private ByteBuf stats;
+    private ByteBuf datagram;
+
+    private QuicheScratchBuffers() { }
+
+    /**
+     * Returns the {@link QuicheScratchBuffers} of the current thread.
+     */
+    static QuicheScratchBuffers get() {
+        return BUFFERS.get();
+    }
+
+    ByteBuf headerInfo(int capacity) {
+        return headerInfo = ensureCapacity(headerInfo, capacity);
+    }
+
+    ByteBuf scid() {
+        return scid = ensureCapacity(scid, Quiche.QUICHE_MAX_CONN_ID_LEN);
+    }
+
+    ByteBuf dcid() {
+        return dcid = ensureCapacity(dcid, Quiche.QUICHE_MAX_CONN_ID_LEN);
+    }
+
+    ByteBuf token(int capacity) {
+        return token = ensureCapacity(token, capacity);
+    }
+
+    ByteBuf connId(int capacity) {
+        return connId = ensureCapacity(connId, capacity);
+    }
+
+    ByteBuf mintToken(int capacity) {
+        return mintToken = ensureCapacity(mintToken, capacity);
+    }
+
+    ByteBuf fin() {
+        return fin = ensureCapacity(fin, 1);
+    }
+
+    ByteBuf send(int capacity) {
+        return send = ensureCapacity(send, capacity);
+    }
+
+    ByteBuf sendLengths(int capacity) {
+        return sendLengths = ensureCapacity(sendLengths, capacity);
+    }
+
+    ByteBuf writableStreams(int capacity) {
+        return writableStreams = ensureCapacity(writableStreams, capacity);
+    }
+
+    ByteBuf streamSendIov(int capacity) {
+        return streamSendIov = ensureCapacity(streamSendIov, capacity);
+    }
+
+    ByteBuf stats() {
+        return stats = ensureCapacity(stats, Quiche.QUICHE_STATS_LEN);
+    }
+
+    ByteBuf datagram(int capacity) {
+        return datagram = ensureCapacity(datagram, capacity);
+    }
+
+    private static ByteBuf ensureCapacity(ByteBuf buffer, int capacity) {
+        if (buffer == null || buffer.capacity() < capacity) {
+            if (buffer != null) {
+                buffer.release();
+            }
+            buffer = QuicheQuicCodec.allocateNativeOrder(capacity);
+        }
+        return buffer.clear();
+    }
+
+    private void release() {
+        release(headerInfo);
+        release(scid);
+        release(dcid);
+        release(token);
+        release(connId);
+        release(mintToken);
+        release(fin);
+        release(send);
+        release(sendLengths);
+        release(writableStreams);
+        release(streamSendIov);
+        release(stats);
+        release(datagram);
+    }
+
+    private static void release(ByteBuf buffer) {
+        if (buffer != null) {
+            buffer.release();
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.socket.DatagramPacket;
+
+import java.net.InetSocketAddress;
+
+/**
+ * Used to allocate datagram packets that use UDP_SEGMENT (GSO). This allows to send multiple QUIC packets of the
+ * same size to the same remote peer with one syscall.
+ *
+ * Use {@link EpollQuicUtils#newSegmentedAllocator(int)} to obtain an instance that can be used together with the
+ * native epoll transport.
+ */
+public interface SegmentedDatagramPacketAllocator {
+
+    /**
+     * {@link SegmentedDatagramPacketAllocator} which should be used if no UDP_SEGMENT is supported. In this case
+     * each QUIC packet is sent as its own {@link DatagramPacket}.
+     */
+    SegmentedDatagramPacketAllocator NONE = new SegmentedDatagramPacketAllocator() {
+        @Override
+        public int maxNumSegments() {
+            return 0;
+        }
+
+        @Override
+        public DatagramPacket newPacket(ByteBuf buffer, int segmentSize, InetSocketAddress remoteAddress) {
+            throw new UnsupportedOperationException();
+        }
+    };
+
+    /**
+     * The maximum number of segments to use per packet. If this method returns a value {@code < 2} no
+     * segmentation will be used at all.
+     */
+    int maxNumSegments();
+
+    /**
+     * Return a new segmented {@link DatagramPacket}. All segments but the last one have the size of
+     * {@code segmentSize}, the last one may be smaller.
+     *
+     * @param buffer        the {@link ByteBuf} that is used as content.
+     * @param segmentSize   the size of each segment.
+     * @param remoteAddress the remote address to send to.
+     * @return              the packet.
+     */
+    DatagramPacket newPacket(ByteBuf buffer, int segmentSize, InetSocketAddress remoteAddress);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.util.internal.PlatformDependent;
+
+import java.nio.ByteBuffer;
+
+/**
+ * {@link QuicConnectionIdGenerator} that encodes the shard which owns the connection into the first byte of each
+ * connection id it creates and the shard which created it into the second byte, while all other bytes are generated
+ * by the wrapped {@link QuicConnectionIdGenerator}. This allows to find the shard of each packet by only looking at
+ * the destination connection id.
+ *
+ * The two shards only differ for connections that are created by a handshake shard, which chooses the worker that
+ * takes over the connection once the handshake is complete when it creates the connection id.
+ */
+final class ShardedQuicConnectionIdGenerator implements QuicConnectionIdGenerator {
+    // The shard is encoded into one byte.
+    static final int MAX_SHARDS = 256;
+
+    private final QuicConnectionIdGenerator generator;
+    private final int shardId;
+    private final int numShards;
+
+    ShardedQuicConnectionIdGenerator(QuicConnectionIdGenerator generator, int shardId, int numShards) {
+        if (numShards < 1 || numShards > MAX_SHARDS) {
+            throw new IllegalArgumentException("numShards: " + numShards + " (expected: 1-" + MAX_SHARDS + ')');
+        }
+        if (shardId < 0 || shardId >= numShards) {
+            throw new IllegalArgumentException("shardId: " + shardId + " (expected: 0-" + (numShards - 1) + ')');
+        }
+        this.generator = generator;
+        this.shardId = shardId;
+        this.numShards = numShards;
+    }
+
+    /**
+     * Returns the shard that owns the connection with the given connection id.
+     */
+    static int shardOf(ByteBuf connectionId, int numShards) {
+        if (!connectionId.isReadable()) {
+            return 0;
+        }
+        return (connectionId.getByte(connectionId.readerIndex()) & 0xFF) % numShards;
+    }
+
+    static int shardOf(ByteBuffer connectionId, int numShards) {
+        if (!connectionId.hasRemaining()) {
+            return 0;
+        }
+        return (connectionId.get(connectionId.position()) & 0xFF) % numShards;
+    }
+
+    /**
+     * Returns the shard that created the connection with the given connection id.
+     */
+    static int creatorOf(ByteBuf connectionId, int numShards) {
+        if (connectionId.readableBytes() < 2) {
+            return shardOf(connectionId, numShards);
+        }
+        return (connectionId.getByte(connectionId.readerIndex() + 1) & 0xFF) % numShards;
+    }
+
+    @Override
+    public ByteBuffer newId() {
+        return encodeShard(generator.newId(), shardId);
+    }
+
+    @Override
+    public ByteBuffer newId(int length) {
+        return encodeShard(generator.newId(length), shardId);
+    }
+
+    @Override
+    public ByteBuffer newId(ByteBuffer input, int length) {
+        return encodeShard(generator.newId(input, length), shardId);
+    }
+
+    /**
+     * Creates a new connection id like {@link #newId(ByteBuffer, int)}, but for a connection that will be owned by
+     * the given shard.
+     */
+    ByteBuffer newId(ByteBuffer input, int length, int owner) {
+        if (owner < 0 || owner >= numShards) {
+            throw new IllegalArgumentException("owner: " + owner + " (expected: 0-" + (numShards - 1) + ')');
+        }
+        return encodeShard(generator.newId(input, length), owner);
+    }
+
+    @Override
+    public int maxConnectionIdLength() {
+        return generator.maxConnectionIdLength();
+    }
+
+    private ByteBuffer encodeShard(ByteBuffer id, int owner) {
+        if (!id.hasRemaining()) {
+            return id;
+        }
+        // Copy the id as the generator may return a read-only or shared buffer.
+        ByteBuffer copy = ByteBuffer.allocate(id.remaining());
+        copy.put(id.duplicate()).flip();
+
+        copy.put(0, encode(owner));
+        if (copy.remaining() > 1) {
+            copy.put(1, encode(shardId));
+        }
+        return copy;
+    }
+
+    // Keep as much randomness in the byte as possible while still being able to compute the shard.
+    private byte encode(int shard) {
+        int multiplier = PlatformDependent.threadLocalRandom().nextInt((MAX_SHARDS - 1 - shard) / numShards + 1);
+        return (byte) (shard + multiplier * numShards);
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.embedded.EmbeddedChannel;
+import org.junit.Test;
+
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ThreadLocalRandom;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+
+public class ConnectionIdChannelMapTest {
+
+    private static QuicheQuicChannel newChannel() {
+        return QuicheQuicChannel.forClient(new EmbeddedChannel(), null, new ChannelInboundHandlerAdapter(),
+                Quic.optionsArray(Collections.emptyMap()), Quic.attributesArray(Collections.emptyMap()));
+    }
+
+    private static ByteBuffer randomId(int length) {
+        byte[] bytes = new byte[length];
+        ThreadLocalRandom.current().nextBytes(bytes);
+        return ByteBuffer.wrap(bytes);
+    }
+
+    @Test
+    public void testPutGetRemove() {
+        ConnectionIdChannelMap map = new ConnectionIdChannelMap(4);
+        QuicheQuicChannel channel = newChannel();
+        ByteBuffer id = randomId(ConnectionIdChannelMap.MAX_CONNECTION_ID_LENGTH);
+
+        assertNull(map.put(id, channel));
+        assertEquals(1, map.size());
+        assertSame(channel, map.get(id));
+
+        // Lookups via a ByteBuf with a different reader index need to work as well.
+        ByteBuf buffer = Unpooled.directBuffer().writeZero(3).writeBytes(id.duplicate()).skipBytes(3);
+        try {
+            assertSame(channel, map.get(buffer));
+        } finally {
+            buffer.release();
+        }
+
+        assertSame(channel, map.remove(id));
+        assertNull(map.get(id));
+        assertEquals(0, map.size());
+    }
+
+    @Test
+    public void testIdsOfDifferentLengthDoNotCollide() {
+        ConnectionIdChannelMap map = new ConnectionIdChannelMap();
+        QuicheQuicChannel channel = newChannel();
+        QuicheQuicChannel channel2 = newChannel();
+        map.put(ByteBuffer.wrap(new byte[8]), channel);
+        map.put(ByteBuffer.wrap(new byte[9]), channel2);
+        assertSame(channel, map.get(ByteBuffer.wrap(new byte[8])));
+        assertSame(channel2, map.get(ByteBuffer.wrap(new byte[9])));
+        assertNull(map.get(ByteBuffer.wrap(new byte[10])));
+    }
+
+    @Test
+    public void testMultipleIdsPerChannel() {
+        ConnectionIdChannelMap map = new ConnectionIdChannelMap();
+        QuicheQuicChannel channel = newChannel();
+        ByteBuffer id = randomId(8);
+        ByteBuffer id2 = randomId(20);
+        map.put(id, channel);
+        map.put(id2, channel);
+        assertEquals(2, map.size());
+        assertSame(channel, map.get(id));
+        assertSame(channel, map.get(id2));
+
+        map.remove(id);
+        assertNull(map.get(id));
+        assertSame(channel, map.get(id2));
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testIdTooLong() {
+        new ConnectionIdChannelMap().put(
+                randomId(ConnectionIdChannelMap.MAX_CONNECTION_ID_LENGTH + 1), newChannel());
+    }
+
+    @Test
+    public void testRandomOperationsMatchHashMap() {
+        ConnectionIdChannelMap map = new ConnectionIdChannelMap(2);
+        Map<ByteBuffer, QuicheQuicChannel> expected = new HashMap<>();
+        List<ByteBuffer> ids = new ArrayList<>();
+        QuicheQuicChannel[] channels = { newChannel(), newChannel(), newChannel() };
+        ThreadLocalRandom random = ThreadLocalRandom.current();
+
+        for (int i = 0; i < 100000; i++) {
+            if (ids.isEmpty() || random.nextInt(3) != 0) {
+                // Use only a few different ids so we see a lot of collisions and removals within clusters.
+                ByteBuffer id = randomId(1 + random.nextInt(2));
+                QuicheQuicChannel channel = channels[random.nextInt(channels.length)];
+                assertSame(expected.put(id, channel), map.put(id, channel));
+                ids.add(id);
+            } else {
+                ByteBuffer id = ids.remove(random.nextInt(ids.size()));
+                assertSame(expected.remove(id), map.remove(id));
+            }
+            assertEquals(expected.size(), map.size());
+        }
+        for (ByteBuffer id: ids) {
+            assertSame(expected.get(id), map.get(id));
+        }
+        int found = 0;
+        for (int i = 0; i < map.capacity(); i++) {
+            if (map.valueAt(i) != null) {
+                found++;
+            }
+        }
+        assertEquals(expected.size(), found);
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import org.junit.Test;
+
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.net.UnknownHostException;
+import java.util.concurrent.ThreadLocalRandom;
+import java.util.concurrent.TimeUnit;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.lessThanOrEqualTo;
+import static org.junit.Assert.assertEquals;
+
+public class HmacQuicTokenHandlerTest {
+
+    private static byte[] newSecret() {
+        byte[] secret = new byte[32];
+        ThreadLocalRandom.current().nextBytes(secret);
+        return secret;
+    }
+
+    @Test
+    public void testTokenProcessingIpv4() throws Exception {
+        testTokenProcessing(new byte[] { 10, 10, 10, 1 }, new byte[] { 10, 10, 10, 10 });
+    }
+
+    @Test
+    public void testTokenProcessingIpv6() throws Exception {
+        testTokenProcessing(
+                new byte[] { 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 1 },
+                new byte[] { 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10 });
+    }
+
+    private static void testTokenProcessing(byte[] validAddr, byte[] invalidAddr) throws UnknownHostException {
+        HmacQuicTokenHandler handler = new HmacQuicTokenHandler(newSecret());
+        InetSocketAddress validAddress = new InetSocketAddress(InetAddress.getByAddress(validAddr), 9999);
+        ByteBuf dcid = newConnectionId();
+        ByteBuf out = Unpooled.directBuffer(handler.maxTokenLength());
+        try {
+            handler.writeToken(out, dcid, validAddress);
+            assertThat(out.readableBytes(), lessThanOrEqualTo(handler.maxTokenLength()));
+
+            int offset = handler.validateToken(out, validAddress);
+            // The original destination connection id follows the offset.
+            assertEquals(dcid, out.slice(out.readerIndex() + offset, out.readableBytes() - offset));
+
+            // Another address, port or secret must fail.
+            assertEquals(-1, handler.validateToken(out,
+                    new InetSocketAddress(InetAddress.getByAddress(invalidAddr), 9999)));
+            assertEquals(-1, handler.validateToken(out,
+                    new InetSocketAddress(InetAddress.getByAddress(validAddr), 9998)));
+            assertEquals(-1, new HmacQuicTokenHandler(newSecret()).validateToken(out, validAddress));
+        } finally {
+            dcid.release();
+            out.release();
+        }
+    }
+
+    @Test
+    public void testTamperedTokenIsRejected() {
+        HmacQuicTokenHandler handler = new HmacQuicTokenHandler(newSecret());
+        InetSocketAddress address = new InetSocketAddress(9999);
+        ByteBuf dcid = newConnectionId();
+        ByteBuf out = Unpooled.buffer();
+        try {
+            handler.writeToken(out, dcid, address);
+            for (int i = 0; i < out.readableBytes(); i++) {
+                ByteBuf copy = out.copy();
+                copy.setByte(i, copy.getByte(i) ^ 1);
+                assertEquals(-1, handler.validateToken(copy, address));
+                copy.release();
+            }
+            assertEquals(-1, handler.validateToken(out.slice(0, out.readableBytes() - 1), address));
+        } finally {
+            dcid.release();
+            out.release();
+        }
+    }
+
+    @Test
+    public void testExpiredTokenIsRejected() throws Exception {
+        HmacQuicTokenHandler handler = new HmacQuicTokenHandler(newSecret(), 1, 60000, TimeUnit.MILLISECONDS);
+        InetSocketAddress address = new InetSocketAddress(9999);
+        ByteBuf dcid = newConnectionId();
+        ByteBuf out = Unpooled.buffer();
+        try {
+            handler.writeToken(out, dcid, address);
+            Thread.sleep(10);
+            assertEquals(-1, handler.validateToken(out, address));
+        } finally {
+            dcid.release();
+            out.release();
+        }
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testKeyRotationIntervalMustCoverLifetime() {
+        new HmacQuicTokenHandler(newSecret(), 10, 5, TimeUnit.SECONDS);
+    }
+
+    private static ByteBuf newConnectionId() {
+        byte[] bytes = new byte[Quiche.QUICHE_MAX_CONN_ID_LEN];
+        ThreadLocalRandom.current().nextBytes(bytes);
+        return Unpooled.wrappedBuffer(bytes);
+    }
+}
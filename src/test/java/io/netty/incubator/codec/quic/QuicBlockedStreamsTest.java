@@ -0,0 +1,146 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelFuture;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.ChannelOption;
+import io.netty.channel.socket.ChannelOutputShutdownException;
+import io.netty.util.concurrent.Future;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.instanceOf;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+public class QuicBlockedStreamsTest {
+    @Test
+    public void testManyConcurrentlyBlockedStreams() throws Throwable {
+        int numStreams = 10000;
+        int bytesPerStream = 4096;
+        long bytes = (long) numStreams * bytesPerStream;
+        Promise<Void> received = ImmediateEventExecutor.INSTANCE.newPromise();
+        Channel server = QuicTestUtils.newServer(QuicTestUtils.newQuicServerBuilder()
+                        .initialMaxStreamsBidirectional(numStreams)
+                        // Use a small window so all the streams are blocked by the stream level flow control.
+                        .initialMaxStreamDataBidirectionalRemote(bytesPerStream / 4),
+                InsecureQuicTokenHandler.INSTANCE, null, new ChannelInboundHandlerAdapter() {
+                    private long receivedBytes;
+
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        ByteBuf buffer = (ByteBuf) msg;
+                        receivedBytes += buffer.readableBytes();
+                        buffer.release();
+                        if (receivedBytes == bytes) {
+                            received.trySuccess(null);
+                        }
+                    }
+
+                    @Override
+                    public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+                        received.tryFailure(cause);
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                });
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+
+            List<Future<QuicStreamChannel>> futures = new ArrayList<>(numStreams);
+            for (int i = 0; i < numStreams; i++) {
+                futures.add(quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                        new ChannelInboundHandlerAdapter()));
+            }
+            List<QuicStreamChannel> streams = new ArrayList<>(numStreams);
+            for (Future<QuicStreamChannel> future: futures) {
+                streams.add(future.sync().getNow());
+            }
+
+            for (QuicStreamChannel stream: streams) {
+                stream.writeAndFlush(Unpooled.directBuffer(bytesPerStream).writeZero(bytesPerStream));
+            }
+            // All streams need to make progress again once the server opened their windows.
+            received.sync();
+
+            quicChannel.close().sync();
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+
+    @Test
+    public void testShutdownOutputFailsBlockedWrites() throws Throwable {
+        int bytes = 4096;
+        Channel server = QuicTestUtils.newServer(QuicTestUtils.newQuicServerBuilder()
+                        // Never read from the streams, so the window is not opened again.
+                        .streamOption(ChannelOption.AUTO_READ, false)
+                        .initialMaxStreamDataBidirectionalRemote(bytes / 4),
+                InsecureQuicTokenHandler.INSTANCE, null, new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                });
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            QuicStreamChannel stream = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                    new ChannelInboundHandlerAdapter()).sync().getNow();
+
+            ChannelFuture write = stream.writeAndFlush(Unpooled.directBuffer(bytes).writeZero(bytes));
+            assertFalse(write.await(100, TimeUnit.MILLISECONDS));
+            stream.shutdownOutput().sync();
+
+            // The stream is never reported as writable again, so the blocked write must not wait forever.
+            assertTrue(write.await(5, TimeUnit.SECONDS));
+            assertThat(write.cause(), instanceOf(ChannelOutputShutdownException.class));
+
+            quicChannel.close().sync();
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+}
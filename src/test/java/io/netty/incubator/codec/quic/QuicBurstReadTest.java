@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.bootstrap.Bootstrap;
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.ChannelInitializer;
+import io.netty.channel.EventLoopGroup;
+import io.netty.channel.nio.NioEventLoopGroup;
+import io.netty.channel.socket.DatagramPacket;
+import io.netty.channel.socket.nio.NioDatagramChannel;
+import io.netty.util.NetUtil;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Test;
+
+import java.net.InetSocketAddress;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.Assert.assertTrue;
+
+public class QuicBurstReadTest {
+
+    @Test
+    public void testHeapBuffersInBurst() throws Throwable {
+        AtomicInteger packets = new AtomicInteger();
+        testBurst(new BurstHandler(packets));
+        assertTrue(packets.get() > 0);
+    }
+
+    private static void testBurst(ChannelHandler burstHandler) throws Throwable {
+        int bytes = 1024 * 1024;
+        EventLoopGroup group = new NioEventLoopGroup(1);
+        Promise<Void> received = ImmediateEventExecutor.INSTANCE.newPromise();
+        ChannelHandler codec = QuicTestUtils.newQuicServerBuilder()
+                .tokenHandler(InsecureQuicTokenHandler.INSTANCE)
+                .handler(new ChannelInboundHandlerAdapter())
+                .streamHandler(new ChannelInboundHandlerAdapter() {
+                    private int receivedBytes;
+
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        ByteBuf buffer = (ByteBuf) msg;
+                        receivedBytes += buffer.readableBytes();
+                        buffer.release();
+                        if (receivedBytes == bytes) {
+                            received.trySuccess(null);
+                        }
+                    }
+
+                    @Override
+                    public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+                        received.tryFailure(cause);
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                }).build();
+        Channel server = new Bootstrap().group(group)
+                .channel(NioDatagramChannel.class)
+                .handler(new ChannelInitializer<Channel>() {
+                    @Override
+                    protected void initChannel(Channel ch) {
+                        ch.pipeline().addLast(burstHandler, codec);
+                    }
+                })
+                .bind(new InetSocketAddress(NetUtil.LOCALHOST4, 0)).sync().channel();
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            QuicStreamChannel stream = quicChannel.createStream(
+                    QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter()).sync().getNow();
+            stream.writeAndFlush(Unpooled.directBuffer(bytes).writeZero(bytes));
+            received.sync();
+
+            stream.close().sync();
+            quicChannel.close().sync();
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+            group.shutdownGracefully();
+        }
+    }
+
+    /**
+     * Holds back all packets of one read and forwards them as heap buffers once the read is complete.
+     */
+    @ChannelHandler.Sharable
+    private static final class BurstHandler extends ChannelInboundHandlerAdapter {
+        private final List<DatagramPacket> packets = new ArrayList<>();
+        private final AtomicInteger forwarded;
+
+        BurstHandler(AtomicInteger forwarded) {
+            this.forwarded = forwarded;
+        }
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            packets.add((DatagramPacket) msg);
+        }
+
+        @Override
+        public void channelReadComplete(ChannelHandlerContext ctx) {
+            for (DatagramPacket packet: packets) {
+                ByteBuf heap = Unpooled.buffer().writeBytes(packet.content());
+                ctx.fireChannelRead(new DatagramPacket(heap, packet.recipient(), packet.sender()));
+                packet.release();
+                forwarded.incrementAndGet();
+            }
+            packets.clear();
+            ctx.fireChannelReadComplete();
+        }
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import org.junit.Test;
+
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.Base64;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotSame;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+import static org.junit.Assert.fail;
+
+public class QuicCertificateProviderTest {
+
+    private static byte[] readPem(String path) throws Exception {
+        return Files.readAllBytes(Paths.get(path));
+    }
+
+    private static byte[] pemToDer(byte[] pem) {
+        String base64 = new String(pem, StandardCharsets.US_ASCII)
+                .replaceAll("-----[A-Z ]+-----", "").replaceAll("\\s", "");
+        return Base64.getDecoder().decode(base64);
+    }
+
+    @Test
+    public void testCertificateCanBeUpdated() throws Throwable {
+        byte[] certPem = readPem("./src/test/resources/cert.crt");
+        byte[] keyPem = readPem("./src/test/resources/cert.key");
+        QuicCertificateProvider provider = QuicCertificateProvider.fromPem(certPem, keyPem);
+        Channel server = QuicTestUtils.newServer(QuicTestUtils.newQuicServerBuilder()
+                        .certificateChain(null).privateKey(null).certificateProvider(provider),
+                InsecureQuicTokenHandler.INSTANCE, null, new ChannelInboundHandlerAdapter());
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            connect(channel, server);
+            assertEquals(0, provider.generation());
+
+            // Swap in the same certificate in DER format, new connections must use the new config.
+            provider.updateDer(pemToDer(keyPem), pemToDer(certPem));
+            assertEquals(1, provider.generation());
+            connect(channel, server);
+
+            provider.update(certPem, keyPem);
+            connect(channel, server);
+        } finally {
+            QuicTestUtils.closeIfNotNull(channel);
+            QuicTestUtils.closeIfNotNull(server);
+        }
+    }
+
+    @Test
+    public void testUpdateRebuildsNativeConfigs() throws Exception {
+        byte[] certPem = readPem("./src/test/resources/cert.crt");
+        byte[] keyPem = readPem("./src/test/resources/cert.key");
+        QuicCertificateProvider provider = QuicCertificateProvider.fromPem(certPem, keyPem);
+        QuicheConfig config = QuicTestUtils.newQuicServerBuilder()
+                .certificateChain(null).privateKey(null).certificateProvider(provider).createConfig();
+        config.attach();
+        try {
+            QuicheNativeConfig before = config.acquireNativeConfig();
+            before.release();
+
+            provider.update(certPem, keyPem);
+            // The native config was replaced by the thread that called update(...), not by the next connection.
+            assertFalse(before.tryRetain());
+            QuicheNativeConfig after = config.acquireNativeConfig();
+            assertNotSame(before, after);
+            after.release();
+
+            try {
+                provider.update(certPem, "invalid".getBytes(StandardCharsets.US_ASCII));
+                fail();
+            } catch (IllegalArgumentException expected) {
+                // expected
+            }
+            // The previous certificate is still used.
+            assertEquals(1, provider.generation());
+            QuicheNativeConfig current = config.acquireNativeConfig();
+            assertSame(after, current);
+            current.release();
+        } finally {
+            config.detach();
+        }
+    }
+
+    @Test
+    public void testNativeConfigIsSharedAndReleased() {
+        QuicheConfig config = QuicTestUtils.newQuicServerBuilder().createConfig();
+        config.attach();
+        config.attach();
+        QuicheNativeConfig nativeConfig = config.acquireNativeConfig();
+        nativeConfig.release();
+        // Both codecs use the same native config.
+        QuicheNativeConfig other = config.acquireNativeConfig();
+        assertEquals(nativeConfig, other);
+        other.release();
+
+        config.detach();
+        assertTrue(nativeConfig.tryRetain());
+        nativeConfig.release();
+        config.detach();
+        // The last codec is gone, so the config was freed.
+        assertFalse(nativeConfig.tryRetain());
+    }
+
+    private static void connect(Channel channel, Channel server) throws Exception {
+        QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                .handler(new ChannelInboundHandlerAdapter())
+                .streamHandler(new ChannelInboundHandlerAdapter())
+                .remoteAddress(server.localAddress())
+                .connect()
+                .get();
+        quicChannel.close().sync();
+    }
+}
@@ -15,6 +15,7 @@
  */
 package io.netty.incubator.codec.quic;
 
+import io.netty.buffer.Unpooled;
 import org.junit.Test;
 
 import java.nio.ByteBuffer;
@@ -62,4 +63,38 @@ public class QuicConnectionIdGeneratorTest {
         QuicConnectionIdGenerator idGenerator = QuicConnectionIdGenerator.randomGenerator();
         idGenerator.newId(ByteBuffer.wrap(new byte[8]), Integer.MAX_VALUE);
     }
+
+    @Test
+    public void testShardedGeneratorEncodesShard() {
+        for (int numShards: new int[] { 1, 3, 4, 7, 256 }) {
+            for (int shardId = 0; shardId < numShards; shardId++) {
+                QuicConnectionIdGenerator idGenerator = new ShardedQuicConnectionIdGenerator(
+                        QuicConnectionIdGenerator.randomGenerator(), shardId, numShards);
+                for (int i = 0; i < 16; i++) {
+                    ByteBuffer id = idGenerator.newId(10);
+                    assertEquals(10, id.remaining());
+                    assertEquals(shardId, ShardedQuicConnectionIdGenerator.shardOf(
+                            Unpooled.wrappedBuffer(id), numShards));
+                }
+            }
+        }
+    }
+
+    @Test
+    public void testShardedGeneratorEncodesOwnerAndCreator() {
+        ShardedQuicConnectionIdGenerator idGenerator = new ShardedQuicConnectionIdGenerator(
+                QuicConnectionIdGenerator.randomGenerator(), 1, 5);
+        for (int owner = 0; owner < 5; owner++) {
+            ByteBuffer id = idGenerator.newId(ByteBuffer.wrap(new byte[8]), 20, owner);
+            assertEquals(20, id.remaining());
+            assertEquals(owner, ShardedQuicConnectionIdGenerator.shardOf(id, 5));
+            assertEquals(owner, ShardedQuicConnectionIdGenerator.shardOf(Unpooled.wrappedBuffer(id), 5));
+            assertEquals(1, ShardedQuicConnectionIdGenerator.creatorOf(Unpooled.wrappedBuffer(id), 5));
+        }
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testShardedGeneratorThrowsIfShardIdTooBig() {
+        new ShardedQuicConnectionIdGenerator(QuicConnectionIdGenerator.randomGenerator(), 4, 4);
+    }
 }
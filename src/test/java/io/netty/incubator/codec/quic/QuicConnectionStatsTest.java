@@ -32,6 +32,7 @@ import static org.hamcrest.Matchers.greaterThan;
 import static org.hamcrest.Matchers.greaterThanOrEqualTo;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertSame;
 
 public class QuicConnectionStatsTest {
 
@@ -87,6 +88,14 @@ public class QuicConnectionStatsTest {
                     .remoteAddress(server.localAddress())
                     .connect().get();
             assertNotNull(quicChannel.collectStats().sync().getNow());
+
+            // The same instance can be filled multiple times.
+            MutableQuicConnectionStats stats = new MutableQuicConnectionStats();
+            assertSame(stats, quicChannel.collectStats(stats, quicChannel.eventLoop().newPromise()).sync().getNow());
+            long sent = stats.sent();
+            assertSame(stats, quicChannel.collectStats(stats, quicChannel.eventLoop().newPromise()).sync().getNow());
+            assertThat(stats.sent(), greaterThanOrEqualTo(sent));
+            assertThat(stats.handshakeDurationNanos(), greaterThan(0L));
             quicChannel.createStream(QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter() {
                 private final int bufferSize = 8;
                 private int received;
@@ -122,6 +131,94 @@ public class QuicConnectionStatsTest {
         }
     }
 
+    @Test
+    public void testCodecMetricsAreCollected() throws Throwable {
+        TestMetricsCollector serverCollector = new TestMetricsCollector();
+        TestMetricsCollector clientCollector = new TestMetricsCollector();
+        Channel server = QuicTestUtils.newServer(QuicTestUtils.newQuicServerBuilder().metricsCollector(serverCollector),
+                InsecureQuicTokenHandler.INSTANCE, null, new ChannelInboundHandlerAdapter());
+        Channel channel = QuicTestUtils.newClient(QuicTestUtils.newQuicClientBuilder()
+                .metricsCollector(clientCollector));
+        try {
+            QuicCodecMetrics serverMetrics = serverCollector.metrics;
+            QuicCodecMetrics clientMetrics = clientCollector.metrics;
+            assertNotNull(serverMetrics);
+            assertNotNull(clientMetrics);
+
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect().get();
+            quicChannel.close().sync();
+
+            assertEquals(1, serverMetrics.acceptedConnections());
+            // InsecureQuicTokenHandler will always do a retry first.
+            assertEquals(1, serverMetrics.retries());
+            assertEquals(0, serverMetrics.versionNegotiations());
+            assertThat(serverMetrics.packetsRead(), greaterThan(0L));
+            assertThat(serverMetrics.bytesRead(), greaterThan(0L));
+            assertThat(serverMetrics.packetsWritten(), greaterThan(0L));
+            assertThat(clientMetrics.packetsWritten(), greaterThan(0L));
+            assertThat(clientMetrics.bytesWritten(), greaterThan(0L));
+            assertThat(clientMetrics.packetsRead(), greaterThan(0L));
+        } finally {
+            QuicTestUtils.closeIfNotNull(channel);
+            QuicTestUtils.closeIfNotNull(server);
+        }
+    }
+
+    @Test
+    public void testAdaptiveRetryIsOnlySentUnderLoad() throws Throwable {
+        testRetries(QuicTestUtils.newQuicServerBuilder().adaptiveRetry(1000, 100), 0);
+        // With at most one new connection per second the second connection has to do a retry.
+        testRetries(QuicTestUtils.newQuicServerBuilder().adaptiveRetry(1, 100), 1);
+    }
+
+    private static void testRetries(QuicServerCodecBuilder builder, long expectedRetries) throws Throwable {
+        TestMetricsCollector serverCollector = new TestMetricsCollector();
+        HmacQuicTokenHandler tokenHandler = new HmacQuicTokenHandler(new byte[] { 1, 2, 3, 4 });
+        Channel server = QuicTestUtils.newServer(builder.metricsCollector(serverCollector),
+                tokenHandler, null, new ChannelInboundHandlerAdapter());
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel first = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect().get();
+            QuicChannel second = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect().get();
+            first.close().sync();
+            second.close().sync();
+
+            QuicCodecMetrics serverMetrics = serverCollector.metrics;
+            assertEquals(2, serverMetrics.acceptedConnections());
+            assertEquals(expectedRetries, serverMetrics.retries());
+        } finally {
+            QuicTestUtils.closeIfNotNull(channel);
+            QuicTestUtils.closeIfNotNull(server);
+        }
+    }
+
+    private static final class TestMetricsCollector implements QuicMetricsCollector {
+        volatile QuicCodecMetrics metrics;
+
+        @Override
+        public void register(QuicCodecMetrics metrics) {
+            this.metrics = metrics;
+        }
+
+        @Override
+        public void unregister(QuicCodecMetrics metrics) {
+            assertSame(this.metrics, metrics);
+            this.metrics = null;
+        }
+    }
+
     private static void assertStats(QuicConnectionStats stats) {
         assertThat(stats.congestionWindow(), greaterThan(0L));
         assertThat(stats.deliveryRate(), greaterThan(0L));
@@ -129,5 +226,8 @@ public class QuicConnectionStatsTest {
         assertThat(stats.recv(), greaterThan(0L));
         assertThat(stats.rttNanos(), greaterThan(0L));
         assertThat(stats.sent(), greaterThan(0L));
+        assertThat(stats.handshakeDurationNanos(), greaterThan(0L));
+        assertThat(stats.totalStreams(), greaterThan(0L));
+        assertThat(stats.activeStreams(), greaterThanOrEqualTo(0));
     }
 }
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.CharsetUtil;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.fail;
+
+public class QuicDatagramTest {
+
+    @Test
+    public void testDatagramEcho() throws Throwable {
+        Channel server = QuicTestUtils.newServer(QuicTestUtils.newQuicServerBuilder().datagram(10, 10),
+                InsecureQuicTokenHandler.INSTANCE, new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        if (msg instanceof ByteBuf) {
+                            // Echo the DATAGRAM back.
+                            ctx.writeAndFlush(msg);
+                        } else {
+                            ctx.fireChannelRead(msg);
+                        }
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                }, new ChannelInboundHandlerAdapter());
+        Channel channel = QuicTestUtils.newClient(QuicTestUtils.newQuicClientBuilder().datagram(10, 10));
+        try {
+            Promise<String> received = ImmediateEventExecutor.INSTANCE.newPromise();
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter() {
+                        @Override
+                        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                            ByteBuf buffer = (ByteBuf) msg;
+                            received.trySuccess(buffer.toString(CharsetUtil.US_ASCII));
+                            buffer.release();
+                        }
+                    })
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            // Use a heap buffer which needs to be copied to direct memory before it is passed to quiche.
+            quicChannel.writeAndFlush(Unpooled.copiedBuffer("datagram", CharsetUtil.US_ASCII)).sync();
+            assertEquals("datagram", received.sync().getNow());
+
+            quicChannel.close().sync();
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+
+    @Test
+    public void testWriteFailsIfNotEnabled() throws Throwable {
+        Channel server = QuicTestUtils.newServer(null, new ChannelInboundHandlerAdapter());
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            ByteBuf buffer = Unpooled.directBuffer().writeLong(1);
+            try {
+                quicChannel.writeAndFlush(buffer).sync();
+                fail();
+            } catch (UnsupportedOperationException expected) {
+                // expected
+            }
+            assertEquals(0, buffer.refCnt());
+
+            quicChannel.close().sync();
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.NetUtil;
+import org.junit.Test;
+
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+
+public class QuicFlowControlAutotuningTest {
+
+    private static final InetSocketAddress PEER = new InetSocketAddress(NetUtil.LOCALHOST4, 9999);
+
+    @Test
+    public void testDisabledByDefault() {
+        QuicheConfig config = QuicTestUtils.newQuicServerBuilder().createConfig();
+        assertNull(config.bdpHistory());
+        assertEquals(0, config.windowTier(PEER));
+    }
+
+    @Test
+    public void testTierFollowsBdpOfPeer() throws Exception {
+        QuicheConfig config = QuicTestUtils.newQuicServerBuilder()
+                .initialMaxData(1000000)
+                .flowControlAutotuning(16000000, 1600000)
+                .createConfig();
+        QuicheQuicBdpHistory history = config.bdpHistory();
+        assertNotNull(history);
+        assertEquals(0, config.windowTier(PEER));
+
+        // Fits into half of the initial window.
+        history.record(PEER.getAddress(), 500000);
+        assertEquals(0, config.windowTier(PEER));
+
+        // The connection was limited by the initial window, so the next one gets four times the window.
+        history.record(PEER.getAddress(), 1000000);
+        assertEquals(1, config.windowTier(PEER));
+
+        // Never more than the tier that reaches the limits.
+        history.record(PEER.getAddress(), 100000000);
+        assertEquals(2, config.windowTier(PEER));
+
+        // Other peers still start with the initial windows.
+        assertEquals(0, config.windowTier(new InetSocketAddress(
+                InetAddress.getByAddress(new byte[] { 10, 0, 0, 1 }), 9999)));
+    }
+
+    @Test
+    public void testNativeConfigPerTier() {
+        QuicheConfig config = QuicTestUtils.newQuicServerBuilder()
+                .initialMaxData(1000000)
+                .flowControlAutotuning(16000000, 1600000)
+                .createConfig();
+        config.attach();
+        QuicheNativeConfig initial = config.acquireNativeConfig(0);
+        QuicheNativeConfig tuned = config.acquireNativeConfig(2);
+        assertNotEquals(initial, tuned);
+        // The native config of a tier is created once and then shared.
+        QuicheNativeConfig other = config.acquireNativeConfig(2);
+        assertEquals(tuned, other);
+        initial.release();
+        tuned.release();
+        other.release();
+
+        config.detach();
+        // The last codec is gone, so the configs of all tiers were freed.
+        assertFalse(initial.tryRetain());
+        assertFalse(tuned.tryRetain());
+    }
+}
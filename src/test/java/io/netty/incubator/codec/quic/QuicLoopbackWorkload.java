@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.ReferenceCountUtil;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import io.netty.util.internal.SystemPropertyUtil;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * Loopback workload that is used to train the {@code optimized} native build when doing profile-guided
+ * optimization (see {@code scripts/build-optimized-native.sh}). It is not part of the normal test run and needs to
+ * be selected explicitly via {@code -Dtest=QuicLoopbackWorkload}.
+ *
+ * The mix of handshakes, small and large stream writes is meant to exercise the same quiche code paths that are hot
+ * in production: packet protection, stream framing, ACK processing and congestion control.
+ */
+public class QuicLoopbackWorkload {
+
+    private static final int CONNECTIONS = SystemPropertyUtil.getInt(
+            "io.netty.incubator.codec.quic.workload.connections", 32);
+    private static final int STREAMS = SystemPropertyUtil.getInt(
+            "io.netty.incubator.codec.quic.workload.streams", 16);
+    private static final int BYTES_PER_STREAM = SystemPropertyUtil.getInt(
+            "io.netty.incubator.codec.quic.workload.bytesPerStream", 256 * 1024);
+
+    @Test
+    public void run() throws Throwable {
+        byte[] data = new byte[BYTES_PER_STREAM];
+        ThreadLocalRandom.current().nextBytes(data);
+
+        Channel server = QuicTestUtils.newServer(new ChannelInboundHandlerAdapter(), new EchoHandler());
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            for (int i = 0; i < CONNECTIONS; i++) {
+                QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                        .handler(new ChannelInboundHandlerAdapter())
+                        .streamHandler(new ChannelInboundHandlerAdapter())
+                        .remoteAddress(server.localAddress())
+                        .connect()
+                        .get();
+                List<Promise<Void>> echoed = new ArrayList<>(STREAMS);
+                for (int j = 0; j < STREAMS; j++) {
+                    Promise<Void> promise = ImmediateEventExecutor.INSTANCE.newPromise();
+                    QuicStreamChannel stream = quicChannel.createStream(
+                            QuicStreamType.BIDIRECTIONAL, new CountingHandler(data.length, promise)).sync().getNow();
+                    // Alternate between many small writes and a few large ones.
+                    int chunk = (j & 1) == 0 ? 512 : 64 * 1024;
+                    for (int offset = 0; offset < data.length; offset += chunk) {
+                        stream.write(stream.alloc().directBuffer().writeBytes(
+                                data, offset, Math.min(chunk, data.length - offset)));
+                    }
+                    stream.flush();
+                    echoed.add(promise);
+                }
+                for (Promise<Void> promise: echoed) {
+                    promise.sync();
+                }
+                quicChannel.close().sync();
+            }
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+
+    @ChannelHandler.Sharable
+    private static final class EchoHandler extends ChannelInboundHandlerAdapter {
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            ctx.write(msg);
+        }
+
+        @Override
+        public void channelReadComplete(ChannelHandlerContext ctx) {
+            ctx.flush();
+        }
+    }
+
+    private static final class CountingHandler extends ChannelInboundHandlerAdapter {
+        private final Promise<Void> promise;
+        private int remaining;
+
+        CountingHandler(int expected, Promise<Void> promise) {
+            this.remaining = expected;
+            this.promise = promise;
+        }
+
+        @Override
+        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+            remaining -= ((ByteBuf) msg).readableBytes();
+            ReferenceCountUtil.release(msg);
+            if (remaining <= 0) {
+                ctx.close();
+                promise.trySuccess(null);
+            }
+        }
+
+        @Override
+        public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+            promise.tryFailure(cause);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelException;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.concurrent.Future;
+import org.junit.Test;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.greaterThanOrEqualTo;
+import static org.hamcrest.Matchers.instanceOf;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+public class QuicMemoryBudgetTest {
+
+    @Test
+    public void testUnlimited() {
+        QuicheQuicMemoryBudget budget = new QuicheQuicMemoryBudget(0, 0);
+        budget.add(Long.MAX_VALUE / 2);
+        assertTrue(budget.canOpenConnection());
+        assertTrue(budget.canOpenStream(Long.MAX_VALUE / 2));
+    }
+
+    @Test
+    public void testTotalMemory() {
+        QuicheQuicMemoryBudget budget = new QuicheQuicMemoryBudget(0, QuicheQuicMemoryBudget.CONNECTION_COST);
+        assertTrue(budget.canOpenConnection());
+        budget.add(QuicheQuicMemoryBudget.CONNECTION_COST);
+        assertFalse(budget.canOpenConnection());
+        assertFalse(budget.canOpenStream(QuicheQuicMemoryBudget.CONNECTION_COST));
+        budget.add(-QuicheQuicMemoryBudget.CONNECTION_COST);
+        assertEquals(0, budget.used());
+        assertTrue(budget.canOpenConnection());
+    }
+
+    @Test
+    public void testConnectionMemory() {
+        long max = QuicheQuicMemoryBudget.CONNECTION_COST + QuicheQuicMemoryBudget.STREAM_COST;
+        QuicheQuicMemoryBudget budget = new QuicheQuicMemoryBudget(max, 0);
+        assertTrue(budget.canOpenStream(QuicheQuicMemoryBudget.CONNECTION_COST));
+        assertFalse(budget.canOpenStream(max));
+        // The limit of a connection does not limit the number of connections.
+        budget.add(max * 100);
+        assertTrue(budget.canOpenConnection());
+    }
+
+    @Test
+    public void testStreamIsShedWhenConnectionBudgetIsExhausted() throws Throwable {
+        Channel server = QuicTestUtils.newServer(QuicTestUtils.newQuicServerBuilder(),
+                InsecureQuicTokenHandler.INSTANCE, null, new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                });
+        TestMetricsCollector clientCollector = new TestMetricsCollector();
+        // Enough for the connection and exactly one stream.
+        Channel channel = QuicTestUtils.newClient(QuicTestUtils.newQuicClientBuilder()
+                .memoryBudget(QuicheQuicMemoryBudget.CONNECTION_COST + QuicheQuicMemoryBudget.STREAM_COST, 0)
+                .metricsCollector(clientCollector));
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+
+            QuicStreamChannel stream = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                    new ChannelInboundHandlerAdapter()).sync().getNow();
+            Future<QuicStreamChannel> shed = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                    new ChannelInboundHandlerAdapter()).await();
+            assertThat(shed.cause(), instanceOf(ChannelException.class));
+            assertEquals(1, clientCollector.metrics.shedStreams());
+
+            QuicConnectionStats stats = quicChannel.collectStats().sync().getNow();
+            assertThat(stats.memoryUsed(), greaterThanOrEqualTo(
+                    QuicheQuicMemoryBudget.CONNECTION_COST + QuicheQuicMemoryBudget.STREAM_COST));
+
+            stream.close().sync();
+            quicChannel.close().sync();
+        } finally {
+            QuicTestUtils.closeIfNotNull(channel);
+            QuicTestUtils.closeIfNotNull(server);
+        }
+    }
+
+    private static final class TestMetricsCollector implements QuicMetricsCollector {
+        volatile QuicCodecMetrics metrics;
+
+        @Override
+        public void register(QuicCodecMetrics metrics) {
+            this.metrics = metrics;
+        }
+
+        @Override
+        public void unregister(QuicCodecMetrics metrics) {
+            this.metrics = null;
+        }
+    }
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.ChannelOutboundHandlerAdapter;
+import io.netty.channel.ChannelPromise;
+import io.netty.channel.socket.DatagramPacket;
+import io.netty.util.ReferenceCountUtil;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Test;
+
+import java.util.concurrent.TimeUnit;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+
+public class QuicPacingTest {
+
+    private static final int TRANSFER_SIZE = 1024 * 1024;
+
+    @Test(timeout = 60000)
+    public void testPacingReducesLoss() throws Throwable {
+        TransferResult unpaced = testTransfer(false);
+        TransferResult paced = testTransfer(true);
+        String message = "paced: " + paced + ", unpaced: " + unpaced;
+        // Without pacing the bursts overflow the buffer in front of the bottleneck.
+        assertTrue(message, unpaced.drops > 0);
+        assertTrue(message, paced.drops < unpaced.drops);
+    }
+
+    private static TransferResult testTransfer(boolean pacing) throws Throwable {
+        Promise<Integer> received = ImmediateEventExecutor.INSTANCE.newPromise();
+        Channel server = QuicTestUtils.newServer(new ChannelInboundHandlerAdapter(),
+                new ChannelInboundHandlerAdapter() {
+                    private int receivedBytes;
+
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        ByteBuf buffer = (ByteBuf) msg;
+                        receivedBytes += buffer.readableBytes();
+                        buffer.release();
+                    }
+
+                    @Override
+                    public void channelInactive(ChannelHandlerContext ctx) {
+                        // The FIN was received and so the stream was closed.
+                        received.trySuccess(receivedBytes);
+                    }
+
+                    @Override
+                    public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+                        received.tryFailure(cause);
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                });
+        Channel channel = QuicTestUtils.newClient(QuicTestUtils.newQuicClientBuilder().enablePacing(pacing));
+        // 20 MB/s with a buffer of 5 ms in front of the link, everything beyond is dropped.
+        BottleneckHandler bottleneck = new BottleneckHandler(20 * 1024 * 1024, TimeUnit.MILLISECONDS.toNanos(5));
+        channel.pipeline().addFirst(bottleneck);
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            QuicStreamChannel stream = quicChannel.createStream(
+                    QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter()).sync().getNow();
+
+            // Only count what is dropped while transferring the data, not during the handshake.
+            long dropsBefore = drops(channel, bottleneck);
+            long start = System.nanoTime();
+            for (int written = 0; written < TRANSFER_SIZE; written += 16 * 1024) {
+                stream.write(Unpooled.directBuffer().writeZero(16 * 1024));
+            }
+            stream.writeAndFlush(new DefaultQuicStreamFrame(Unpooled.EMPTY_BUFFER, true)).sync();
+
+            assertEquals(TRANSFER_SIZE, (int) received.sync().getNow());
+            long elapsedNanos = System.nanoTime() - start;
+            QuicConnectionStats stats = quicChannel.collectStats().sync().getNow();
+            long drops = drops(channel, bottleneck) - dropsBefore;
+
+            stream.close().sync();
+            quicChannel.close().sync();
+            return new TransferResult(drops, stats.lost(), elapsedNanos);
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+
+    // The drops are counted on the event loop of the client.
+    private static long drops(Channel channel, BottleneckHandler bottleneck) throws Exception {
+        return channel.eventLoop().submit(() -> bottleneck.drops).sync().getNow();
+    }
+
+    private static final class TransferResult {
+        final long drops;
+        final long lost;
+        final long elapsedNanos;
+
+        TransferResult(long drops, long lost, long elapsedNanos) {
+            this.drops = drops;
+            this.lost = lost;
+            this.elapsedNanos = elapsedNanos;
+        }
+
+        @Override
+        public String toString() {
+            return "drops=" + drops + ", lost=" + lost + ", elapsed=" +
+                    TimeUnit.NANOSECONDS.toMillis(elapsedNanos) + "ms";
+        }
+    }
+
+    /**
+     * Emulates a link with a limited rate and a shallow buffer in front of it, like {@code netem} would. Packets are
+     * delayed until the link would have transmitted them and dropped if the buffer is full.
+     */
+    private static final class BottleneckHandler extends ChannelOutboundHandlerAdapter {
+        private final double nanosPerByte;
+        private final long maxQueueDelayNanos;
+        private long linkFreeNanos;
+        long drops;
+
+        BottleneckHandler(long bytesPerSecond, long maxQueueDelayNanos) {
+            this.nanosPerByte = (double) TimeUnit.SECONDS.toNanos(1) / bytesPerSecond;
+            this.maxQueueDelayNanos = maxQueueDelayNanos;
+        }
+
+        @Override
+        public void write(ChannelHandlerContext ctx, Object msg, ChannelPromise promise) {
+            if (!(msg instanceof DatagramPacket)) {
+                ctx.write(msg, promise);
+                return;
+            }
+            long now = System.nanoTime();
+            long delay = Math.max(0, linkFreeNanos - now);
+            if (delay > maxQueueDelayNanos) {
+                // The buffer is full, drop the packet.
+                drops++;
+                ReferenceCountUtil.release(msg);
+                promise.setSuccess();
+                return;
+            }
+            int size = ((DatagramPacket) msg).content().readableBytes();
+            linkFreeNanos = now + delay + (long) (size * nanosPerByte);
+            ctx.executor().schedule(() -> ctx.writeAndFlush(msg, promise), delay, TimeUnit.NANOSECONDS);
+        }
+    }
+}
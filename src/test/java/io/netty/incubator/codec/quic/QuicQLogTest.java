@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import org.junit.Test;
+
+import java.io.File;
+import java.nio.file.Files;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+import static org.junit.Assert.fail;
+
+public class QuicQLogTest {
+
+    @Test
+    public void testSampleRate() {
+        QLogConfiguration qlog = new QLogConfiguration("qlog", "title", "description", 0);
+        for (int i = 0; i < 100; i++) {
+            assertFalse(qlog.sample());
+        }
+        // The sample rate can be changed at runtime.
+        qlog.sampleRate(1);
+        for (int i = 0; i < 100; i++) {
+            assertTrue(qlog.sample());
+        }
+    }
+
+    @Test
+    public void testInvalidSampleRate() {
+        QLogConfiguration qlog = new QLogConfiguration("qlog", "title", "description");
+        assertEquals(1.0, qlog.sampleRate(), 0);
+        try {
+            qlog.sampleRate(1.5);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // expected
+        }
+        try {
+            qlog.sampleRate(-0.1);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // expected
+        }
+    }
+
+    @Test
+    public void testQLogOption() throws Throwable {
+        File dir = Files.createTempDirectory("qlog").toFile();
+        QLogConfiguration qlog = new QLogConfiguration(dir.getAbsolutePath(), "title", "description");
+        Channel server = QuicTestUtils.newServer(
+                QuicTestUtils.newQuicServerBuilder().option(QuicChannelOption.QLOG, qlog),
+                InsecureQuicTokenHandler.INSTANCE, null, new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                });
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .option(QuicChannelOption.QLOG, qlog)
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            assertSame(qlog, quicChannel.config().getOption(QuicChannelOption.QLOG));
+            quicChannel.close().sync();
+
+            // Only if qlog is supported by the native library there will be files for the client and server.
+            File[] files = dir.listFiles();
+            assertTrue(files.length == 0 || files.length == 2);
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+            File[] files = dir.listFiles();
+            for (File file: files) {
+                file.delete();
+            }
+            dir.delete();
+        }
+    }
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.bootstrap.Bootstrap;
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.ChannelInitializer;
+import io.netty.channel.ChannelOutboundHandlerAdapter;
+import io.netty.channel.ChannelPromise;
+import io.netty.channel.EventLoopGroup;
+import io.netty.channel.epoll.Epoll;
+import io.netty.channel.epoll.EpollDatagramChannel;
+import io.netty.channel.epoll.EpollEventLoopGroup;
+import io.netty.channel.epoll.SegmentedDatagramPacket;
+import io.netty.channel.nio.NioEventLoopGroup;
+import io.netty.channel.socket.DatagramChannel;
+import io.netty.channel.socket.DatagramPacket;
+import io.netty.channel.socket.nio.NioDatagramChannel;
+import io.netty.util.NetUtil;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Assume;
+import org.junit.Test;
+
+import java.net.InetSocketAddress;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+
+public class QuicSegmentedDatagramPacketTest {
+    @Test
+    public void testCoalescedPacketsAreSplitCorrectly() throws Throwable {
+        AtomicInteger segmentedPackets = new AtomicInteger();
+        SegmentedDatagramPacketAllocator allocator = new SegmentedDatagramPacketAllocator() {
+            @Override
+            public int maxNumSegments() {
+                return 8;
+            }
+
+            @Override
+            public DatagramPacket newPacket(ByteBuf buffer, int segmentSize, InetSocketAddress remoteAddress) {
+                segmentedPackets.incrementAndGet();
+                return new TestSegmentedDatagramPacket(buffer, segmentSize, remoteAddress);
+            }
+        };
+
+        EventLoopGroup group = new NioEventLoopGroup(1);
+        try {
+            // NIO does not support UDP_SEGMENT so split the packets in the pipeline the same way as the kernel would
+            // do it.
+            transfer(group, NioDatagramChannel.class, allocator, new SegmentSplitter(), 1024 * 1024);
+            assertTrue(segmentedPackets.get() > 0);
+        } finally {
+            group.shutdownGracefully();
+        }
+    }
+
+    @Test
+    public void testSegmentedPacketsAreWrittenWithEpoll() throws Throwable {
+        Assume.assumeTrue(Epoll.isAvailable() && SegmentedDatagramPacket.isSupported());
+        int bytes = 4 * 1024 * 1024;
+        EventLoopGroup group = new EpollEventLoopGroup(1);
+        try {
+            WriteCounter perPacket = new WriteCounter();
+            transfer(group, EpollDatagramChannel.class, SegmentedDatagramPacketAllocator.NONE, perPacket, bytes);
+            WriteCounter segmented = new WriteCounter();
+            transfer(group, EpollDatagramChannel.class, EpollQuicUtils.newSegmentedAllocator(10), segmented, bytes);
+
+            String message = "per-packet: " + perPacket + ", segmented: " + segmented;
+            assertEquals(message, 0, perPacket.segmentedWrites);
+            assertTrue(message, segmented.segmentedWrites > 0);
+            // Each segmented write needs to carry more than one packet on average, otherwise UDP_SEGMENT does not
+            // save any syscalls.
+            assertTrue(message, segmented.segments > 2 * segmented.segmentedWrites);
+            assertTrue(message, segmented.writes < perPacket.writes);
+        } finally {
+            group.shutdownGracefully();
+        }
+    }
+
+    private static void transfer(EventLoopGroup group, Class<? extends DatagramChannel> channelClass,
+                                 SegmentedDatagramPacketAllocator allocator, ChannelHandler outboundHandler, int bytes)
+            throws Throwable {
+        Promise<Void> received = ImmediateEventExecutor.INSTANCE.newPromise();
+        Channel server = QuicTestUtils.newServer(null, new ChannelInboundHandlerAdapter() {
+            private int receivedBytes;
+
+            @Override
+            public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                ByteBuf buffer = (ByteBuf) msg;
+                receivedBytes += buffer.readableBytes();
+                buffer.release();
+                if (receivedBytes == bytes) {
+                    received.trySuccess(null);
+                }
+            }
+
+            @Override
+            public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+                received.tryFailure(cause);
+            }
+
+            @Override
+            public boolean isSharable() {
+                return true;
+            }
+        });
+        ChannelHandler codec = QuicTestUtils.newQuicClientBuilder()
+                .segmentedDatagramPacketAllocator(allocator).build();
+        Channel channel = new Bootstrap().group(group)
+                .channel(channelClass)
+                .handler(new ChannelInitializer<Channel>() {
+                    @Override
+                    protected void initChannel(Channel ch) {
+                        if (outboundHandler != null) {
+                            // Sees the packets that are written by the codec.
+                            ch.pipeline().addLast(outboundHandler);
+                        }
+                        ch.pipeline().addLast(codec);
+                    }
+                })
+                .bind(new InetSocketAddress(NetUtil.LOCALHOST4, 0)).sync().channel();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            QuicStreamChannel stream = quicChannel.createStream(
+                    QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter()).sync().getNow();
+
+            stream.writeAndFlush(Unpooled.directBuffer(bytes).writeZero(bytes));
+            received.sync();
+
+            stream.close().sync();
+            quicChannel.close().sync();
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+
+    /**
+     * Counts the datagrams that are written and how many segments the {@link SegmentedDatagramPacket}s carry.
+     */
+    private static final class WriteCounter extends ChannelOutboundHandlerAdapter {
+        long writes;
+        long segmentedWrites;
+        long segments;
+
+        @Override
+        public void write(ChannelHandlerContext ctx, Object msg, ChannelPromise promise) {
+            if (msg instanceof DatagramPacket) {
+                writes++;
+                if (msg instanceof SegmentedDatagramPacket) {
+                    SegmentedDatagramPacket packet = (SegmentedDatagramPacket) msg;
+                    int segmentSize = packet.segmentSize();
+                    segmentedWrites++;
+                    segments += (packet.content().readableBytes() + segmentSize - 1) / segmentSize;
+                }
+            }
+            ctx.write(msg, promise);
+        }
+
+        @Override
+        public String toString() {
+            return "writes=" + writes + ", segmentedWrites=" + segmentedWrites + ", segments=" + segments;
+        }
+    }
+
+    private static final class TestSegmentedDatagramPacket extends DatagramPacket {
+        final int segmentSize;
+
+        TestSegmentedDatagramPacket(ByteBuf data, int segmentSize, InetSocketAddress recipient) {
+            super(data, recipient);
+            this.segmentSize = segmentSize;
+        }
+    }
+
+    @ChannelHandler.Sharable
+    private static final class SegmentSplitter extends ChannelOutboundHandlerAdapter {
+        @Override
+        public void write(ChannelHandlerContext ctx, Object msg, ChannelPromise promise) {
+            if (msg instanceof TestSegmentedDatagramPacket) {
+                TestSegmentedDatagramPacket packet = (TestSegmentedDatagramPacket) msg;
+                ByteBuf content = packet.content();
+                try {
+                    while (content.readableBytes() > packet.segmentSize) {
+                        ctx.write(new DatagramPacket(content.readRetainedSlice(packet.segmentSize),
+                                packet.recipient()), ctx.voidPromise());
+                    }
+                    ctx.write(new DatagramPacket(content.readRetainedSlice(content.readableBytes()),
+                            packet.recipient()), promise);
+                } finally {
+                    packet.release();
+                }
+            } else {
+                ctx.write(msg, promise);
+            }
+        }
+    }
+}
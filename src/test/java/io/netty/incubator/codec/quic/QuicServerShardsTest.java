@@ -0,0 +1,220 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.bootstrap.Bootstrap;
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandler;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.channel.EventLoopGroup;
+import io.netty.channel.nio.NioEventLoopGroup;
+import io.netty.channel.socket.nio.NioDatagramChannel;
+import io.netty.util.CharsetUtil;
+import io.netty.util.NetUtil;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Test;
+
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+
+public class QuicServerShardsTest {
+
+    private static final int NUM_CONNECTIONS = 16;
+
+    @Test
+    public void testConnectionsAreAcceptedByReceivingShard() throws Throwable {
+        Map<Channel, AtomicInteger> connectionsPerShard = new ConcurrentHashMap<>();
+        List<Channel> servers = echo(2, 0, connectionsPerShard);
+
+        // The client always sends to the first shard, so it must own all connections and nothing is forwarded.
+        assertEquals(NUM_CONNECTIONS, connectionsPerShard.get(servers.get(0)).get());
+        assertNull(connectionsPerShard.get(servers.get(1)));
+    }
+
+    @Test
+    public void testConnectionsAreHandedOffToWorkers() throws Throwable {
+        Map<Channel, AtomicInteger> connectionsPerShard = new ConcurrentHashMap<>();
+        List<Channel> servers = echo(3, 1, connectionsPerShard);
+
+        // All connections must become active on one of the workers, never on the handshake shard.
+        assertNull(connectionsPerShard.get(servers.get(0)));
+        assertEquals(NUM_CONNECTIONS / 2, connectionsPerShard.get(servers.get(1)).get());
+        assertEquals(NUM_CONNECTIONS / 2, connectionsPerShard.get(servers.get(2)).get());
+    }
+
+    @Test
+    public void testConnectionsWithoutRetryAreHandedOffToWorkers() throws Throwable {
+        Map<Channel, AtomicInteger> connectionsPerShard = new ConcurrentHashMap<>();
+        // Never send a Retry, so the server needs to choose the connection ids when it accepts the connections.
+        List<Channel> servers = echo(QuicTestUtils.newQuicServerBuilder().adaptiveRetry(1000, 100),
+                3, 1, connectionsPerShard);
+
+        assertNull(connectionsPerShard.get(servers.get(0)));
+        assertEquals(NUM_CONNECTIONS / 2, connectionsPerShard.get(servers.get(1)).get());
+        assertEquals(NUM_CONNECTIONS / 2, connectionsPerShard.get(servers.get(2)).get());
+    }
+
+    @Test
+    public void testRouteWithoutHandshakeShards() {
+        QuicheQuicServerShards shards = new QuicheQuicServerShards(4, 0);
+        ByteBuf id = connectionId(4, 2, 2);
+        // Everything goes to the owner in one hop, and the owner never forwards.
+        assertEquals(2, shards.route(0, id, false, false, false));
+        assertEquals(2, shards.route(1, id, true, true, false));
+        assertEquals(2, shards.route(2, id, false, false, true));
+        assertEquals(3, shards.route(3, id, false, false, true));
+
+        // New connections stay on the shard that received them.
+        assertEquals(3, shards.acceptingShard(3, id));
+    }
+
+    @Test
+    public void testRouteWithHandshakeShards() {
+        // Shard 0 is the handshake shard that created the connection, shard 2 the worker that owns it.
+        QuicheQuicServerShards shards = new QuicheQuicServerShards(3, 1);
+        ByteBuf id = connectionId(3, 2, 0);
+
+        // Established traffic goes to the worker in one hop, even if it was received by the handshake shard.
+        assertEquals(2, shards.route(0, id, false, false, false));
+        assertEquals(2, shards.route(1, id, false, false, false));
+        // Handshake packets go to the handshake shard in one hop.
+        assertEquals(0, shards.route(1, id, true, false, false));
+        assertEquals(0, shards.route(2, id, true, true, false));
+
+        // The worker did not adopt the connection yet, so the handshake shard still serves it.
+        assertEquals(0, shards.route(2, id, false, false, false));
+        assertEquals(0, shards.route(2, id, false, false, true));
+        // The handshake shard already handed off the connection.
+        assertEquals(2, shards.route(0, id, true, false, false));
+        // Never forward more than twice.
+        assertEquals(0, shards.route(0, id, false, false, true));
+        assertEquals(2, shards.route(2, id, true, false, true));
+        // An Initial always starts the connection on the handshake shard.
+        assertEquals(0, shards.route(0, id, true, true, true));
+
+        // New connections that are received by a worker are started by a handshake shard.
+        assertEquals(0, shards.acceptingShard(2, id));
+    }
+
+    private static ByteBuf connectionId(int numShards, int owner, int creator) {
+        return Unpooled.wrappedBuffer(new ShardedQuicConnectionIdGenerator(
+                QuicConnectionIdGenerator.randomGenerator(), creator, numShards)
+                .newId(ByteBuffer.wrap(new byte[8]), 20, owner));
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testHandshakeShardsNeedWorkers() {
+        QuicTestUtils.newQuicServerBuilder()
+                .tokenHandler(InsecureQuicTokenHandler.INSTANCE)
+                .handler(new ChannelInboundHandlerAdapter())
+                .streamHandler(new ChannelInboundHandlerAdapter())
+                .buildShards(2, 2);
+    }
+
+    // Echo over NUM_CONNECTIONS connections and return the (already closed) server channels of the shards.
+    private static List<Channel> echo(int numShards, int numHandshakeShards,
+                                      Map<Channel, AtomicInteger> connectionsPerShard) throws Throwable {
+        return echo(QuicTestUtils.newQuicServerBuilder(), numShards, numHandshakeShards, connectionsPerShard);
+    }
+
+    private static List<Channel> echo(QuicServerCodecBuilder builder, int numShards, int numHandshakeShards,
+                                      Map<Channel, AtomicInteger> connectionsPerShard) throws Throwable {
+        EventLoopGroup group = new NioEventLoopGroup(numShards);
+        List<ChannelHandler> codecs = builder
+                .tokenHandler(InsecureQuicTokenHandler.INSTANCE)
+                .handler(new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public void channelActive(ChannelHandlerContext ctx) {
+                        connectionsPerShard.computeIfAbsent(ctx.channel().parent(), k -> new AtomicInteger())
+                                .incrementAndGet();
+                        ctx.fireChannelActive();
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                })
+                .streamHandler(new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        ctx.writeAndFlush(msg);
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                }).buildShards(numShards, numHandshakeShards);
+        assertEquals(numShards, codecs.size());
+
+        // NIO does not support SO_REUSEPORT, so bind the shards to different ports and let the client always use the
+        // first one. The packets of connections that are owned by another shard need to be forwarded. Workers send
+        // from their own port, which is fine as the client only uses the connection id to find the connection.
+        List<Channel> servers = new ArrayList<>();
+        Channel client = QuicTestUtils.newClient();
+        try {
+            for (ChannelHandler codec: codecs) {
+                servers.add(new Bootstrap().group(group)
+                        .channel(NioDatagramChannel.class)
+                        .handler(codec)
+                        .bind(new InetSocketAddress(NetUtil.LOCALHOST4, 0)).sync().channel());
+            }
+            for (int i = 0; i < NUM_CONNECTIONS; i++) {
+                Promise<String> echo = ImmediateEventExecutor.INSTANCE.newPromise();
+                QuicChannel quicChannel = QuicChannel.newBootstrap(client)
+                        .handler(new ChannelInboundHandlerAdapter())
+                        .streamHandler(new ChannelInboundHandlerAdapter())
+                        .remoteAddress(servers.get(0).localAddress())
+                        .connect()
+                        .get();
+                QuicStreamChannel stream = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                        new ChannelInboundHandlerAdapter() {
+                            @Override
+                            public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                                ByteBuf buffer = (ByteBuf) msg;
+                                echo.trySuccess(buffer.toString(CharsetUtil.US_ASCII));
+                                buffer.release();
+                            }
+                        }).sync().getNow();
+                stream.writeAndFlush(Unpooled.copiedBuffer("ping", CharsetUtil.US_ASCII)).sync();
+                assertEquals("ping", echo.sync().getNow());
+                stream.close().sync();
+                quicChannel.close().sync();
+            }
+
+            return servers;
+        } finally {
+            for (Channel server: servers) {
+                server.close().sync();
+            }
+            client.close().sync();
+            group.shutdownGracefully();
+        }
+    }
+}
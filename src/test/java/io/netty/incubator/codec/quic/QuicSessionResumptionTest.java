@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import io.netty.util.internal.logging.InternalLogger;
+import io.netty.util.internal.logging.InternalLoggerFactory;
+import org.junit.Assume;
+import org.junit.Test;
+
+import java.net.InetSocketAddress;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.lessThan;
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertNull;
+
+public class QuicSessionResumptionTest {
+    private static final InternalLogger logger = InternalLoggerFactory.getInstance(QuicSessionResumptionTest.class);
+
+    @Test
+    public void testLruCacheEvictsLeastRecentlyUsed() {
+        QuicSessionCache cache = QuicSessionCache.newLruCache(2);
+        InetSocketAddress first = new InetSocketAddress(1);
+        InetSocketAddress second = new InetSocketAddress(2);
+        InetSocketAddress third = new InetSocketAddress(3);
+        cache.saveSession("netty", first, new byte[] { 1 });
+        cache.saveSession("netty", second, new byte[] { 2 });
+        // Access the first so the second becomes the least recently used.
+        assertArrayEquals(new byte[] { 1 }, cache.getSession("netty", first));
+        cache.saveSession("netty", third, new byte[] { 3 });
+
+        assertNull(cache.getSession("netty", second));
+        assertArrayEquals(new byte[] { 1 }, cache.getSession("netty", first));
+        assertArrayEquals(new byte[] { 3 }, cache.getSession("netty", third));
+        // The server name is part of the key.
+        assertNull(cache.getSession("other", first));
+        assertNull(cache.getSession(null, first));
+    }
+
+    @Test(expected = UnsupportedOperationException.class)
+    public void testSessionCacheUnsupported() throws Exception {
+        Assume.assumeFalse(Quic.isSessionResumptionSupported());
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel.newBootstrap(channel).sessionCache(QuicSessionCache.newLruCache(1));
+        } finally {
+            QuicTestUtils.closeIfNotNull(channel);
+        }
+    }
+
+    @Test
+    public void testTimeToFirstByteOnReconnect() throws Throwable {
+        Assume.assumeTrue(Quic.isSessionResumptionSupported());
+        QuicSessionCache cache = QuicSessionCache.newLruCache(16);
+        Channel server = QuicTestUtils.newServer(null, new ChannelInboundHandlerAdapter() {
+            @Override
+            public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                ctx.writeAndFlush(msg);
+            }
+
+            @Override
+            public boolean isSharable() {
+                return true;
+            }
+        });
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            // Warmup
+            timeToFirstByte(channel, server, QuicSessionCache.newLruCache(1));
+
+            long full = timeToFirstByte(channel, server, cache);
+            long resumed = timeToFirstByte(channel, server, cache);
+            logger.info("Time to first byte: full handshake {} ns, reconnect {} ns", full, resumed);
+
+            assertThat(resumed, lessThan(full));
+        } finally {
+            QuicTestUtils.closeIfNotNull(channel);
+            QuicTestUtils.closeIfNotNull(server);
+        }
+    }
+
+    private static long timeToFirstByte(Channel channel, Channel server, QuicSessionCache cache) throws Throwable {
+        Promise<Void> firstByte = ImmediateEventExecutor.INSTANCE.newPromise();
+        long start = System.nanoTime();
+        QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                .handler(new ChannelInboundHandlerAdapter())
+                .streamHandler(new ChannelInboundHandlerAdapter())
+                .remoteAddress(server.localAddress())
+                .sessionCache(cache)
+                .connect()
+                .get();
+        QuicStreamChannel stream = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                new ChannelInboundHandlerAdapter() {
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        ((ByteBuf) msg).release();
+                        firstByte.trySuccess(null);
+                    }
+                }).sync().getNow();
+        stream.writeAndFlush(Unpooled.directBuffer().writeByte(1));
+        firstByte.sync();
+        long time = System.nanoTime() - start;
+        stream.close().sync();
+        // Closing the connection stores the session in the cache.
+        quicChannel.close().sync();
+        return time;
+    }
+}
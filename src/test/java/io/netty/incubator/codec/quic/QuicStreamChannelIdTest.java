@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.ChannelId;
+import io.netty.channel.DefaultChannelId;
+import org.junit.Test;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.greaterThan;
+import static org.hamcrest.Matchers.lessThan;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotEquals;
+
+public class QuicStreamChannelIdTest {
+
+    @Test
+    public void testText() {
+        ChannelId parentId = DefaultChannelId.newInstance();
+        QuicStreamChannelId id = new QuicStreamChannelId(parentId, 4);
+        assertEquals(parentId.asShortText() + "/4", id.asShortText());
+        assertEquals(parentId.asLongText() + "/4", id.asLongText());
+    }
+
+    @Test
+    public void testEqualsAndCompare() {
+        ChannelId parentId = DefaultChannelId.newInstance();
+        ChannelId otherParentId = DefaultChannelId.newInstance();
+        QuicStreamChannelId id = new QuicStreamChannelId(parentId, 4);
+        assertEquals(id, new QuicStreamChannelId(parentId, 4));
+        assertEquals(id.hashCode(), new QuicStreamChannelId(parentId, 4).hashCode());
+        assertEquals(0, id.compareTo(new QuicStreamChannelId(parentId, 4)));
+        assertNotEquals(id, new QuicStreamChannelId(parentId, 8));
+        assertNotEquals(id, new QuicStreamChannelId(otherParentId, 4));
+
+        assertThat(id.compareTo(new QuicStreamChannelId(parentId, 8)), lessThan(0));
+        assertThat(new QuicStreamChannelId(parentId, 8).compareTo(id), greaterThan(0));
+        // A stream is ordered after its parent.
+        assertThat(id.compareTo(parentId), greaterThan(0));
+    }
+}
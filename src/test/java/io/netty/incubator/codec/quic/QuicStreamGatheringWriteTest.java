@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.CompositeByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+
+public class QuicStreamGatheringWriteTest {
+
+    @Test
+    public void testMixedBuffersAreWrittenInOrder() throws Throwable {
+        ByteBuf expected = Unpooled.buffer();
+        Promise<ByteBuf> received = ImmediateEventExecutor.INSTANCE.newPromise();
+        Channel server = QuicTestUtils.newServer(new ChannelInboundHandlerAdapter(),
+                new ChannelInboundHandlerAdapter() {
+                    private final ByteBuf receivedBuffer = Unpooled.buffer();
+
+                    @Override
+                    public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                        ByteBuf buffer = (ByteBuf) msg;
+                        receivedBuffer.writeBytes(buffer);
+                        buffer.release();
+                    }
+
+                    @Override
+                    public void channelInactive(ChannelHandlerContext ctx) {
+                        // The FIN was received and so the stream was closed.
+                        received.trySuccess(receivedBuffer);
+                    }
+
+                    @Override
+                    public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
+                        received.tryFailure(cause);
+                    }
+
+                    @Override
+                    public boolean isSharable() {
+                        return true;
+                    }
+                });
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+            QuicStreamChannel stream = quicChannel.createStream(
+                    QuicStreamType.BIDIRECTIONAL, new ChannelInboundHandlerAdapter()).sync().getNow();
+
+            int value = 0;
+            for (int i = 0; i < 128; i++) {
+                ByteBuf buffer;
+                switch (i % 4) {
+                    case 0:
+                        buffer = Unpooled.directBuffer();
+                        break;
+                    case 1:
+                        buffer = Unpooled.buffer();
+                        break;
+                    case 2:
+                        CompositeByteBuf composite = Unpooled.compositeBuffer();
+                        for (int j = 0; j < 4; j++) {
+                            ByteBuf component = Unpooled.directBuffer();
+                            for (int k = 0; k < 512; k++) {
+                                component.writeByte(value++);
+                            }
+                            composite.addComponent(true, component);
+                        }
+                        buffer = composite;
+                        break;
+                    default:
+                        // A composite buffer that mixes direct and heap memory.
+                        CompositeByteBuf mixed = Unpooled.compositeBuffer();
+                        mixed.addComponent(true, Unpooled.directBuffer().writeInt(value++));
+                        mixed.addComponent(true, Unpooled.buffer().writeInt(value++));
+                        buffer = mixed;
+                        break;
+                }
+                for (int k = 0; k < 1024; k++) {
+                    buffer.writeByte(value++);
+                }
+                // Skip some bytes so we also test buffers with a readerIndex != 0.
+                buffer.skipBytes(3);
+                expected.writeBytes(buffer, buffer.readerIndex(), buffer.readableBytes());
+                stream.write(buffer);
+            }
+            stream.writeAndFlush(new DefaultQuicStreamFrame(Unpooled.EMPTY_BUFFER, true)).sync();
+
+            ByteBuf receivedBuffer = received.sync().getNow();
+            assertEquals(expected, receivedBuffer);
+            receivedBuffer.release();
+
+            stream.close().sync();
+            quicChannel.close().sync();
+        } finally {
+            expected.release();
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.buffer.ByteBuf;
+import io.netty.buffer.Unpooled;
+import io.netty.channel.Channel;
+import io.netty.channel.ChannelHandlerContext;
+import io.netty.channel.ChannelInboundHandlerAdapter;
+import io.netty.util.AttributeKey;
+import io.netty.util.concurrent.ImmediateEventExecutor;
+import io.netty.util.concurrent.Promise;
+import io.netty.util.internal.logging.InternalLogger;
+import io.netty.util.internal.logging.InternalLoggerFactory;
+import org.junit.Test;
+
+import java.util.Arrays;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.TimeUnit;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.lessThan;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+
+public class QuicStreamPriorityTest {
+    private static final InternalLogger logger = InternalLoggerFactory.getInstance(QuicStreamPriorityTest.class);
+
+    private static final byte BULK = 'B';
+    private static final byte PING = 'P';
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testInvalidUrgency() {
+        new QuicStreamPriority(QuicStreamPriority.MAX_URGENCY + 1, false);
+    }
+
+    @Test
+    public void testSmallStreamLatencyUnderBulkTransfer() throws Throwable {
+        long unprioritized = smallStreamLatencyUnderBulkTransfer(false);
+        long prioritized = smallStreamLatencyUnderBulkTransfer(true);
+        logger.info("Small stream p99 latency under bulk transfer: {}us without priorities, {}us with priorities",
+                TimeUnit.NANOSECONDS.toMicros(unprioritized), TimeUnit.NANOSECONDS.toMicros(prioritized));
+        // Without priorities the pings are round-robined with the bulk stream, with priorities they should go first
+        // so the tail latency must drop considerably.
+        assertThat(prioritized, lessThan(unprioritized * 3 / 4));
+    }
+
+    // Send pings on a small stream while a bulk transfer is in flight and return the p99 round-trip time in nanos.
+    private static long smallStreamLatencyUnderBulkTransfer(boolean prioritize) throws Throwable {
+        int bulkBytes = 16 * 1024 * 1024;
+        int pings = 200;
+        Promise<Void> bulkReceived = ImmediateEventExecutor.INSTANCE.newPromise();
+        Channel server = QuicTestUtils.newServer(null, new ChannelInboundHandlerAdapter() {
+            @Override
+            public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                ByteBuf buffer = (ByteBuf) msg;
+                Object type = ctx.channel().attr(StreamType.KEY).get();
+                if (type == null) {
+                    // The first byte tells us what kind of stream this is.
+                    type = buffer.readByte() == PING ? StreamType.PING : new StreamType();
+                    ctx.channel().attr(StreamType.KEY).set((StreamType) type);
+                }
+                if (type == StreamType.PING) {
+                    // Echo back the ping.
+                    ctx.writeAndFlush(buffer);
+                } else {
+                    StreamType bulk = (StreamType) type;
+                    bulk.received += buffer.readableBytes();
+                    buffer.release();
+                    if (bulk.received == bulkBytes) {
+                        bulkReceived.trySuccess(null);
+                    }
+                }
+            }
+
+            @Override
+            public boolean isSharable() {
+                return true;
+            }
+        });
+        Channel channel = QuicTestUtils.newClient();
+        try {
+            QuicChannel quicChannel = QuicChannel.newBootstrap(channel)
+                    .handler(new ChannelInboundHandlerAdapter())
+                    .streamHandler(new ChannelInboundHandlerAdapter())
+                    .remoteAddress(server.localAddress())
+                    .connect()
+                    .get();
+
+            BlockingQueue<ByteBuf> pongs = new LinkedBlockingQueue<>();
+            QuicStreamChannel pingStream = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                    new ChannelInboundHandlerAdapter() {
+                        @Override
+                        public void channelRead(ChannelHandlerContext ctx, Object msg) {
+                            pongs.add((ByteBuf) msg);
+                        }
+                    }).sync().getNow();
+            QuicStreamChannel bulkStream = quicChannel.createStream(QuicStreamType.BIDIRECTIONAL,
+                    new ChannelInboundHandlerAdapter()).sync().getNow();
+
+            assertNull(pingStream.priority());
+            if (prioritize) {
+                QuicStreamPriority pingPriority = new QuicStreamPriority(QuicStreamPriority.MIN_URGENCY, false);
+                pingStream.updatePriority(pingPriority).sync();
+                assertEquals(pingPriority, pingStream.priority());
+                bulkStream.updatePriority(new QuicStreamPriority(QuicStreamPriority.MAX_URGENCY, true)).sync();
+            }
+
+            pingStream.writeAndFlush(Unpooled.directBuffer().writeByte(PING)).sync();
+            bulkStream.write(Unpooled.directBuffer().writeByte(BULK));
+            for (int i = 0; i < bulkBytes / 65536; i++) {
+                bulkStream.write(Unpooled.directBuffer(65536).writeZero(65536));
+            }
+            bulkStream.flush();
+
+            long[] latencies = new long[pings];
+            for (int i = 0; i < pings; i++) {
+                long start = System.nanoTime();
+                pingStream.writeAndFlush(Unpooled.directBuffer().writeLong(i));
+                int expected = Long.BYTES;
+                while (expected > 0) {
+                    ByteBuf pong = pongs.poll(10, TimeUnit.SECONDS);
+                    assertNotNull(pong);
+                    expected -= pong.readableBytes();
+                    pong.release();
+                }
+                latencies[i] = System.nanoTime() - start;
+            }
+            bulkReceived.sync();
+
+            quicChannel.close().sync();
+
+            Arrays.sort(latencies);
+            return latencies[pings * 99 / 100];
+        } finally {
+            server.close().sync();
+            // Close the parent Datagram channel as well.
+            channel.close().sync();
+        }
+    }
+
+    private static final class StreamType {
+        static final AttributeKey<StreamType> KEY = AttributeKey.valueOf(QuicStreamPriorityTest.class, "type");
+        static final StreamType PING = new StreamType();
+
+        long received;
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.util.NetUtil;
+import org.junit.Test;
+
+import java.net.InetAddress;
+
+import static org.junit.Assert.assertEquals;
+
+public class QuicheQuicBdpHistoryTest {
+
+    @Test
+    public void testUnknownPeer() {
+        QuicheQuicBdpHistory history = new QuicheQuicBdpHistory(8);
+        assertEquals(0, history.get(NetUtil.LOCALHOST4));
+    }
+
+    @Test
+    public void testGrowsImmediatelyAndDecaysSlowly() {
+        QuicheQuicBdpHistory history = new QuicheQuicBdpHistory(8);
+        history.record(NetUtil.LOCALHOST4, 1000);
+        assertEquals(1000, history.get(NetUtil.LOCALHOST4));
+        history.record(NetUtil.LOCALHOST4, 4000);
+        assertEquals(4000, history.get(NetUtil.LOCALHOST4));
+        history.record(NetUtil.LOCALHOST4, 0);
+        assertEquals(3000, history.get(NetUtil.LOCALHOST4));
+    }
+
+    @Test
+    public void testEvictsLeastRecentlyUsed() throws Exception {
+        QuicheQuicBdpHistory history = new QuicheQuicBdpHistory(2);
+        InetAddress first = InetAddress.getByAddress(new byte[] { 10, 0, 0, 1 });
+        InetAddress second = InetAddress.getByAddress(new byte[] { 10, 0, 0, 2 });
+        InetAddress third = InetAddress.getByAddress(new byte[] { 10, 0, 0, 3 });
+        history.record(first, 1);
+        history.record(second, 2);
+        // Access the first one so the second is the least recently used.
+        assertEquals(1, history.get(first));
+        history.record(third, 3);
+        assertEquals(1, history.get(first));
+        assertEquals(0, history.get(second));
+        assertEquals(3, history.get(third));
+    }
+}
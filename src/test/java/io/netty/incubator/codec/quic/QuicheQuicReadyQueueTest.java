@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import org.junit.Test;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+
+public class QuicheQuicReadyQueueTest {
+
+    @Test
+    public void testFifoOrder() {
+        QuicheQuicReadyQueue queue = new QuicheQuicReadyQueue();
+        QuicheQuicReadyQueue.Entry[] entries = newEntries(4);
+        for (QuicheQuicReadyQueue.Entry entry: entries) {
+            queue.add(entry);
+        }
+        assertEquals(entries.length, queue.size());
+        for (QuicheQuicReadyQueue.Entry entry: entries) {
+            assertSame(entry, queue.poll());
+            assertFalse(entry.isQueued());
+        }
+        assertTrue(queue.isEmpty());
+        assertNull(queue.poll());
+    }
+
+    @Test
+    public void testAddTwiceKeepsPosition() {
+        QuicheQuicReadyQueue queue = new QuicheQuicReadyQueue();
+        QuicheQuicReadyQueue.Entry[] entries = newEntries(2);
+        queue.add(entries[0]);
+        queue.add(entries[1]);
+        queue.add(entries[0]);
+        assertEquals(2, queue.size());
+        assertSame(entries[0], queue.poll());
+        assertSame(entries[1], queue.poll());
+    }
+
+    @Test
+    public void testRoundRobin() {
+        QuicheQuicReadyQueue queue = new QuicheQuicReadyQueue();
+        QuicheQuicReadyQueue.Entry[] entries = newEntries(3);
+        for (QuicheQuicReadyQueue.Entry entry: entries) {
+            queue.add(entry);
+        }
+        // An entry that is added again after it was polled goes to the end.
+        QuicheQuicReadyQueue.Entry first = queue.poll();
+        queue.add(first);
+        assertSame(entries[1], queue.poll());
+        assertSame(entries[2], queue.poll());
+        assertSame(first, queue.poll());
+    }
+
+    @Test
+    public void testRemove() {
+        QuicheQuicReadyQueue queue = new QuicheQuicReadyQueue();
+        QuicheQuicReadyQueue.Entry[] entries = newEntries(3);
+        for (QuicheQuicReadyQueue.Entry entry: entries) {
+            queue.add(entry);
+        }
+        queue.remove(entries[1]);
+        // Removing an entry that is not queued is a no-op.
+        queue.remove(entries[1]);
+        assertEquals(2, queue.size());
+        assertSame(entries[0], queue.poll());
+        assertSame(entries[2], queue.poll());
+
+        queue.add(entries[0]);
+        queue.add(entries[2]);
+        queue.clear();
+        assertTrue(queue.isEmpty());
+        assertFalse(entries[0].isQueued());
+        assertFalse(entries[2].isQueued());
+    }
+
+    private static QuicheQuicReadyQueue.Entry[] newEntries(int num) {
+        QuicheQuicReadyQueue.Entry[] entries = new QuicheQuicReadyQueue.Entry[num];
+        for (int i = 0; i < num; i++) {
+            entries[i] = new QuicheQuicReadyQueue.Entry(null);
+        }
+        return entries;
+    }
+}
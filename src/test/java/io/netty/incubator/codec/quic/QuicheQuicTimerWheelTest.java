@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 The Netty Project
+ *
+ * The Netty Project licenses this file to you under the Apache License,
+ * version 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at:
+ *
+ *   https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+package io.netty.incubator.codec.quic;
+
+import io.netty.channel.DefaultEventLoop;
+import io.netty.util.concurrent.ScheduledFuture;
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.hamcrest.MatcherAssert.assertThat;
+import static org.hamcrest.Matchers.greaterThanOrEqualTo;
+import static org.hamcrest.Matchers.lessThanOrEqualTo;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+public class QuicheQuicTimerWheelTest {
+
+    private CountingEventLoop eventLoop;
+    private QuicheQuicTimerWheel wheel;
+
+    @Before
+    public void setUp() {
+        eventLoop = new CountingEventLoop();
+        wheel = new QuicheQuicTimerWheel(eventLoop);
+    }
+
+    @After
+    public void tearDown() throws Exception {
+        eventLoop.submit(wheel::close).sync();
+        eventLoop.shutdownGracefully().sync();
+    }
+
+    @Test
+    public void testExpiresNotEarly() throws Exception {
+        // Use delays that are longer than one rotation of the wheel as well.
+        long[] delays = { 1, 5, 20, 700, 1100 };
+        CountDownLatch latch = new CountDownLatch(delays.length);
+        List<TestTimeout> timeouts = new ArrayList<>();
+        eventLoop.execute(() -> {
+            for (long delay: delays) {
+                TestTimeout timeout = new TestTimeout(latch, delay);
+                timeouts.add(timeout);
+                wheel.schedule(timeout, TimeUnit.MILLISECONDS.toNanos(delay));
+            }
+        });
+        assertTrue(latch.await(5, TimeUnit.SECONDS));
+        for (TestTimeout timeout: timeouts) {
+            assertEquals(1, timeout.expired.get());
+            assertThat(timeout.expiredNanos - timeout.scheduledNanos,
+                    greaterThanOrEqualTo(TimeUnit.MILLISECONDS.toNanos(timeout.delayMillis)));
+        }
+    }
+
+    @Test
+    public void testCancelAndReschedule() throws Exception {
+        CountDownLatch latch = new CountDownLatch(1);
+        TestTimeout cancelled = new TestTimeout(new CountDownLatch(1), 10);
+        TestTimeout rescheduled = new TestTimeout(latch, 50);
+        eventLoop.submit(() -> {
+            wheel.schedule(cancelled, TimeUnit.MILLISECONDS.toNanos(10));
+            wheel.schedule(rescheduled, TimeUnit.MILLISECONDS.toNanos(10));
+            assertTrue(cancelled.isScheduled());
+            wheel.cancel(cancelled);
+            assertFalse(cancelled.isScheduled());
+            // Move the deadline into the future.
+            rescheduled.scheduledNanos = System.nanoTime();
+            wheel.schedule(rescheduled, TimeUnit.MILLISECONDS.toNanos(50));
+        }).sync();
+        assertTrue(latch.await(5, TimeUnit.SECONDS));
+        assertEquals(0, cancelled.expired.get());
+        assertEquals(1, rescheduled.expired.get());
+        assertThat(rescheduled.expiredNanos - rescheduled.scheduledNanos,
+                greaterThanOrEqualTo(TimeUnit.MILLISECONDS.toNanos(50)));
+    }
+
+    @Test
+    public void testManyTimeoutsInSameTick() throws Exception {
+        int num = 10000;
+        CountDownLatch latch = new CountDownLatch(num);
+        eventLoop.execute(() -> {
+            for (int i = 0; i < num; i++) {
+                wheel.schedule(new TestTimeout(latch, 10), TimeUnit.MILLISECONDS.toNanos(10));
+            }
+        });
+        assertTrue(latch.await(5, TimeUnit.SECONDS));
+    }
+
+    @Test
+    public void testLongTimeoutsOnlyWakeUpWhenDue() throws Exception {
+        // Spread the deadlines over multiple blocks of the wheel so these end up in the second level first.
+        int num = 40;
+        CountDownLatch latch = new CountDownLatch(num);
+        List<TestTimeout> timeouts = new ArrayList<>();
+        eventLoop.submit(() -> {
+            for (int i = 0; i < num; i++) {
+                long delay = 1000 + i * 25;
+                TestTimeout timeout = new TestTimeout(latch, delay);
+                timeouts.add(timeout);
+                wheel.schedule(timeout, TimeUnit.MILLISECONDS.toNanos(delay));
+            }
+        }).sync();
+        assertTrue(latch.await(5, TimeUnit.SECONDS));
+        for (TestTimeout timeout: timeouts) {
+            assertEquals(1, timeout.expired.get());
+            assertThat(timeout.expiredNanos - timeout.scheduledNanos,
+                    greaterThanOrEqualTo(TimeUnit.MILLISECONDS.toNanos(timeout.delayMillis)));
+        }
+        // The driver should only be armed once for each deadline, and not for every non-empty bucket it passes.
+        assertThat(eventLoop.scheduled.get(), lessThanOrEqualTo(num + 1));
+    }
+
+    private static final class CountingEventLoop extends DefaultEventLoop {
+        final AtomicInteger scheduled = new AtomicInteger();
+
+        @Override
+        public ScheduledFuture<?> schedule(Runnable command, long delay, TimeUnit unit) {
+            scheduled.incrementAndGet();
+            return super.schedule(command, delay, unit);
+        }
+    }
+
+    private static final class TestTimeout extends QuicheQuicTimerWheel.Timeout {
+        final AtomicInteger expired = new AtomicInteger();
+        final CountDownLatch latch;
+        final long delayMillis;
+        volatile long scheduledNanos = System.nanoTime();
+        volatile long expiredNanos;
+
+        TestTimeout(CountDownLatch latch, long delayMillis) {
+            this.latch = latch;
+            this.delayMillis = delayMillis;
+        }
+
+        @Override
+        protected void expire() {
+            expiredNanos = System.nanoTime();
+            expired.incrementAndGet();
+            latch.countDown();
+        }
+    }
+}